@@ -1,6 +1,7 @@
 #version 450
 
-layout(binding = 3) uniform sampler2D textureSampler[2048];
+// shared by all frames, partially bound
+layout(set = 1, binding = 0) uniform sampler2D textureSampler[2048];
 
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec2 fragTexCoord;
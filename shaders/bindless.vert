@@ -11,10 +11,18 @@ layout(binding = 0) uniform UBOStatic {
 
 struct InstanceData
 {
-    mat4 model;
+    vec4 boundingSphere; // not used, for culling
     float transparency;
     int textureAlbedo;
     int drawCmdId; // not used
+    uint lodCount; // not used
+};
+
+// written by bindless_transform.comp
+struct InstanceMatrices
+{
+    mat4 model;
+    mat3 normal;
 };
 
 // alignment: 16 byte
@@ -27,6 +35,10 @@ layout(std430, binding = 2) readonly buffer InstanceIndexArray {
     int indices[];
 } instanceIndexArray;
 
+layout(std430, binding = 3) readonly buffer InstanceMatrixArray {
+    InstanceMatrices matrices[];
+} instanceMatrixArray;
+
 
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
@@ -61,13 +73,13 @@ void main() {
     //instanceIndex = 1;
     //glInstanceIdx = instanceIndexArray.indices[20]; // should be 1, got 0 from frag printing
 
-    mat4 model = instanceDataArray.data[instanceIndex].model;
+    mat4 model = instanceMatrixArray.matrices[instanceIndex].model;
 
     gl_Position = uboStatic.proj * uboStatic.view * model * vec4(inPosition, 1.0);
     fragColor = inColor;
     fragTexCoord = inTexCoord;
 
-    mat3 normalMatrix = transpose(inverse(mat3(model))); // Calculate the normal matrix
+    mat3 normalMatrix = instanceMatrixArray.matrices[instanceIndex].normal;
     fragNormal = normalize(normalMatrix * inNormal); // Transform the normal and pass it to the fragment shader
 
     fragPos = vec3(model * vec4(inPosition, 1.0)); // Transform the vertex position to world space
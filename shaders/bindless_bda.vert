@@ -0,0 +1,116 @@
+#version 450
+#extension GL_EXT_buffer_reference : require
+
+// bindless.vert, reaching the instance data, instance indices, instance
+// matrices and vertices through buffer device addresses pushed with every
+// pass instead of descriptors, so growing those buffers never touches a
+// descriptor set. The vertices are pulled from the vertex mega-buffer by
+// gl_VertexIndex, which includes the draw's vertex offset.
+
+// global UBO
+layout(binding = 0) uniform UBOStatic {
+    mat4 view;
+    mat4 proj;
+    float timeSinceStartSeconds; // time in seconds since engine start
+    float sinWave;               // a number interpolating between [0,1]
+    bool flip;                   // a switch that gets flipped every frame
+} uboStatic;
+
+struct InstanceData
+{
+    vec4 boundingSphere; // not used, for culling
+    float transparency;
+    int textureAlbedo;
+    int drawCmdId; // not used
+    uint lodCount; // not used
+};
+
+// written by bindless_transform.comp
+struct InstanceMatrices
+{
+    mat4 model;
+    mat3 normal;
+};
+
+// alignment: 16 byte
+layout(buffer_reference, std140, buffer_reference_align = 16) readonly buffer
+InstanceDataArray {
+    InstanceData data[];
+};
+
+// use 430 layout for 4-byte packed int array
+layout(buffer_reference, std430, buffer_reference_align = 4) readonly buffer
+InstanceIndexArray {
+    int indices[];
+};
+
+layout(buffer_reference, std430, buffer_reference_align = 16) readonly buffer
+InstanceMatrixArray {
+    InstanceMatrices matrices[];
+};
+
+// `Vertex` is tightly packed, 11 floats: pos, color, texCoord, normal
+const uint VERTEX_FLOATS = 11;
+layout(buffer_reference, std430, buffer_reference_align = 4) readonly buffer
+VertexArray {
+    float floats[];
+};
+
+layout(push_constant) uniform BufferAddresses {
+    InstanceDataArray instanceDataArray;
+    InstanceIndexArray instanceIndexArray;
+    InstanceMatrixArray instanceMatrixArray;
+    VertexArray vertexArray;
+} addresses;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) out vec3 fragNormal;
+layout(location = 3) out vec3 fragPos; // frag position in view space
+layout(location = 4) out vec3 fragGlobalLightPos; // light position in view space
+layout(location = 5) out int fragTexIndex; // texture index
+
+layout(location = 7) flat out int flip;
+
+layout(location=6) flat out int glInstanceIdx;
+
+vec3 globalLightPos = vec3(-6, -3, 0.0);
+
+vec3 readVec3(uint offset) {
+    return vec3(
+        addresses.vertexArray.floats[offset],
+        addresses.vertexArray.floats[offset + 1],
+        addresses.vertexArray.floats[offset + 2]
+    );
+}
+
+void main() {
+    flip = uboStatic.flip == true ? 1 : 0;
+    glInstanceIdx = gl_InstanceIndex;
+    int instanceIndex
+        = addresses.instanceIndexArray.indices[gl_InstanceIndex];
+
+    uint vertex = uint(gl_VertexIndex) * VERTEX_FLOATS;
+    vec3 inPosition = readVec3(vertex);
+    vec3 inColor = readVec3(vertex + 3);
+    vec2 inTexCoord = vec2(
+        addresses.vertexArray.floats[vertex + 6],
+        addresses.vertexArray.floats[vertex + 7]
+    );
+    vec3 inNormal = readVec3(vertex + 8);
+
+    InstanceMatrices matrices
+        = addresses.instanceMatrixArray.matrices[instanceIndex];
+    mat4 model = matrices.model;
+
+    gl_Position = uboStatic.proj * uboStatic.view * model * vec4(inPosition, 1.0);
+    fragColor = inColor;
+    fragTexCoord = inTexCoord;
+
+    fragNormal = normalize(matrices.normal * inNormal); // Transform the normal and pass it to the fragment shader
+
+    fragPos = vec3(model * vec4(inPosition, 1.0)); // Transform the vertex position to world space
+    fragGlobalLightPos = globalLightPos; // Pass the light position in world space to the fragment shader
+
+    fragTexIndex = addresses.instanceDataArray.data[instanceIndex].textureAlbedo;
+}
@@ -17,3 +17,4 @@
 /* glm */
 #include "glm/glm.hpp"
 #include "glm/ext/matrix_transform.hpp" // glm::rotate(), glm::translate()
+#include "glm/gtc/quaternion.hpp" // glm::quat, glm::angleAxis()
@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
@@ -150,8 +151,16 @@ void VulkanEngine::Init(const VulkanEngine::InitOptions& options) {
 #if __APPLE__
     MoltenVKConfig::Setup();
 #endif // __APPLE__
-    initGLFW(options);
-    { // Input Handling
+    _headless = options.headless;
+    _jobSystem.Init();
+    _deletionStack.push([this]() { _jobSystem.Cleanup(); });
+    if (_headless) {
+        // nothing to present, nothing to draw ImGui onto
+        _wantToDrawImGui = false;
+    } else {
+        initGLFW(options);
+    }
+    if (!_headless) { // Input Handling
         auto keyCallback
             = [](GLFWwindow* window, int key, int scancode, int action, int mods
               ) {
@@ -180,8 +189,14 @@ void VulkanEngine::Init(const VulkanEngine::InitOptions& options) {
     }
 
     INFO("Initializing Render Manager...");
-    glfwSetFramebufferSizeCallback(_window, this->framebufferResizeCallback);
+    if (!_headless) {
+        glfwSetFramebufferSizeCallback(
+            _window, this->framebufferResizeCallback
+        );
+    }
     this->initVulkan();
+    _gpuProfiler.Init(_device.get());
+    _deletionStack.push([this]() { _gpuProfiler.Cleanup(); });
     _textureManager.Init(_device);
     this->_deletionStack.push([this]() { _textureManager.Cleanup(); });
 
@@ -201,17 +216,19 @@ void VulkanEngine::Init(const VulkanEngine::InitOptions& options) {
         });
     }
     { // lab to mess around with ecs
-        this->_entityViewerSystem = new EntityViewerSystem();
-        this->_phongSystem = new PhongRenderSystem();
-        this->_phongSystemInstanced = new PhongRenderSystemInstanced();
-        this->_globalGridSystem = new GlobalGridSystem();
-        this->_bindessSystem = new BindlessRenderSystem();
+        // render systems' secondaries execute in the order they are added
+        _systemManager.AddSystem<EntityViewerSystem>("EntityViewer");
+        _systemManager.AddSystem<BindlessRenderSystem>("Bindless");
+        _systemManager.AddSystem<GlobalGridSystem>("GlobalGrid");
         InitContext initData;
         { // populate initData
             initData.device = this->_device.get();
             initData.textureManager = &_textureManager;
             initData.swapChainImageFormat = this->_swapChainImageFormat;
             initData.renderPass.mainPass = _mainRenderPass;
+            initData.jobSystem = &_jobSystem;
+            initData.depthPyramid
+                = _depthPyramid.IsSupported() ? &_depthPyramid : nullptr;
             for (int i = 0; i < _engineUBOStatic.size(); i++) {
                 initData.engineUBOStaticDescriptorBufferInfo[i].range
                     = sizeof(EngineUBOStatic);
@@ -221,20 +238,51 @@ void VulkanEngine::Init(const VulkanEngine::InitOptions& options) {
             }
         }
 
-        // _phongSystemInstanced->Init(&initData);
-        // _deletionStack.push([this]() {
-        // this->_phongSystemInstanced->Cleanup(); }
-        // );
-
-        // _phongSystem->Init(&initData);
-        // _deletionStack.push([this]() { this->_phongSystem->Cleanup(); });
-
-        _globalGridSystem->Init(&initData);
-        _deletionStack.push([this]() { this->_globalGridSystem->Cleanup(); });
-
-        _bindessSystem->Init(&initData);
-        _deletionStack.push([this]() { _bindessSystem->Cleanup(); });
+        _systemManager.Init(&initData);
+        _deletionStack.push([this]() { _systemManager.Cleanup(); });
+    }
+    _commandPools.Init(_device.get(), _jobSystem.GetNumThreads());
+    _deletionStack.push([this]() { _commandPools.Cleanup(); });
+    loadScene(options.scene);
+}
 
+void VulkanEngine::loadScene(const std::string& name) {
+    INFO("Loading scene \"{}\"...", name);
+    BindlessRenderSystem* bindless
+        = _systemManager.GetSystem<BindlessRenderSystem>();
+    EntityViewerSystem* entityViewer
+        = _systemManager.GetSystem<EntityViewerSystem>();
+    if (name == "empty") {
+        return;
+    } else if (name == "crowd") {
+        // bindless stress test: a field of cows, laid out on a grid
+        const int numCows = 5000;
+        const int rowSize = 100;
+        const float spacing = 2.f;
+        std::vector<BindlessRenderSystemComponent*> components
+            = bindless->MakeComponents(
+                "../resources/spot.obj", "../resources/spot.png", numCows
+            );
+        for (int i = 0; i < numCows; i++) {
+            Entity* cow = new Entity("Cow " + std::to_string(i));
+            TransformComponent* transform = new TransformComponent();
+            transform->position.x = (i % rowSize - rowSize / 2) * spacing;
+            transform->position.y = (i / rowSize) * spacing;
+            transform->rotation.z
+                = static_cast<float>(rand()) / RAND_MAX * 360;
+            cow->AddComponent(transform);
+            cow->AddComponent(components[i]);
+            components[i]->FlagUpdate();
+            bindless->AddEntity(cow);
+            entityViewer->AddEntity(cow);
+        }
+        return;
+    } else if (name != "default") {
+        FATAL(
+            "Unknown scene \"{}\"; available: default, crowd, empty", name
+        );
+    }
+    { // lab to mess around with ecs
         const bool phongMeshes = false;
         const bool bindless = true;
 
@@ -246,21 +294,23 @@ void VulkanEngine::Init(const VulkanEngine::InitOptions& options) {
                     = new TransformComponent();
                 spot->AddComponent(transformComponent);
                 transformComponent->position.z = 1;
-                _entityViewerSystem->AddEntity(spot);
+                entityViewer->AddEntity(spot);
                 // TODO: does this break the abstraction barrier?
-                auto component = _bindessSystem->MakeComponent(
+                auto component = bindless->MakeComponent(
                     "../resources/spot.obj", "../resources/spot.png"
                 );
                 spot->AddComponent(component);
                 component->FlagUpdate();
 
                 // cow stress test
+                std::vector<BindlessRenderSystemComponent*> cows
+                    = bindless->MakeComponents(
+                        "../resources/spot.obj", "../resources/spot.png", 40
+                    );
                 for (int i = 0; i < 40; i++) {
                     Entity* spot = new Entity("Spot " + std::to_string(i));
                     spot->AddComponent(new TransformComponent());
-                    spot->AddComponent(_bindessSystem->MakeComponent(
-                        "../resources/spot.obj", "../resources/spot.png"
-                    ));
+                    spot->AddComponent(cows[i]);
 
                     // Generate spherical coordinates
                     float radius = 10.0f;
@@ -283,10 +333,10 @@ void VulkanEngine::Init(const VulkanEngine::InitOptions& options) {
                     transform->rotation.y = phi * 1000;
                     spot->GetComponent<BindlessRenderSystemComponent>()
                         ->FlagUpdate();
-                    _bindessSystem->AddEntity(spot
+                    bindless->AddEntity(spot
                     ); // not really needed, which means we have a shitty
                        // abstraction
-                    _entityViewerSystem->AddEntity(spot);
+                    entityViewer->AddEntity(spot);
                 }
                 {
                     Entity* vikingRoom = new Entity("Viking Room");
@@ -294,9 +344,9 @@ void VulkanEngine::Init(const VulkanEngine::InitOptions& options) {
                         = new TransformComponent();
                     vikingRoom->AddComponent(transformComponent);
                     transformComponent->position.z = -1;
-                    _entityViewerSystem->AddEntity(vikingRoom);
+                    entityViewer->AddEntity(vikingRoom);
                     // TODO: does this break the abstraction barrier?
-                    auto component = _bindessSystem->MakeComponent(
+                    auto component = bindless->MakeComponent(
                         "../resources/viking_room.obj",
                         "../resources/viking_room.png"
                     );
@@ -305,36 +355,35 @@ void VulkanEngine::Init(const VulkanEngine::InitOptions& options) {
                 }
             }
 
-            if (phongMeshes) {
+            // null unless the phong systems are added to `_systemManager`
+            auto phongInstanced
+                = _systemManager.GetSystem<PhongRenderSystemInstanced>();
+            if (phongMeshes && phongInstanced) {
                 auto phongMeshComponent
-                    = _phongSystemInstanced
-                          ->MakePhongRenderSystemInstancedComponent(
-                              "../resources/spot.obj",
-                              "../resources/spot.png",
-                              10
-                          );
+                    = phongInstanced->MakePhongRenderSystemInstancedComponent(
+                        "../resources/spot.obj", "../resources/spot.png", 10
+                    );
                 TransformComponent* transformComponent
                     = new TransformComponent();
                 *transformComponent = TransformComponent::Identity();
                 entityInstanced->AddComponent(transformComponent);
                 entityInstanced->AddComponent(phongMeshComponent);
-                _phongSystemInstanced->AddEntity(entityInstanced);
-                _entityViewerSystem->AddEntity(entityInstanced);
+                phongInstanced->AddEntity(entityInstanced);
+                entityViewer->AddEntity(entityInstanced);
                 phongMeshComponent->FlagAsDirty(entityInstanced);
-                _phongSystemInstanced->AddEntity(entityInstanced2);
-                _entityViewerSystem->AddEntity(entityInstanced2);
+                phongInstanced->AddEntity(entityInstanced2);
+                entityViewer->AddEntity(entityInstanced2);
                 // let's go crazy
                 for (int i = 0; i < 10; i++) {
                     Entity* spot = new Entity("Spot");
                     spot->AddComponent(new TransformComponent());
                     spot->AddComponent(
-                        _phongSystemInstanced
-                            ->MakePhongRenderSystemInstancedComponent(
-                                "../resources/spot.obj",
-                                "../resources/spot.png",
-                                20 // give it a large hint so don't need to
-                                   // resize
-                            )
+                        phongInstanced->MakePhongRenderSystemInstancedComponent(
+                            "../resources/spot.obj",
+                            "../resources/spot.png",
+                            20 // give it a large hint so don't need to
+                               // resize
+                        )
                     );
                     // Generate spherical coordinates
                     float radius = 5.0f;
@@ -354,7 +403,7 @@ void VulkanEngine::Init(const VulkanEngine::InitOptions& options) {
                     spot->GetComponent<TransformComponent>()->position.z = z;
                     spot->GetComponent<PhongRenderSystemInstancedComponent>()
                         ->FlagAsDirty(spot);
-                    _phongSystemInstanced->AddEntity(spot);
+                    phongInstanced->AddEntity(spot);
                 }
             }
         }
@@ -362,12 +411,76 @@ void VulkanEngine::Init(const VulkanEngine::InitOptions& options) {
 }
 
 void VulkanEngine::Run() {
+    if (_headless) {
+        FATAL("Headless engine has no window to run until closed; use "
+              "RunFrames() instead.");
+    }
     while (!glfwWindowShouldClose(_window)) {
         glfwPollEvents();
         Tick();
     }
 }
 
+void VulkanEngine::RunFrames(unsigned int numFrames) {
+    using Clock = std::chrono::steady_clock;
+    std::vector<double> frameTimesMs;
+    frameTimesMs.reserve(numFrames);
+    Clock::time_point runBegin = Clock::now();
+    for (unsigned int i = 0; i < numFrames; i++) {
+        if (!_headless) {
+            if (glfwWindowShouldClose(_window)) {
+                break;
+            }
+            glfwPollEvents();
+        }
+        Clock::time_point tickBegin = Clock::now();
+        Tick();
+        frameTimesMs.push_back(
+            std::chrono::duration<double, std::milli>(Clock::now() - tickBegin)
+                .count()
+        );
+    }
+    // the last NUM_FRAME_IN_FLIGHT frames may still be executing
+    vkDeviceWaitIdle(_device->logicalDevice);
+    double totalMs = std::chrono::duration<double, std::milli>(
+                         Clock::now() - runBegin
+    )
+                         .count();
+
+    if (frameTimesMs.empty()) {
+        fmt::println("No frame was run.");
+        return;
+    }
+    std::vector<double> sorted = frameTimesMs;
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&sorted](double p) {
+        size_t idx = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+        return sorted[idx];
+    };
+    double sum = 0;
+    for (double ms : frameTimesMs) {
+        sum += ms;
+    }
+    double mean = sum / frameTimesMs.size();
+
+    fmt::println("---------- Frame Timing Summary ----------");
+    fmt::println("frames:     {}", frameTimesMs.size());
+    fmt::println("total:      {:.3f} ms", totalMs);
+    fmt::println("mean:       {:.3f} ms ({:.1f} fps)", mean, 1000.0 / mean);
+    fmt::println("min:        {:.3f} ms", sorted.front());
+    fmt::println("p50:        {:.3f} ms", percentile(0.50));
+    fmt::println("p95:        {:.3f} ms", percentile(0.95));
+    fmt::println("p99:        {:.3f} ms", percentile(0.99));
+    fmt::println("max:        {:.3f} ms", sorted.back());
+    if (!_lastProfilerCounters.empty()) {
+        fmt::println("last frame:");
+        for (const Profiler::Counter& counter : _lastProfilerCounters) {
+            fmt::println("  {}: {}", counter.name, counter.value);
+        }
+    }
+    fmt::println("------------------------------------------");
+}
+
 void VulkanEngine::Tick() {
     _deltaTimer.Tick();// tick deltaTimer regardless of pause,
                        // for correct _timeSinceStartSeconds
@@ -385,17 +498,29 @@ void VulkanEngine::Tick() {
             _inputManager.Tick(deltaTime);
             TickContext tickData{&_mainCamera, deltaTime};
             tickData.profiler = &_profiler;
+            tickData.gpuProfiler = &_gpuProfiler;
+            tickData.jobSystem = &_jobSystem;
             drawImGui();
+            // every resource indexed by `_currentFrame` may still be read by
+            // the GPU from NUM_FRAME_IN_FLIGHT ticks ago; block on that
+            // frame's fence only, so that recording this frame overlaps with
+            // the GPU executing the other frames in flight.
+            waitForFrame(_currentFrame);
             flushEngineUBOStatic(_currentFrame);
+            tickData.graphics.currentFrameInFlight = _currentFrame;
+            _systemManager.TickCompute(&tickData);
             drawFrame(&tickData, _currentFrame);
             _currentFrame = (_currentFrame + 1) % NUM_FRAME_IN_FLIGHT;
         }
-        {
-            PROFILE_SCOPE(&_profiler, "GPU");
-            vkDeviceWaitIdle(this->_device->logicalDevice);
+        { // one entry per named job that completed during the tick
+            PROFILE_SCOPE(&_profiler, "Jobs");
+            std::vector<Profiler::Entry> jobEntries;
+            _jobSystem.CollectProfile(jobEntries);
+            _profiler.Append(jobEntries);
         }
     }
     _lastProfilerData = _profiler.NewProfile();
+    _lastProfilerCounters = _profiler.NewCounters();
     _numTicks++;
 }
 
@@ -414,7 +539,7 @@ void VulkanEngine::createDevice() {
     VkPhysicalDevice physicalDevice = this->pickPhysicalDevice();
     this->_device = std::make_shared<VQDevice>(physicalDevice);
     this->_device->InitQueueFamilyIndices(this->_surface);
-    this->_device->CreateLogicalDeviceAndQueue(DEVICE_EXTENSIONS);
+    this->_device->CreateLogicalDeviceAndQueue(getDeviceExtensions());
     this->_device->CreateGraphicsCommandPool();
     this->_device->CreateGraphicsCommandBuffer(NUM_FRAME_IN_FLIGHT);
     this->_deletionStack.push([this]() { this->_device->Cleanup(); });
@@ -423,8 +548,23 @@ void VulkanEngine::createDevice() {
 void VulkanEngine::initVulkan() {
     INFO("Initializing Vulkan...");
     this->createInstance();
+    if (_headless) {
+        this->createDevice();
+        this->_depthPyramid.Init(_device.get());
+        this->_deletionStack.push([this]() { _depthPyramid.Cleanup(); });
+        this->createOffscreenTargets();
+        this->createImageViews();
+        this->createRenderPass();
+        this->createDepthBuffer();
+        this->createSynchronizationObjects();
+        this->createFramebuffers();
+        INFO("Vulkan initialized (headless).");
+        return;
+    }
     this->createSurface();
     this->createDevice();
+    this->_depthPyramid.Init(_device.get());
+    this->_deletionStack.push([this]() { _depthPyramid.Cleanup(); });
     this->initSwapChain();
     this->createImageViews();
     this->createRenderPass();
@@ -502,7 +642,7 @@ void VulkanEngine::createInstance() {
         DEFAULTS::Engine::ENGINE_VERSION.minor,
         DEFAULTS::Engine::ENGINE_VERSION.patch
     );
-    appInfo.apiVersion = VK_API_VERSION_1_0;
+    appInfo.apiVersion = VK_API_VERSION_1_2;
 
     INFO("Populating Vulkan instance create info...");
     // initialize and populate createInfo, which contains the application
@@ -513,7 +653,7 @@ void VulkanEngine::createInstance() {
 
     std::vector<const char*> instanceExtensions;
     // get glfw Extensions
-    {
+    if (!_headless) {
         uint32_t glfwExtensionCount = 0;
         const char** glfwExtensions
             = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
@@ -673,6 +813,13 @@ VulkanEngine::QueueFamilyIndices VulkanEngine::findQueueFamilies(
             indices.graphicsFamily = i;
             INFO("Graphics family found at {}", i);
         }
+        if (_headless) {
+            if (indices.graphicsFamily.has_value()) {
+                break;
+            }
+            i++;
+            continue;
+        }
         vkGetPhysicalDeviceSurfaceSupportKHR(
             device, i, this->_surface, &presentationSupport
         );
@@ -701,8 +848,9 @@ bool VulkanEngine::checkDeviceExtensionSupport(VkPhysicalDevice device) {
         device, nullptr, &extensionCount, availableExtensions.data()
     );
 
+    std::vector<const char*> deviceExtensions = getDeviceExtensions();
     std::set<std::string> requiredExtensions(
-        this->DEVICE_EXTENSIONS.begin(), this->DEVICE_EXTENSIONS.end()
+        deviceExtensions.begin(), deviceExtensions.end()
     );
 
     for (const auto& extension : availableExtensions) {
@@ -727,13 +875,18 @@ bool VulkanEngine::isDeviceSuitable(VkPhysicalDevice device) {
         deviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU
         && deviceFeatures.geometryShader && deviceFeatures.multiDrawIndirect;
 #endif // __APPLE__
+    if (_headless) {
+        // build & perf boxes may only have a software ICD(e.g. lavapipe)
+        // that reports itself as a CPU device.
+        platformRequirements = deviceFeatures.multiDrawIndirect;
+    }
 
     // check queue families
     if (platformRequirements) {
         QueueFamilyIndices indices
             = this->findQueueFamilies(device); // look for queue familieis
         return indices.graphicsFamily.has_value()
-               && indices.presentationFamily.has_value()
+               && (_headless || indices.presentationFamily.has_value())
                && checkDeviceExtensionSupport(device); // found graphics queue
     } else {
         return false;
@@ -793,7 +946,8 @@ void VulkanEngine::createSwapChain() {
     createInfo.imageArrayLayers = 1;
     createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
 
-    QueueFamilyIndices indices = findQueueFamilies(_device->physicalDevice);
+    // the families the device created its queues from
+    const ::QueueFamilyIndices& indices = _device->queueFamilyIndices;
     uint32_t queueFamilyIndices[]
         = {indices.graphicsFamily.value(), indices.presentationFamily.value()};
 
@@ -840,9 +994,10 @@ void VulkanEngine::createSwapChain() {
 
 void VulkanEngine::cleanupSwapChain() {
     INFO("Cleaning up swap chain...");
+    _depthPyramid.Destroy();
     vkDestroyImageView(_device->logicalDevice, _depthImageView, nullptr);
     vkDestroyImage(_device->logicalDevice, _depthImage, nullptr);
-    vkFreeMemory(_device->logicalDevice, _depthImageMemory, nullptr);
+    _device->allocator.Free(_depthImageMemory);
 
     _imguiManager.DestroyFrameBuffers(_device->logicalDevice);
     for (VkFramebuffer framebuffer : this->_swapChainData.frameBuffer) {
@@ -1000,6 +1155,69 @@ void VulkanEngine::createImageViews() {
     INFO("Image views created.");
 }
 
+void VulkanEngine::createOffscreenTargets() {
+    INFO("Creating offscreen render targets...");
+    _swapChainImageFormat = VulkanUtils::findBestFormat(
+        {VK_FORMAT_B8G8R8A8_SRGB, VK_FORMAT_R8G8B8A8_SRGB},
+        VK_IMAGE_TILING_OPTIMAL,
+        VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT,
+        _device->physicalDevice
+    );
+    _swapChainExtent = {
+        static_cast<uint32_t>(DEFAULTS::WINDOW_WIDTH),
+        static_cast<uint32_t>(DEFAULTS::WINDOW_HEIGHT)
+    };
+    _swapChainData.image.resize(NUM_FRAME_IN_FLIGHT);
+    _swapChainData.imageView.resize(NUM_FRAME_IN_FLIGHT);
+    _swapChainData.frameBuffer.resize(NUM_FRAME_IN_FLIGHT);
+    _offscreenImageMemory.resize(NUM_FRAME_IN_FLIGHT);
+    for (int i = 0; i < NUM_FRAME_IN_FLIGHT; i++) {
+        VulkanUtils::createImage(
+            _swapChainExtent.width,
+            _swapChainExtent.height,
+            _swapChainImageFormat,
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT
+                | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, // allow readbacks
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            _swapChainData.image[i],
+            _offscreenImageMemory[i],
+            *_device
+        );
+    }
+    this->_deletionStack.push([this]() { this->cleanupOffscreenTargets(); });
+}
+
+void VulkanEngine::cleanupOffscreenTargets() {
+    INFO("Cleaning up offscreen render targets...");
+    _depthPyramid.Destroy();
+    vkDestroyImageView(_device->logicalDevice, _depthImageView, nullptr);
+    vkDestroyImage(_device->logicalDevice, _depthImage, nullptr);
+    _device->allocator.Free(_depthImageMemory);
+    for (int i = 0; i < NUM_FRAME_IN_FLIGHT; i++) {
+        vkDestroyFramebuffer(
+            _device->logicalDevice, _swapChainData.frameBuffer[i], nullptr
+        );
+        vkDestroyImageView(
+            _device->logicalDevice, _swapChainData.imageView[i], nullptr
+        );
+        vkDestroyImage(_device->logicalDevice, _swapChainData.image[i], nullptr);
+        _device->allocator.Free(_offscreenImageMemory[i]);
+    }
+}
+
+std::vector<const char*> VulkanEngine::getDeviceExtensions() {
+    std::vector<const char*> extensions;
+    for (const char* extension : DEVICE_EXTENSIONS) {
+        if (_headless
+            && strcmp(extension, VK_KHR_SWAPCHAIN_EXTENSION_NAME) == 0) {
+            continue; // nothing to present to
+        }
+        extensions.push_back(extension);
+    }
+    return extensions;
+}
+
 void VulkanEngine::createSynchronizationObjects() {
     INFO("Creating synchronization objects...");
     ASSERT(_synchronizationPrimitives.size() == NUM_FRAME_IN_FLIGHT);
@@ -1058,6 +1276,9 @@ void VulkanEngine::createSynchronizationObjects() {
 
 void VulkanEngine::Cleanup() {
     INFO("Cleaning up...");
+    // frames may still be in flight, drain the device before tearing down
+    // resources they reference
+    vkDeviceWaitIdle(_device->logicalDevice);
     _deletionStack.flush();
     INFO("Resource cleaned up.");
 }
@@ -1089,7 +1310,8 @@ void VulkanEngine::createRenderPass() {
         = VulkanUtils::findDepthFormat(_device->physicalDevice);
     depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
     depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    // kept for the depth pyramid, and for `_mainRenderPassLoad`
+    depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
     depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -1148,6 +1370,34 @@ void VulkanEngine::createRenderPass() {
             this->_device->logicalDevice, this->_mainRenderPass, nullptr
         );
     });
+
+    // `_mainRenderPassLoad` only differs in load ops and initial layouts,
+    // which keeps it compatible with `_mainRenderPass`
+    attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+    attachments[0].initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+    attachments[1].initialLayout
+        = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    // wait for the attachment writes of the main render pass
+    dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+                               | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependency.dstAccessMask |= VK_ACCESS_COLOR_ATTACHMENT_READ_BIT
+                                | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+    if (vkCreateRenderPass(
+            _device->logicalDevice,
+            &renderPassInfo,
+            nullptr,
+            &this->_mainRenderPassLoad
+        )
+        != VK_SUCCESS) {
+        FATAL("Failed to create render pass!");
+    }
+
+    _deletionStack.push([this]() {
+        vkDestroyRenderPass(
+            this->_device->logicalDevice, this->_mainRenderPassLoad, nullptr
+        );
+    });
 }
 
 void VulkanEngine::createFramebuffers() {
@@ -1181,6 +1431,10 @@ void VulkanEngine::createFramebuffers() {
             FATAL("Failed to create framebuffer!");
         }
     }
+    if (_headless) {
+        INFO("Framebuffers created.");
+        return;
+    }
     _imguiManager.InitializeFrameBuffer(
         this->_swapChainData.image.size(),
         _device->logicalDevice,
@@ -1253,12 +1507,12 @@ void VulkanEngine::createDepthBuffer() {
         _swapChainExtent.height,
         depthFormat,
         VK_IMAGE_TILING_OPTIMAL,
-        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT
+            | VK_IMAGE_USAGE_SAMPLED_BIT, // read into `_depthPyramid`
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
         _depthImage,
         _depthImageMemory,
-        _device->physicalDevice,
-        _device->logicalDevice
+        *_device
     );
     _depthImageView = VulkanUtils::createImageView(
         _depthImage,
@@ -1266,6 +1520,9 @@ void VulkanEngine::createDepthBuffer() {
         depthFormat,
         VK_IMAGE_ASPECT_DEPTH_BIT
     );
+    _depthPyramid.Create(
+        _depthImage, _depthImageView, depthFormat, _swapChainExtent
+    );
 }
 
 void VulkanEngine::flushEngineUBOStatic(uint8_t frame) {
@@ -1281,32 +1538,106 @@ void VulkanEngine::flushEngineUBOStatic(uint8_t frame) {
     memcpy(buf.bufferAddress, &ubo, sizeof(ubo));
 }
 
-void VulkanEngine::drawFrame(TickContext* ctx, uint8_t frame) {
+void VulkanEngine::waitForFrame(uint8_t frame) {
     EngineSynchronizationPrimitives& sync = _synchronizationPrimitives[frame];
-
-    //  Wait for the previous frame to finish
-    PROFILE_SCOPE(&_profiler, "Render Tick");
+    PROFILE_SCOPE(&_profiler, "wait: fenceInFlight");
     vkWaitForFences(
         _device->logicalDevice, 1, &sync.fenceInFlight, VK_TRUE, UINT64_MAX
     );
+    // the frame's transient allocations have retired along with it
+    _device->frameAllocator.Reset(frame);
+}
+
+VkCommandBuffer VulkanEngine::recordMainPassSecondary(
+    const TickContext* ctx,
+    IRenderSystem* system,
+    uint32_t thread,
+    int gpuProfilerLevel,
+    bool late
+) {
+    int frame = ctx->graphics.currentFrameInFlight;
+    VkCommandBuffer secondary = _commandPools.GetSecondary(frame, thread);
+
+    VkCommandBufferInheritanceInfo inheritanceInfo{};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.renderPass = _mainRenderPass;
+    inheritanceInfo.subpass = 0;
+    inheritanceInfo.framebuffer = ctx->graphics.currentFB;
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT
+                      | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+    if (vkBeginCommandBuffer(secondary, &beginInfo) != VK_SUCCESS) {
+        FATAL("Failed to begin secondary command buffer!");
+    }
+
+    { // dynamic states are not inherited from the primary
+        VkExtent2D extend = ctx->graphics.currentFBextend;
+        VkViewport viewport{};
+        viewport.x = 0.0f;
+        viewport.y = 0.0f;
+        viewport.width = static_cast<float>(extend.width);
+        viewport.height = static_cast<float>(extend.height);
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+        vkCmdSetViewport(secondary, 0, 1, &viewport);
+
+        VkRect2D scissor{};
+        scissor.offset = {0, 0};
+        scissor.extent = extend;
+        vkCmdSetScissor(secondary, 0, 1, &scissor);
+    }
+
+    TickContext secondaryCtx = *ctx;
+    secondaryCtx.graphics.CB = secondary;
+    // GPU scopes of the secondary nest under the primary's open scopes
+    if (ctx->gpuProfiler) {
+        ctx->gpuProfiler->SetThreadLevel(gpuProfilerLevel);
+    }
+    if (late) {
+        system->TickLate(&secondaryCtx);
+    } else {
+        system->Tick(&secondaryCtx);
+    }
+
+    if (vkEndCommandBuffer(secondary) != VK_SUCCESS) {
+        FATAL("Failed to record secondary command buffer!");
+    }
+    return secondary;
+}
+
+void VulkanEngine::drawFrame(TickContext* ctx, uint8_t frame) {
+    EngineSynchronizationPrimitives& sync = _synchronizationPrimitives[frame];
+
+    // `waitForFrame(frame)` must have been called, the fence is signaled.
+    PROFILE_SCOPE(&_profiler, "Render Tick");
 
     //  Acquire an image from the swap chain
-    uint32_t imageIndex;
-    VkResult result = vkAcquireNextImageKHR(
-        this->_device->logicalDevice,
-        _swapChain,
-        UINT64_MAX,
-        sync.semaImageAvailable,
-        VK_NULL_HANDLE,
-        &imageIndex
-    );
-    [[unlikely]] if (result == VK_ERROR_OUT_OF_DATE_KHR
-                     || result == VK_SUBOPTIMAL_KHR) {
-        this->recreateSwapChain();
-        return;
-    } else [[unlikely]] if (result != VK_SUCCESS) {
-        const char* res = string_VkResult(result);
-        PANIC("Failed to acquire swap chain image: {}", res);
+    uint32_t imageIndex = frame; // headless: frame i owns offscreen image i
+    VkResult result = VK_SUCCESS;
+    if (!_headless) {
+        result = vkAcquireNextImageKHR(
+            this->_device->logicalDevice,
+            _swapChain,
+            UINT64_MAX,
+            sync.semaImageAvailable,
+            VK_NULL_HANDLE,
+            &imageIndex
+        );
+        // a suboptimal swapchain still hands out an image and signals
+        // `semaImageAvailable`, so render into it and recreate after
+        // presenting; bailing out here would leave the semaphore signaled
+        // with no waiter.
+        [[unlikely]] if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+            this->recreateSwapChain();
+            return; // fence is untouched and stays signaled
+        } else [[unlikely]] if (result != VK_SUCCESS
+                                && result != VK_SUBOPTIMAL_KHR) {
+            const char* res = string_VkResult(result);
+            PANIC("Failed to acquire swap chain image: {}", res);
+        }
     }
 
     // lock the fence
@@ -1325,6 +1656,10 @@ void VulkanEngine::drawFrame(TickContext* ctx, uint8_t frame) {
         getMainProjectionMatrix(ctx->graphics.mainProjectionMatrix);
     }
 
+    // the secondaries recorded for this frame slot's last submission have
+    // retired along with it
+    _commandPools.Reset(frame);
+
     { // begin command buffer
         VkCommandBufferBeginInfo beginInfo{};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -1332,12 +1667,31 @@ void VulkanEngine::drawFrame(TickContext* ctx, uint8_t frame) {
         beginInfo.pInheritanceInfo = nullptr; // Optional
         CB.begin(vk::CommandBufferBeginInfo());
     }
+    // read back timings of this frame slot's last submission, reset queries
+    _gpuProfiler.BeginFrame(frame, CB);
+    int gpuFrameScope = _gpuProfiler.Push(CB, "GPU Frame");
+    int gpuLevel = _gpuProfiler.GetThreadLevel();
+
+    // ImGui records into its own secondary command buffer on the job system
+    // while the render systems record theirs
+    VkCommandBuffer imguiSecondary = VK_NULL_HANDLE;
+    JobSystem::Counter imguiRecording;
+    if (!_headless) {
+        auto record = [&]() {
+            imguiSecondary = _commandPools.GetSecondary(
+                frame, _jobSystem.GetThreadIndex()
+            );
+            _imguiManager.RecordSecondaryCommandBuffer(imguiSecondary, ctx);
+        };
+        _jobSystem.Schedule("ImGui", record, &imguiRecording);
+    }
+
+    // work the render systems need done before the main render pass, such as
+    // culling
+    _systemManager.PrepareRender(ctx);
 
     { // main render pass
-        vk::Extent2D extend = vk::Extent2D(
-            _swapChainExtent.width * 0.5, _swapChainExtent.height * 0.5
-        );
-        extend = _swapChainExtent;
+        vk::Extent2D extend = _swapChainExtent;
         // the main render pass renders the actual graphics of the game.
         { // begin main render pass
             vk::Rect2D renderArea(VkOffset2D{0, 0}, extend);
@@ -1354,33 +1708,79 @@ void VulkanEngine::drawFrame(TickContext* ctx, uint8_t frame) {
             );
 
             CB.beginRenderPass(
-                renderPassBeginInfo, vk::SubpassContents::eInline
+                renderPassBeginInfo,
+                vk::SubpassContents::eSecondaryCommandBuffers
             );
         }
-        { // set viewport and scissor
-            VkViewport viewport{};
-            viewport.x = 0.0f;
-            viewport.y = 0.0f;
-            viewport.width = static_cast<float>(extend.width);
-            viewport.height = static_cast<float>(extend.height);
-            viewport.minDepth = 0.0f;
-            viewport.maxDepth = 1.0f;
-            vkCmdSetViewport(CB, 0, 1, &viewport);
-
-            VkRect2D scissor{};
-            scissor.offset = {0, 0};
-            scissor.extent = extend;
-            vkCmdSetScissor(CB, 0, 1, &scissor);
+        // every render system records into its own secondary command buffer
+        std::vector<VkCommandBuffer> secondaries(
+            _systemManager.GetNumRenderSystems()
+        );
+        auto record = [&](IRenderSystem* system,
+                          const TickContext* systemCtx,
+                          uint32_t order) {
+            secondaries[order] = recordMainPassSecondary(
+                systemCtx, system, _jobSystem.GetThreadIndex(), gpuLevel, false
+            );
+        };
+        _systemManager.TickRender(ctx, record);
+        // secondaries execute in the render phase's order
+        if (!secondaries.empty()) {
+            vkCmdExecuteCommands(CB, secondaries.size(), secondaries.data());
         }
-        // this->_phongSystem->Tick(ctx);
-        // this->_phongSystemInstanced->Tick(ctx);
-        this->_bindessSystem->Tick(ctx);
-        this->_globalGridSystem->Tick(ctx);
         CB.endRenderPass();
     }
 
-    _imguiManager.RecordCommandBuffer(ctx);
+    // two-phase occlusion culling: the late render systems draw what was
+    // hidden by nothing in the depth pyramid of the main render pass
+    if (_depthPyramid.IsSupported()
+        && _systemManager.GetNumLateRenderSystems() > 0) {
+        {
+            PROFILE_GPU_SCOPE(&_gpuProfiler, CB, "Depth Pyramid");
+            _depthPyramid.Build(CB);
+        }
+        _systemManager.PrepareRenderLate(ctx);
+
+        VkRenderPassBeginInfo renderPassBeginInfo{};
+        renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassBeginInfo.renderPass = _mainRenderPassLoad;
+        renderPassBeginInfo.framebuffer = FB;
+        renderPassBeginInfo.renderArea.offset = {0, 0};
+        renderPassBeginInfo.renderArea.extent = _swapChainExtent;
+        vkCmdBeginRenderPass(
+            CB,
+            &renderPassBeginInfo,
+            VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+        );
+        std::vector<VkCommandBuffer> secondaries(
+            _systemManager.GetNumLateRenderSystems()
+        );
+        auto record = [&](IRenderSystem* system,
+                          const TickContext* systemCtx,
+                          uint32_t order) {
+            secondaries[order] = recordMainPassSecondary(
+                systemCtx, system, _jobSystem.GetThreadIndex(), gpuLevel, true
+            );
+        };
+        _systemManager.TickRenderLate(ctx, record);
+        vkCmdExecuteCommands(CB, secondaries.size(), secondaries.data());
+        vkCmdEndRenderPass(CB);
+    }
 
+    if (!_headless) {
+        {
+            PROFILE_SCOPE(&_profiler, "wait: ImGui recording");
+            _jobSystem.Wait(&imguiRecording);
+        }
+        PROFILE_GPU_SCOPE(&_gpuProfiler, CB, "ImGui");
+        _imguiManager.BeginRenderPass(
+            ctx, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+        );
+        vkCmdExecuteCommands(CB, 1, &imguiSecondary);
+        vkCmdEndRenderPass(CB);
+    }
+
+    _gpuProfiler.Pop(CB, gpuFrameScope);
     // end command buffer
     CB.end();
 
@@ -1397,7 +1797,8 @@ void VulkanEngine::drawFrame(TickContext* ctx, uint8_t frame) {
     std::array<VkCommandBuffer, 1> submitCommandBuffers
         = {this->_device->graphicsCommandBuffers[frame]};
 
-    submitInfo.waitSemaphoreCount = 1;
+    // headless frames have no image to wait for, nor a present to signal
+    submitInfo.waitSemaphoreCount = _headless ? 0 : 1;
     submitInfo.pWaitSemaphores = waitSemaphores;
     submitInfo.pWaitDstStageMask = waitStages;
     submitInfo.commandBufferCount
@@ -1405,9 +1806,12 @@ void VulkanEngine::drawFrame(TickContext* ctx, uint8_t frame) {
     submitInfo.pCommandBuffers = submitCommandBuffers.data();
 
     VkSemaphore signalSemaphores[] = {sync.semaRenderFinished};
-    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.signalSemaphoreCount = _headless ? 0 : 1;
     submitInfo.pSignalSemaphores = signalSemaphores;
 
+    // uploads recorded since the last frame go first, the frame reads them
+    _device->uploadManager.Submit();
+
     {
         // wait time tend to be long if framerate is hardware-capped.
         PROFILE_SCOPE(&_profiler, "wait: vkAcquireNextImageKHR");
@@ -1422,6 +1826,10 @@ void VulkanEngine::drawFrame(TickContext* ctx, uint8_t frame) {
         }
     }
 
+    if (_headless) {
+        return;
+    }
+
     //  Present the swap chain image
     VkPresentInfoKHR presentInfo{};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -1510,7 +1918,7 @@ void VulkanEngine::drawImGui() {
     }
 
     ImGui::End(); // VulkanEngine
-    _entityViewerSystem->DrawImGui();
+    _systemManager.GetSystem<EntityViewerSystem>()->DrawImGui();
     _imguiManager.EndImGuiContext();
 }
 
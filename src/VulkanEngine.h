@@ -15,12 +15,14 @@
 
 // vq library
 #include "lib/VQBuffer.h"
+#include "lib/VQCommandPools.h"
 #include "lib/VQDevice.h"
 
 // structs
 #include "structs/SharedEngineStructs.h"
 
 // ecs systems
+#include "ecs/SystemManager.h"
 #include "ecs/system/EntityViewerSystem.h"
 #include "ecs/system/GlobalGridSystem.h"
 #include "ecs/system/PhongRenderSystem.h"
@@ -29,8 +31,11 @@
 // Engine Components
 #include "components/Camera.h"
 #include "components/DeltaTimer.h"
+#include "components/DepthPyramid.h"
 #include "components/ImGuiManager.h"
 #include "components/InputManager.h"
+#include "components/JobSystem.h"
+#include "components/GPUProfiler.h"
 #include "components/Profiler.h"
 #include "components/TextureManager.h"
 #include "components/imgui_widgets/ImGuiWidget.h"
@@ -46,6 +51,10 @@ class VulkanEngine
         bool manualMonitorSelection
             = false; // the user may select a monitor that's not the primary
                      // monitor through CLI
+        bool headless = false; // render into engine-owned offscreen images
+                               // instead of a window's swapchain; no GLFW
+                               // window, surface, input or ImGui is created
+        std::string scene = "default"; // scene to load, see `loadScene()`
     };
 
     // Engine-wide static UBO that gets updated every Tick()
@@ -61,7 +70,11 @@ class VulkanEngine
     };
 
     void Init(const InitOptions& options);
+    // tick until the window is closed
     void Run();
+    // tick exactly `numFrames` times, then print a frame timing summary.
+    // Works both windowed and headless.
+    void RunFrames(unsigned int numFrames);
     void Tick();
     void Cleanup();
 
@@ -89,6 +102,9 @@ class VulkanEngine
     void createRenderPass(); // create main render pass
     void createFramebuffers();
     void createSynchronizationObjects();
+    // populate the scene with entities, `name` is one of "default", "crowd",
+    // "empty"
+    void loadScene(const std::string& name);
 
     /* ---------- Physical Device Selection ---------- */
     QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device);
@@ -112,6 +128,15 @@ class VulkanEngine
     void createImageViews();
     void createDepthBuffer();
 
+    /* ---------- Headless ---------- */
+    // create NUM_FRAME_IN_FLIGHT offscreen color images in place of swapchain
+    // images, frame i always renders into image i.
+    void createOffscreenTargets();
+    void cleanupOffscreenTargets();
+
+    // device extensions required for the current mode
+    std::vector<const char*> getDeviceExtensions();
+
     // required device extensions
     static inline const std::vector<const char*> DEVICE_EXTENSIONS = {
         VK_KHR_SWAPCHAIN_EXTENSION_NAME,
@@ -153,7 +178,20 @@ class VulkanEngine
     void getMainProjectionMatrix(glm::mat4& projectionMatrix);
     void flushEngineUBOStatic(uint8_t frame);
     void drawImGui();
+    // block until the GPU retires the last submission of `frame`, after which
+    // all per-frame resources of `frame` can be safely written to
+    void waitForFrame(uint8_t frame);
     void drawFrame(TickContext* tickData, uint8_t frame);
+    // record `system`'s Tick, or TickLate if `late`, into a secondary
+    // command buffer that continues the main render pass, allocated from the
+    // recording slot of job system thread `thread`
+    VkCommandBuffer recordMainPassSecondary(
+        const TickContext* tickData,
+        IRenderSystem* system,
+        uint32_t thread,
+        int gpuProfilerLevel,
+        bool late
+    );
 
     // record command buffer to perform some example GPU
     // operations. currently not used anymore
@@ -164,9 +202,9 @@ class VulkanEngine
     );
 
     /* ---------- Top-level data ---------- */
-    GLFWwindow* _window;
+    GLFWwindow* _window = nullptr;
     VkInstance _instance;
-    VkSurfaceKHR _surface;
+    VkSurfaceKHR _surface = VK_NULL_HANDLE;
     VkDebugUtilsMessengerEXT _debugMessenger;
 
     /* ---------- swapchain ---------- */
@@ -180,6 +218,10 @@ class VulkanEngine
         std::vector<VkImage> image;
         std::vector<VkImageView> imageView;
     } _swapChainData; // each element corresponds to one image in the swap chain
+                      // or, when headless, to one offscreen color image
+
+    // backing memory of the offscreen color images, headless only
+    std::vector<VQAllocation> _offscreenImageMemory;
 
     /* ---------- Synchronization Primivites ---------- */
     struct EngineSynchronizationPrimitives
@@ -194,12 +236,21 @@ class VulkanEngine
 
     /* ---------- Depth Buffer ---------- */
     VkImage _depthImage;
-    VkDeviceMemory _depthImageMemory;
+    VQAllocation _depthImageMemory;
     VkImageView _depthImageView;
+    // hierarchical-Z of the depth buffer, for occlusion culling
+    DepthPyramid _depthPyramid;
 
     /* ---------- Render Passes ---------- */
-    // main render pass, and currently the only render pass
+    // main render pass, clears the framebuffer
     VkRenderPass _mainRenderPass = VK_NULL_HANDLE;
+    // the main render pass resumed after the depth pyramid is built, for late
+    // render systems; loads the framebuffer, and is compatible with
+    // `_mainRenderPass`
+    VkRenderPass _mainRenderPassLoad = VK_NULL_HANDLE;
+
+    // no window, surface or swapchain; see `InitOptions::headless`
+    bool _headless = false;
 
     /* ---------- Tick-dynamic Data ---------- */
     bool _framebufferResized = false;
@@ -223,12 +274,7 @@ class VulkanEngine
     unsigned long int _numTicks;  // how many ticks has happened so far
 
     /* ---------- Systems from ecs ---------- */
-    // TODO: SystemManager
-    PhongRenderSystem* _phongSystem;
-    PhongRenderSystemInstanced* _phongSystemInstanced;
-    GlobalGridSystem* _globalGridSystem;
-    EntityViewerSystem* _entityViewerSystem;
-    BindlessRenderSystem* _bindessSystem;
+    SystemManager _systemManager;
 
     /* ---------- Engine Components ---------- */
     DeletionStack _deletionStack;
@@ -240,6 +286,11 @@ class VulkanEngine
     Profiler _profiler;
     std::unique_ptr<std::vector<Profiler::Entry>> _lastProfilerData
         = _profiler.NewProfile();
+    std::vector<Profiler::Counter> _lastProfilerCounters;
+    GPUProfiler _gpuProfiler;
+    // secondary command buffers, one recording slot per job system thread
+    VQCommandPools _commandPools;
+    JobSystem _jobSystem;
 
     // ImGui widgets
     friend class ImGuiWidgetDeviceInfo;
@@ -0,0 +1,114 @@
+#include <algorithm>
+
+#include "BuddyAllocator.h"
+
+#include "components/Logging.h"
+
+BuddyAllocator::BuddyAllocator(uint32_t minBlockSize)
+    : _minBlockSize(minBlockSize) {
+    ASSERT(minBlockSize > 0 && (minBlockSize & (minBlockSize - 1)) == 0);
+}
+
+uint32_t BuddyAllocator::getOrder(uint32_t size) const {
+    uint32_t order = 0;
+    while ((_minBlockSize << order) < size) {
+        order++;
+    }
+    return order;
+}
+
+uint32_t BuddyAllocator::GetBlockSize(uint32_t size) const {
+    return _minBlockSize << getOrder(size);
+}
+
+uint32_t BuddyAllocator::Allocate(uint32_t size) {
+    const uint32_t order = getOrder(size);
+
+    // the smallest free block that fits
+    uint32_t freeOrder = order;
+    while (true) {
+        while (freeOrder < _freeBlocks.size()
+               && _freeBlocks[freeOrder].empty()) {
+            freeOrder++;
+        }
+        if (freeOrder < _freeBlocks.size()) {
+            break;
+        }
+        grow();
+        freeOrder = order;
+    }
+    auto it = _freeBlocks[freeOrder].begin();
+    const uint32_t offset = *it;
+    _freeBlocks[freeOrder].erase(it);
+
+    // split it down to the requested order, freeing the upper halves
+    while (freeOrder > order) {
+        freeOrder--;
+        _freeBlocks[freeOrder].insert(offset + (_minBlockSize << freeOrder));
+    }
+    return offset;
+}
+
+void BuddyAllocator::Free(uint32_t offset, uint32_t size) {
+    uint32_t order = getOrder(size);
+    ASSERT(offset % (_minBlockSize << order) == 0);
+    while (order + 1 < _freeBlocks.size()) {
+        const uint32_t buddy = offset ^ (_minBlockSize << order);
+        auto it = _freeBlocks[order].find(buddy);
+        if (it == _freeBlocks[order].end()) {
+            break;
+        }
+        _freeBlocks[order].erase(it);
+        offset = std::min(offset, buddy);
+        order++;
+    }
+    if (order + 1 == _freeBlocks.size()) {
+        // the whole range is free
+        _freeBlocks.clear();
+        _capacity = 0;
+        return;
+    }
+    _freeBlocks[order].insert(offset);
+
+    // give back the upper half of the range while it's free
+    while (_freeBlocks.size() > 1) {
+        const uint32_t halfOrder = _freeBlocks.size() - 2;
+        const uint32_t half = _capacity / 2;
+        auto it = _freeBlocks[halfOrder].find(half);
+        if (it == _freeBlocks[halfOrder].end()) {
+            break;
+        }
+        _freeBlocks[halfOrder].erase(it);
+        _freeBlocks.pop_back();
+        _capacity = half;
+    }
+}
+
+uint32_t BuddyAllocator::GetLargestFreeBlock() const {
+    for (uint32_t order = _freeBlocks.size(); order > 0; order--) {
+        if (!_freeBlocks[order - 1].empty()) {
+            return _minBlockSize << (order - 1);
+        }
+    }
+    return 0;
+}
+
+void BuddyAllocator::grow() {
+    if (_capacity == 0) {
+        _freeBlocks.emplace_back();
+        _freeBlocks[0].insert(0);
+        _capacity = _minBlockSize;
+        return;
+    }
+    // the new upper half is a free block of the old range's order, merged
+    // with the lower half if that's free too
+    const uint32_t rootOrder = _freeBlocks.size() - 1;
+    const uint32_t upperHalf = _capacity;
+    _freeBlocks.emplace_back();
+    _capacity *= 2;
+    if (_freeBlocks[rootOrder].erase(0) > 0) {
+        _freeBlocks[rootOrder + 1].insert(0);
+    } else {
+        _freeBlocks[rootOrder].insert(upperHalf);
+    }
+}
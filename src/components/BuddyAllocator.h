@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <set>
+#include <vector>
+
+// Buddy allocator of ranges within an array of elements, managing offsets
+// only. Blocks are `minBlockSize` times a power of two elements, aligned to
+// their size; freeing a block merges it with its buddy -- the other half of
+// the block they were split from -- while that's free as well.
+//
+// The managed range starts empty and doubles whenever a block doesn't fit,
+// and halves again once its upper half is free, so that it follows what is
+// allocated rather than the peak.
+class BuddyAllocator
+{
+  public:
+    // `minBlockSize` must be a power of two
+    explicit BuddyAllocator(uint32_t minBlockSize);
+
+    // offset of a free block of `GetBlockSize(size)` elements
+    uint32_t Allocate(uint32_t size);
+    // free the block at `offset`, allocated with `size`
+    void Free(uint32_t offset, uint32_t size);
+
+    // size of the block that `Allocate(size)` returns
+    uint32_t GetBlockSize(uint32_t size) const;
+    // # of elements the allocated blocks span, at most
+    uint32_t GetCapacity() const { return _capacity; }
+    // size of the largest free block within the capacity, 0 if there's none
+    uint32_t GetLargestFreeBlock() const;
+
+  private:
+    uint32_t getOrder(uint32_t size) const;
+    // double the managed range
+    void grow();
+
+    uint32_t _minBlockSize;
+    uint32_t _capacity = 0;
+    // offsets of the free blocks of each order, of `_minBlockSize << order`
+    // elements; the last order is the whole range's. Ordered, so that the
+    // lowest block is taken first and the top of the range frees up.
+    std::vector<std::set<uint32_t>> _freeBlocks;
+};
@@ -0,0 +1,436 @@
+#include "DepthPyramid.h"
+#include "components/ShaderUtils.h"
+#include "lib/VQDevice.h"
+
+namespace
+{
+uint32_t previousPow2(uint32_t value) {
+    uint32_t result = 1;
+    while (result * 2 <= value) {
+        result *= 2;
+    }
+    return result;
+}
+} // namespace
+
+void DepthPyramid::Init(VQDevice* device) {
+    _device = device;
+    _supported = device->enabledFeatures12.samplerFilterMinmax;
+    if (!_supported) {
+        WARN("samplerFilterMinmax is not supported, occlusion culling is "
+             "disabled.");
+        return;
+    }
+
+    { // _sampler
+        VkSamplerReductionModeCreateInfo reductionInfo{};
+        reductionInfo.sType
+            = VK_STRUCTURE_TYPE_SAMPLER_REDUCTION_MODE_CREATE_INFO;
+        // farthest depth, with VK_COMPARE_OP_LESS
+        reductionInfo.reductionMode = VK_SAMPLER_REDUCTION_MODE_MAX;
+
+        VkSamplerCreateInfo samplerInfo{};
+        samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerInfo.pNext = &reductionInfo;
+        // linear filtering of a max-reduction sampler takes the max of the
+        // 2x2 footprint
+        samplerInfo.magFilter = VK_FILTER_LINEAR;
+        samplerInfo.minFilter = VK_FILTER_LINEAR;
+        samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.minLod = 0.f;
+        samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+        if (vkCreateSampler(
+                _device->logicalDevice, &samplerInfo, nullptr, &_sampler
+            )
+            != VK_SUCCESS) {
+            FATAL("Failed to create depth pyramid sampler!");
+        }
+    }
+
+    { // _descriptorSetLayout
+        std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+        // the level below
+        bindings[0].binding = 0;
+        bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        bindings[0].descriptorCount = 1;
+        bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        // the level to write
+        bindings[1].binding = 1;
+        bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        bindings[1].descriptorCount = 1;
+        bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = bindings.size();
+        layoutInfo.pBindings = bindings.data();
+        if (vkCreateDescriptorSetLayout(
+                _device->logicalDevice,
+                &layoutInfo,
+                nullptr,
+                &_descriptorSetLayout
+            )
+            != VK_SUCCESS) {
+            FATAL("Failed to create depth pyramid descriptor set layout!");
+        }
+    }
+
+    { // _descriptorPool, reset whenever the pyramid is destroyed
+        VkDescriptorPoolSize poolSizes[]
+            = {{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MAX_LEVELS},
+               {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, MAX_LEVELS}};
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.poolSizeCount
+            = sizeof(poolSizes) / sizeof(VkDescriptorPoolSize);
+        poolInfo.pPoolSizes = poolSizes;
+        poolInfo.maxSets = MAX_LEVELS;
+        if (vkCreateDescriptorPool(
+                _device->logicalDevice, &poolInfo, nullptr, &_descriptorPool
+            )
+            != VK_SUCCESS) {
+            FATAL("Failed to create depth pyramid descriptor pool!");
+        }
+    }
+
+    { // _pipelineLayout, pushes the extent of the level to write
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(glm::vec2);
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType
+            = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &_descriptorSetLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        if (vkCreatePipelineLayout(
+                _device->logicalDevice,
+                &pipelineLayoutInfo,
+                nullptr,
+                &_pipelineLayout
+            )
+            != VK_SUCCESS) {
+            FATAL("Failed to create depth pyramid pipeline layout!");
+        }
+    }
+
+    { // _pipeline
+        VkShaderModule shaderModule = ShaderCreation::createShaderModule(
+            _device->logicalDevice, SHADER_SRC
+        );
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage.sType
+            = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineInfo.stage.module = shaderModule;
+        pipelineInfo.stage.pName = "main";
+        pipelineInfo.layout = _pipelineLayout;
+        if (vkCreateComputePipelines(
+                _device->logicalDevice,
+                VK_NULL_HANDLE,
+                1,
+                &pipelineInfo,
+                nullptr,
+                &_pipeline
+            )
+            != VK_SUCCESS) {
+            FATAL("Failed to create depth pyramid pipeline!");
+        }
+        vkDestroyShaderModule(_device->logicalDevice, shaderModule, nullptr);
+    }
+}
+
+void DepthPyramid::Cleanup() {
+    if (!_supported) {
+        return;
+    }
+    Destroy();
+    VkDevice device = _device->logicalDevice;
+    vkDestroyPipeline(device, _pipeline, nullptr);
+    vkDestroyPipelineLayout(device, _pipelineLayout, nullptr);
+    vkDestroyDescriptorPool(device, _descriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(device, _descriptorSetLayout, nullptr);
+    vkDestroySampler(device, _sampler, nullptr);
+}
+
+void DepthPyramid::Create(
+    VkImage depthImage,
+    VkImageView depthImageView,
+    VkFormat depthFormat,
+    VkExtent2D depthExtent
+) {
+    if (!_supported) {
+        return;
+    }
+    ASSERT(_image == VK_NULL_HANDLE);
+    _depthImage = depthImage;
+    _depthAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+    if (depthFormat == VK_FORMAT_D32_SFLOAT_S8_UINT
+        || depthFormat == VK_FORMAT_D24_UNORM_S8_UINT) {
+        // layout transitions must cover both aspects
+        _depthAspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
+    }
+
+    _extent.width = previousPow2(depthExtent.width);
+    _extent.height = previousPow2(depthExtent.height);
+    _numLevels = 1;
+    while ((std::max(_extent.width, _extent.height) >> _numLevels) > 0) {
+        _numLevels++;
+    }
+    ASSERT(_numLevels <= MAX_LEVELS);
+
+    { // _image
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = VK_FORMAT_R32_SFLOAT;
+        imageInfo.extent = {_extent.width, _extent.height, 1};
+        imageInfo.mipLevels = _numLevels;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage
+            = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        if (vkCreateImage(_device->logicalDevice, &imageInfo, nullptr, &_image)
+            != VK_SUCCESS) {
+            FATAL("Failed to create depth pyramid image!");
+        }
+
+        _imageMemory = _device->allocator.AllocateForImage(
+            _image, imageInfo.tiling, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+        );
+    }
+
+    // views of `levelCount` levels starting from `baseLevel`
+    auto createView = [this](uint32_t baseLevel, uint32_t levelCount) {
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = _image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = VK_FORMAT_R32_SFLOAT;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.baseMipLevel = baseLevel;
+        viewInfo.subresourceRange.levelCount = levelCount;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount = 1;
+        VkImageView view;
+        if (vkCreateImageView(_device->logicalDevice, &viewInfo, nullptr, &view)
+            != VK_SUCCESS) {
+            FATAL("Failed to create depth pyramid image view!");
+        }
+        return view;
+    };
+    _imageView = createView(0, _numLevels);
+    for (uint32_t level = 0; level < _numLevels; level++) {
+        _levelViews.push_back(createView(level, 1));
+    }
+
+    _descriptorSets.resize(_numLevels);
+    std::vector<VkDescriptorSetLayout> layouts(
+        _numLevels, _descriptorSetLayout
+    );
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = _descriptorPool;
+    allocInfo.descriptorSetCount = _numLevels;
+    allocInfo.pSetLayouts = layouts.data();
+    if (vkAllocateDescriptorSets(
+            _device->logicalDevice, &allocInfo, _descriptorSets.data()
+        )
+        != VK_SUCCESS) {
+        FATAL("Failed to allocate depth pyramid descriptor sets!");
+    }
+
+    for (uint32_t level = 0; level < _numLevels; level++) {
+        VkDescriptorImageInfo srcInfo{};
+        srcInfo.sampler = _sampler;
+        if (level == 0) {
+            srcInfo.imageView = depthImageView;
+            srcInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        } else {
+            srcInfo.imageView = _levelViews[level - 1];
+            srcInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+        }
+        VkDescriptorImageInfo dstInfo{};
+        dstInfo.imageView = _levelViews[level];
+        dstInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        std::array<VkWriteDescriptorSet, 2> descriptorWrites{};
+        descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[0].dstSet = _descriptorSets[level];
+        descriptorWrites[0].dstBinding = 0;
+        descriptorWrites[0].descriptorType
+            = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descriptorWrites[0].descriptorCount = 1;
+        descriptorWrites[0].pImageInfo = &srcInfo;
+        descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[1].dstSet = _descriptorSets[level];
+        descriptorWrites[1].dstBinding = 1;
+        descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        descriptorWrites[1].descriptorCount = 1;
+        descriptorWrites[1].pImageInfo = &dstInfo;
+        vkUpdateDescriptorSets(
+            _device->logicalDevice,
+            descriptorWrites.size(),
+            descriptorWrites.data(),
+            0,
+            nullptr
+        );
+    }
+}
+
+void DepthPyramid::Destroy() {
+    if (!_supported || _image == VK_NULL_HANDLE) {
+        return;
+    }
+    VkDevice device = _device->logicalDevice;
+    vkResetDescriptorPool(device, _descriptorPool, 0);
+    _descriptorSets.clear();
+    for (VkImageView view : _levelViews) {
+        vkDestroyImageView(device, view, nullptr);
+    }
+    _levelViews.clear();
+    vkDestroyImageView(device, _imageView, nullptr);
+    vkDestroyImage(device, _image, nullptr);
+    _device->allocator.Free(_imageMemory);
+    _imageView = VK_NULL_HANDLE;
+    _image = VK_NULL_HANDLE;
+}
+
+void DepthPyramid::Build(VkCommandBuffer CB) {
+    if (!_supported) {
+        return;
+    }
+    { // depth buffer -> sampled; pyramid -> writable, its contents discarded
+        std::array<VkImageMemoryBarrier, 2> barriers{};
+        barriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barriers[0].srcAccessMask
+            = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        barriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barriers[0].oldLayout
+            = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        barriers[0].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[0].image = _depthImage;
+        barriers[0].subresourceRange = {_depthAspect, 0, 1, 0, 1};
+
+        // the last frame's culling may still be reading the pyramid
+        barriers[1].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barriers[1].srcAccessMask = 0;
+        barriers[1].dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barriers[1].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barriers[1].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[1].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[1].image = _image;
+        barriers[1].subresourceRange
+            = {VK_IMAGE_ASPECT_COLOR_BIT, 0, _numLevels, 0, 1};
+
+        vkCmdPipelineBarrier(
+            CB,
+            VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT
+                | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            0,
+            nullptr,
+            0,
+            nullptr,
+            barriers.size(),
+            barriers.data()
+        );
+    }
+
+    vkCmdBindPipeline(CB, VK_PIPELINE_BIND_POINT_COMPUTE, _pipeline);
+    for (uint32_t level = 0; level < _numLevels; level++) {
+        uint32_t width = std::max(_extent.width >> level, 1u);
+        uint32_t height = std::max(_extent.height >> level, 1u);
+        glm::vec2 levelExtent(width, height);
+
+        vkCmdBindDescriptorSets(
+            CB,
+            VK_PIPELINE_BIND_POINT_COMPUTE,
+            _pipelineLayout,
+            0,
+            1,
+            &_descriptorSets[level],
+            0,
+            nullptr
+        );
+        vkCmdPushConstants(
+            CB,
+            _pipelineLayout,
+            VK_SHADER_STAGE_COMPUTE_BIT,
+            0,
+            sizeof(levelExtent),
+            &levelExtent
+        );
+        vkCmdDispatch(
+            CB,
+            (width + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE,
+            (height + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE,
+            1
+        );
+
+        // the next level, and the culling after the last, reads this one
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = _image;
+        barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1};
+        vkCmdPipelineBarrier(
+            CB,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            0,
+            nullptr,
+            0,
+            nullptr,
+            1,
+            &barrier
+        );
+    }
+
+    { // depth buffer -> attachment, for the rest of the main pass
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT
+                                | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = _depthImage;
+        barrier.subresourceRange = {_depthAspect, 0, 1, 0, 1};
+        vkCmdPipelineBarrier(
+            CB,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT
+                | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+            0,
+            0,
+            nullptr,
+            0,
+            nullptr,
+            1,
+            &barrier
+        );
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "lib/VQAllocator.h"
+
+class VQDevice;
+
+// Hierarchical-Z buffer of the main pass' depth buffer: a mip chain in which
+// every texel holds the farthest depth of the texels it covers in the level
+// below, so that a single sample tells whether a screen-space rect is
+// entirely behind what has been drawn.
+//
+// Level 0 is the depth buffer's extent rounded down to powers of 2. Levels are
+// reduced with a max-reduction sampler, which requires the
+// `samplerFilterMinmax` feature; without it the pyramid is unsupported and
+// occlusion culling is disabled.
+class DepthPyramid
+{
+  public:
+    void Init(VQDevice* device);
+    void Cleanup();
+
+    // (Re)create the pyramid for a depth buffer, which must have been created
+    // with `VK_IMAGE_USAGE_SAMPLED_BIT`. Call `Destroy()` before re-creating.
+    void Create(
+        VkImage depthImage,
+        VkImageView depthImageView,
+        VkFormat depthFormat,
+        VkExtent2D depthExtent
+    );
+    void Destroy();
+
+    // Reduce the depth buffer into the pyramid.
+    // Must be recorded outside of any render pass, after the depth buffer has
+    // been written in `VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL`, to
+    // which it is transitioned back. The pyramid is left in
+    // `VK_IMAGE_LAYOUT_GENERAL`, readable by compute shaders.
+    void Build(VkCommandBuffer CB);
+
+    bool IsSupported() const { return _supported; }
+
+    // all levels of the pyramid, changes when the pyramid is re-created
+    VkImageView GetImageView() const { return _imageView; }
+
+    // max-reduction sampler that pyramid reads should use
+    VkSampler GetSampler() const { return _sampler; }
+
+  private:
+    const char* SHADER_SRC = "../shaders/depth_pyramid.comp.spv";
+    static const uint32_t MAX_LEVELS = 16;
+    static const uint32_t WORKGROUP_SIZE = 8; // in each dimension
+
+    VQDevice* _device = nullptr;
+    bool _supported = false;
+
+    VkSampler _sampler = VK_NULL_HANDLE;
+    VkDescriptorSetLayout _descriptorSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool _descriptorPool = VK_NULL_HANDLE;
+    VkPipelineLayout _pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline _pipeline = VK_NULL_HANDLE;
+
+    VkImage _depthImage = VK_NULL_HANDLE;
+    VkImageAspectFlags _depthAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+
+    VkImage _image = VK_NULL_HANDLE;
+    VQAllocation _imageMemory;
+    VkImageView _imageView = VK_NULL_HANDLE;
+    VkExtent2D _extent = {0, 0}; // of level 0
+    uint32_t _numLevels = 0;
+
+    // per level: a storage view to write it, and the set that reads the level
+    // below(the depth buffer for level 0) into it
+    std::vector<VkImageView> _levelViews;
+    std::vector<VkDescriptorSet> _descriptorSets;
+};
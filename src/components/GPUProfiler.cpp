@@ -0,0 +1,124 @@
+#include "GPUProfiler.h"
+#include "lib/VQDevice.h"
+
+namespace
+{
+// nesting depth of the scopes open on the calling thread
+thread_local int currEntryLevel = 0;
+} // namespace
+
+void GPUProfiler::Init(VQDevice* device) {
+    _device = device;
+    uint32_t graphicsFamily
+        = device->queueFamilyIndices.graphicsFamily.value();
+    uint32_t validBits
+        = device->queueFamilyProperties[graphicsFamily].timestampValidBits;
+    _supported = validBits != 0
+                 && device->properties.limits.timestampPeriod > 0;
+    if (!_supported) {
+        WARN("GPU timestamps are not supported, GPU profiling is disabled.");
+        return;
+    }
+    _timestampPeriod = device->properties.limits.timestampPeriod;
+    _timestampMask = validBits >= 64 ? ~0ull : ((1ull << validBits) - 1);
+
+    for (FrameData& frame : _frames) {
+        VkQueryPoolCreateInfo queryPoolInfo{};
+        queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolInfo.queryCount = MAX_SCOPES_PER_FRAME * 2;
+        if (vkCreateQueryPool(
+                _device->logicalDevice,
+                &queryPoolInfo,
+                nullptr,
+                &frame.queryPool
+            )
+            != VK_SUCCESS) {
+            FATAL("Failed to create timestamp query pool!");
+        }
+        frame.scopes.reserve(MAX_SCOPES_PER_FRAME);
+    }
+}
+
+void GPUProfiler::Cleanup() {
+    for (FrameData& frame : _frames) {
+        if (frame.queryPool != VK_NULL_HANDLE) {
+            vkDestroyQueryPool(_device->logicalDevice, frame.queryPool, nullptr);
+            frame.queryPool = VK_NULL_HANDLE;
+        }
+    }
+}
+
+void GPUProfiler::BeginFrame(int frame, VkCommandBuffer CB) {
+    if (!_supported) {
+        return;
+    }
+    _currentFrame = frame;
+    FrameData& data = _frames[frame];
+
+    // the frame's fence has signaled, all its queries are available
+    if (!data.scopes.empty()) {
+        std::array<uint64_t, MAX_SCOPES_PER_FRAME * 2> timestamps;
+        VkResult result = vkGetQueryPoolResults(
+            _device->logicalDevice,
+            data.queryPool,
+            0,
+            data.scopes.size() * 2,
+            sizeof(timestamps),
+            timestamps.data(),
+            sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT
+        );
+        if (result == VK_SUCCESS) {
+            _lastProfile.clear();
+            for (size_t i = 0; i < data.scopes.size(); i++) {
+                uint64_t begin = timestamps[i * 2] & _timestampMask;
+                uint64_t end = timestamps[i * 2 + 1] & _timestampMask;
+                double ns = (end - begin) * static_cast<double>(_timestampPeriod);
+                _lastProfile.push_back(
+                    {data.scopes[i].first, ns / 1e6, data.scopes[i].second}
+                );
+            }
+        }
+        data.scopes.clear();
+    }
+
+    vkCmdResetQueryPool(CB, data.queryPool, 0, MAX_SCOPES_PER_FRAME * 2);
+}
+
+int GPUProfiler::Push(VkCommandBuffer CB, const char* name) {
+    if (!_supported) {
+        return -1;
+    }
+    FrameData& data = _frames[_currentFrame];
+    int entryId;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (data.scopes.size() >= MAX_SCOPES_PER_FRAME) {
+            return -1;
+        }
+        entryId = data.scopes.size();
+        data.scopes.push_back({name, currEntryLevel});
+    }
+    // each scope owns its query pair, writing them needs no lock
+    vkCmdWriteTimestamp(
+        CB, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, data.queryPool, entryId * 2
+    );
+    currEntryLevel++;
+    return entryId;
+}
+
+void GPUProfiler::Pop(VkCommandBuffer CB, int entryId) {
+    if (entryId < 0) {
+        return;
+    }
+    FrameData& data = _frames[_currentFrame];
+    vkCmdWriteTimestamp(
+        CB, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, data.queryPool, entryId * 2 + 1
+    );
+    currEntryLevel--;
+}
+
+int GPUProfiler::GetThreadLevel() const { return currEntryLevel; }
+
+void GPUProfiler::SetThreadLevel(int level) { currEntryLevel = level; }
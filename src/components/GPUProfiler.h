@@ -0,0 +1,102 @@
+#pragma once
+#include <mutex>
+#include <vulkan/vulkan_core.h>
+
+#include "Profiler.h"
+
+class VQDevice;
+
+// GPU counterpart of `Profiler`. Scopes record a pair of `vkCmdWriteTimestamp`
+// into a query pool owned by the frame in flight; the results of a frame are
+// read back the next time the same frame slot is recorded --
+// NUM_FRAME_IN_FLIGHT frames later, after its fence has been waited on -- so
+// reading them back never stalls.
+class GPUProfiler
+{
+  public:
+    struct Profiling
+    {
+        GPUProfiler* parent;
+        VkCommandBuffer CB;
+        int id;
+        Profiling() = delete;
+
+        Profiling(GPUProfiler* parent, VkCommandBuffer CB, const char* name)
+            : parent(parent), CB(CB) {
+            id = parent ? parent->Push(CB, name) : -1;
+        }
+
+        ~Profiling() {
+            if (parent) {
+                parent->Pop(CB, id);
+            }
+        }
+    };
+
+    struct Entry
+    {
+        const char* name;
+        double ms; // GPU time between the scope's begin and end
+        int level;
+    };
+
+    void Init(VQDevice* device);
+    void Cleanup();
+
+    // Read back the timings `frame` recorded NUM_FRAME_IN_FLIGHT frames ago
+    // and reset its query pool on `CB`.
+    // Must be called after the frame's fence has been waited on, outside of
+    // any render pass, before any scope is pushed for the frame.
+    void BeginFrame(int frame, VkCommandBuffer CB);
+
+    // returns an id to be passed into `Pop()`, or -1 if the scope is not
+    // recorded(timestamps unsupported, or out of queries).
+    // Thread-safe, so scopes may be recorded into secondary command buffers on
+    // worker threads; a scope's level is its nesting depth on the recording
+    // thread.
+    int Push(VkCommandBuffer CB, const char* name);
+    void Pop(VkCommandBuffer CB, int entryId);
+
+    // nesting depth of the scopes currently open on the calling thread
+    int GetThreadLevel() const;
+    // Nest the calling thread's subsequent scopes `level` deep. A worker
+    // recording a secondary command buffer passes the depth at which the
+    // primary executes it.
+    void SetThreadLevel(int level);
+
+    // entries of the most recently read back frame
+    const std::vector<Entry>& GetLastProfile() const { return _lastProfile; }
+
+    bool IsSupported() const { return _supported; }
+
+  private:
+    // each scope consumes 2 queries
+    static const uint32_t MAX_SCOPES_PER_FRAME = 64;
+
+    struct FrameData
+    {
+        VkQueryPool queryPool = VK_NULL_HANDLE;
+        // <name, level> of each scope recorded into the pool
+        std::vector<std::pair<const char*, int>> scopes;
+    };
+
+    VQDevice* _device = nullptr;
+    bool _supported = false;
+    float _timestampPeriod = 1.f; // nanoseconds per timestamp tick
+    uint64_t _timestampMask = ~0ull;
+
+    std::mutex _mutex; // guards `_frames[_currentFrame].scopes`
+    std::array<FrameData, NUM_FRAME_IN_FLIGHT> _frames;
+    int _currentFrame = 0;
+
+    std::vector<Entry> _lastProfile;
+};
+
+// profiler macros
+
+#ifdef USE_PROFILER
+#define PROFILE_GPU_SCOPE(profiler, cb, name)                                  \
+    const auto __gpuProfiling = GPUProfiler::Profiling(profiler, cb, name);
+#else
+#define PROFILE_GPU_SCOPE(profiler, cb, name) (0)
+#endif
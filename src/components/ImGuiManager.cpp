@@ -238,23 +238,27 @@ void ImGuiManager::Cleanup(VkDevice logicalDevice) {
     vkDestroyDescriptorPool(logicalDevice, _imguiDescriptorPool, nullptr);
 }
 
-void ImGuiManager::RecordCommandBuffer(const TickContext* tickData) {
-    auto CB = tickData->graphics.CB;
-    auto FB = tickData->graphics.currentFB;
-    auto extent = tickData->graphics.currentFBextend;
-
-    // start render pass
+void ImGuiManager::BeginRenderPass(
+    const TickContext* tickData,
+    VkSubpassContents contents
+) {
     VkRenderPassBeginInfo renderPassInfo{};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
     renderPassInfo.renderPass = _imGuiRenderPass;
     renderPassInfo.framebuffer
         = _imGuiFramebuffers[tickData->graphics.currentSwapchainImageIndex];
-    renderPassInfo.renderArea.extent = extent;
+    renderPassInfo.renderArea.extent = tickData->graphics.currentFBextend;
     renderPassInfo.renderArea.offset = {0, 0};
     renderPassInfo.clearValueCount = 0;
     renderPassInfo.pClearValues = nullptr;
 
-    vkCmdBeginRenderPass(CB, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBeginRenderPass(tickData->graphics.CB, &renderPassInfo, contents);
+}
+
+void ImGuiManager::RecordCommandBuffer(const TickContext* tickData) {
+    auto CB = tickData->graphics.CB;
+
+    BeginRenderPass(tickData, VK_SUBPASS_CONTENTS_INLINE);
 
     ImDrawData* drawData = ImGui::GetDrawData();
     if (drawData == nullptr) {
@@ -265,6 +269,38 @@ void ImGuiManager::RecordCommandBuffer(const TickContext* tickData) {
     vkCmdEndRenderPass(CB);
 }
 
+void ImGuiManager::RecordSecondaryCommandBuffer(
+    VkCommandBuffer secondary,
+    const TickContext* tickData
+) {
+    VkCommandBufferInheritanceInfo inheritanceInfo{};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.renderPass = _imGuiRenderPass;
+    inheritanceInfo.subpass = 0;
+    inheritanceInfo.framebuffer
+        = _imGuiFramebuffers[tickData->graphics.currentSwapchainImageIndex];
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT
+                      | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+    if (vkBeginCommandBuffer(secondary, &beginInfo) != VK_SUCCESS) {
+        FATAL("Failed to begin ImGui secondary command buffer!");
+    }
+
+    ImDrawData* drawData = ImGui::GetDrawData();
+    if (drawData == nullptr) {
+        FATAL("Draw data is null!");
+    }
+    // the backend sets its own viewport and scissor
+    ImGui_ImplVulkan_RenderDrawData(drawData, secondary);
+
+    if (vkEndCommandBuffer(secondary) != VK_SUCCESS) {
+        FATAL("Failed to record ImGui secondary command buffer!");
+    }
+}
+
 void ImGuiManager::BeginImGuiContext() {
     ImGui_ImplVulkan_NewFrame();
     ImGui_ImplGlfw_NewFrame();
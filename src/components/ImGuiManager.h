@@ -57,6 +57,21 @@ class ImGuiManager
     // Push all recorded ImGui UI elements onto the CB.
     void RecordCommandBuffer(const TickContext* tickData);
 
+    // Record all ImGui UI elements into `secondary`, to be executed within the
+    // render pass begun by `BeginRenderPass(tickData,
+    // VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS)`. Safe to call from a
+    // worker thread once `EndImGuiContext()` has returned.
+    void RecordSecondaryCommandBuffer(
+        VkCommandBuffer secondary,
+        const TickContext* tickData
+    );
+
+    // Begin the ImGui render pass on `tickData->graphics.CB`.
+    void BeginRenderPass(
+        const TickContext* tickData,
+        VkSubpassContents contents
+    );
+
     void Cleanup(VkDevice logicalDevice);
 
   private:
@@ -0,0 +1,181 @@
+#include "JobSystem.h"
+
+namespace
+{
+// index of the calling thread into `JobSystem::_threads`
+thread_local uint32_t threadIndex = 0;
+// job running on the calling thread, parent of the jobs it schedules
+thread_local void* currentJob = nullptr;
+} // namespace
+
+void JobSystem::Init(uint32_t numWorkers) {
+    if (numWorkers == 0) {
+        uint32_t hardwareThreads = std::thread::hardware_concurrency();
+        numWorkers = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+    INFO("Initializing job system with {} workers...", numWorkers);
+    _running = true;
+    for (uint32_t i = 0; i < numWorkers + 1; i++) {
+        _threads.push_back(std::make_unique<ThreadData>());
+    }
+    for (uint32_t i = 1; i < numWorkers + 1; i++) {
+        _workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+void JobSystem::Cleanup() {
+    ASSERT(_numQueuedJobs == 0);
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        _running = false;
+    }
+    _sleepCondition.notify_all();
+    for (std::thread& worker : _workers) {
+        worker.join();
+    }
+    _workers.clear();
+    _threads.clear();
+}
+
+uint32_t JobSystem::GetThreadIndex() const { return threadIndex; }
+
+void JobSystem::Schedule(
+    const char* name,
+    JobFunction function,
+    Counter* counter
+) {
+    Job* job = new Job{name, std::move(function), counter, nullptr, 1};
+    job->parent = static_cast<Job*>(currentJob);
+    if (job->parent) {
+        job->parent->unfinished++;
+    }
+    if (counter) {
+        counter->_pending++;
+    }
+
+    {
+        // counted before it's visible to thieves, so the count never drops
+        // below zero; taking the lock pairs with the predicate check of
+        // sleeping workers, so that a worker can't miss the notification
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        _numQueuedJobs++;
+    }
+    ThreadData& thread = *_threads[threadIndex];
+    {
+        std::lock_guard<std::mutex> lock(thread.mutex);
+        thread.jobs.push_back(job);
+    }
+    _sleepCondition.notify_one();
+}
+
+void JobSystem::Wait(const Counter* counter) {
+    while (!counter->IsDone()) {
+        Job* job = findJob(threadIndex);
+        if (job) {
+            run(job, threadIndex);
+        } else {
+            // the remaining jobs are running on other threads
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::ParallelFor(
+    const char* name,
+    uint32_t count,
+    uint32_t batchSize,
+    const std::function<void(uint32_t begin, uint32_t end)>& fn
+) {
+    ASSERT(batchSize > 0);
+    Counter counter;
+    for (uint32_t begin = 0; begin < count; begin += batchSize) {
+        uint32_t end = std::min(begin + batchSize, count);
+        Schedule(name, [&fn, begin, end]() { fn(begin, end); }, &counter);
+    }
+    Wait(&counter);
+}
+
+void JobSystem::CollectProfile(std::vector<Profiler::Entry>& entries) {
+    for (auto& thread : _threads) {
+        std::lock_guard<std::mutex> lock(thread->mutex);
+        entries.insert(
+            entries.end(), thread->profile.begin(), thread->profile.end()
+        );
+        thread->profile.clear();
+    }
+}
+
+void JobSystem::workerLoop(uint32_t index) {
+    threadIndex = index;
+    while (true) {
+        Job* job = findJob(index);
+        if (job) {
+            run(job, index);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(_sleepMutex);
+        _sleepCondition.wait(lock, [this]() {
+            return _numQueuedJobs > 0 || !_running;
+        });
+        if (!_running) {
+            return;
+        }
+    }
+}
+
+JobSystem::Job* JobSystem::findJob(uint32_t index) {
+    { // LIFO on the own deque, the most recent job is the most cache-warm
+        ThreadData& thread = *_threads[index];
+        std::lock_guard<std::mutex> lock(thread.mutex);
+        if (!thread.jobs.empty()) {
+            Job* job = thread.jobs.back();
+            thread.jobs.pop_back();
+            _numQueuedJobs--;
+            return job;
+        }
+    }
+    // FIFO steal, the oldest job tends to be the largest chunk of work
+    for (uint32_t i = 1; i < _threads.size(); i++) {
+        ThreadData& victim = *_threads[(index + i) % _threads.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty()) {
+            Job* job = victim.jobs.front();
+            victim.jobs.pop_front();
+            _numQueuedJobs--;
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+void JobSystem::run(Job* job, uint32_t index) {
+    void* parentJob = currentJob;
+    currentJob = job;
+    Profiler::Entry entry{job->name};
+    entry.begin = std::chrono::high_resolution_clock::now();
+
+    job->function();
+
+    entry.end = std::chrono::high_resolution_clock::now();
+    entry.level = 0;
+    currentJob = parentJob;
+    if (job->name) {
+        ThreadData& thread = *_threads[index];
+        std::lock_guard<std::mutex> lock(thread.mutex);
+        thread.profile.push_back(entry);
+    }
+    finish(job);
+}
+
+void JobSystem::finish(Job* job) {
+    if (--job->unfinished > 0) {
+        return; // children still running, the last one finishes the job
+    }
+    if (job->counter) {
+        job->counter->_pending--;
+    }
+    if (job->parent) {
+        finish(job->parent);
+    }
+    delete job;
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "Profiler.h"
+
+// Work-stealing job scheduler, the engine's task runtime.
+//
+// Every thread -- the N workers plus the thread that called `Init()`, which
+// is thread 0 -- owns a deque of jobs. A thread pushes and pops jobs at the
+// back of its own deque, and steals from the front of the others' deques when
+// its own runs dry. Waiting on a counter runs jobs instead of blocking, so
+// jobs may themselves schedule jobs and wait on them.
+//
+// Jobs scheduled from within a running job become its children: the parent
+// only completes, and releases its counter, once all its children completed.
+class JobSystem
+{
+  public:
+    using JobFunction = std::function<void()>;
+
+    // Number of incomplete jobs that were scheduled with it; wait for it to
+    // drop to zero with `Wait()`. A counter can be reused once done.
+    class Counter
+    {
+      public:
+        bool IsDone() const { return _pending.load() == 0; }
+
+      private:
+        friend class JobSystem;
+        std::atomic<uint32_t> _pending = 0;
+    };
+
+    // spawn `numWorkers` worker threads, 0 picks one per spare hardware
+    // thread
+    void Init(uint32_t numWorkers = 0);
+
+    // join all workers, no job may be pending
+    void Cleanup();
+
+    // Run `job` on any thread. `counter`, if any, counts the job as pending
+    // until the job and all its children completed. Each job named with a
+    // non-null `name` gets profiled, see `CollectProfile()`.
+    void Schedule(
+        const char* name,
+        JobFunction job,
+        Counter* counter = nullptr
+    );
+
+    // Run jobs on the calling thread until `counter` is done.
+    void Wait(const Counter* counter);
+
+    // Split [0, count) into batches of `batchSize` and run
+    // `fn(begin, end)` for each batch in parallel. Returns once all batches
+    // are done.
+    void ParallelFor(
+        const char* name,
+        uint32_t count,
+        uint32_t batchSize,
+        const std::function<void(uint32_t begin, uint32_t end)>& fn
+    );
+
+    // index of the calling thread in [0, GetNumThreads()). Any thread that
+    // isn't a worker is thread 0.
+    uint32_t GetThreadIndex() const;
+
+    // workers + the main thread; the number of threads that may run a job at
+    // the same time. Useful to size per-thread resources.
+    uint32_t GetNumThreads() const { return _threads.size(); }
+
+    // Move the profiler entries of all named jobs completed since the last
+    // call into `entries`, one level-0 entry per job.
+    void CollectProfile(std::vector<Profiler::Entry>& entries);
+
+  private:
+    struct Job
+    {
+        const char* name;
+        JobFunction function;
+        Counter* counter;
+        Job* parent;
+        // the job itself plus its incomplete children
+        std::atomic<uint32_t> unfinished;
+    };
+
+    struct ThreadData
+    {
+        std::mutex mutex; // guards `jobs` and `profile`
+        std::deque<Job*> jobs;
+        std::vector<Profiler::Entry> profile;
+    };
+
+    void workerLoop(uint32_t threadIndex);
+    // pop from the thread's own deque, or steal from another one
+    Job* findJob(uint32_t threadIndex);
+    void run(Job* job, uint32_t threadIndex);
+    void finish(Job* job);
+
+    // [0] is the main thread, [i] is `_workers[i - 1]`
+    std::vector<std::unique_ptr<ThreadData>> _threads;
+    std::vector<std::thread> _workers;
+
+    std::atomic<bool> _running = false;
+    std::atomic<uint32_t> _numQueuedJobs = 0; // jobs sitting in any deque
+    // idle workers sleep on it until a job is scheduled
+    std::mutex _sleepMutex;
+    std::condition_variable _sleepCondition;
+};
@@ -0,0 +1,327 @@
+#include "MeshCache.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+#include "MeshSimplifier.h"
+#include "MeshletBuilder.h"
+#include "ObjLoader.h"
+
+namespace MeshCache
+{
+namespace
+{
+const char MAGIC[4] = {'V', 'Q', 'M', 'C'};
+
+// maps the whole file at `path` read-only, nullptr if it can't be opened or
+// is empty
+void* mapFile(const std::string& path, size_t& size) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+        close(fd);
+        return nullptr;
+    }
+    void* mapping = mmap(
+        nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0
+    );
+    // the mapping outlives the descriptor
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return nullptr;
+    }
+    size = (size_t)fileStat.st_size;
+    return mapping;
+}
+
+// 64-bit hash of the source file's contents, mixing in a word at a time; a
+// change to any byte changes the cooked file looked up
+uint64_t hashBytes(const void* data, size_t size) {
+    const uint64_t PRIME = 0x9E3779B97F4A7C15ull;
+    const char* bytes = static_cast<const char*>(data);
+    uint64_t hash = size * PRIME;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(uint64_t));
+        hash = (hash ^ word) * PRIME;
+        hash ^= hash >> 29;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, bytes + i, size - i);
+    hash = (hash ^ tail) * PRIME;
+    return hash ^ (hash >> 32);
+}
+
+size_t alignUp(size_t offset) {
+    return (offset + BLOB_ALIGNMENT - 1) & ~(BLOB_ALIGNMENT - 1);
+}
+
+// whether the `size` bytes at `data` are a cooked mesh of this build's layout,
+// cooked from the source of `sourceHash`, with blobs inside the file and
+// levels of detail inside the indices
+bool isValid(const void* data, size_t size, uint64_t sourceHash) {
+    if (size < sizeof(Header)) {
+        return false;
+    }
+    const Header& header = *static_cast<const Header*>(data);
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0
+        || header.version != VERSION || header.sourceHash != sourceHash
+        || header.vertexSize != sizeof(Vertex)) {
+        return false;
+    }
+    if (header.lodCount == 0 || header.lodCount > MAX_LODS) {
+        return false;
+    }
+    for (uint32_t lod = 0; lod < header.lodCount; lod++) {
+        if ((uint64_t)header.lods[lod].firstIndex + header.lods[lod].indexCount
+            > header.indexCount) {
+            return false;
+        }
+    }
+    return header.vertexOffset % BLOB_ALIGNMENT == 0
+           && header.indexOffset % BLOB_ALIGNMENT == 0
+           && header.meshletOffset % BLOB_ALIGNMENT == 0
+           && header.vertexOffset
+                      + (uint64_t)header.vertexCount * sizeof(Vertex)
+                  <= size
+           && header.indexOffset
+                      + (uint64_t)header.indexCount * sizeof(uint32_t)
+                  <= size
+           && header.meshletOffset
+                      + (uint64_t)header.meshletCount * sizeof(Meshlet)
+                  <= size;
+}
+
+// split LOD 0 of a large enough mesh into meshlets, reordering `indices`
+std::vector<Meshlet> buildMeshlets(
+    const std::vector<Vertex>& vertices,
+    std::vector<uint32_t>& indices
+) {
+    std::vector<Meshlet> meshlets;
+    if (indices.size() / 3 < MESHLET_MIN_TRIANGLES) {
+        return meshlets;
+    }
+    for (const MeshletBuilder::Meshlet& meshlet : MeshletBuilder::Build(
+             vertices, indices, MESHLET_MAX_VERTICES, MESHLET_MAX_TRIANGLES
+         )) {
+        meshlets.push_back(
+            {.boundingSphere = meshlet.boundingSphere,
+             .cone = meshlet.cone,
+             .firstIndex = meshlet.firstIndex,
+             .indexCount = meshlet.indexCount}
+        );
+    }
+    return meshlets;
+}
+
+// append the levels of detail past LOD 0, the whole of `indices`, to
+// `indices`, filling in `header.lods`
+void buildLods(
+    const std::vector<Vertex>& vertices,
+    std::vector<uint32_t>& indices,
+    Header& header
+) {
+    header.lods[0] = {.firstIndex = 0, .indexCount = (uint32_t)indices.size()};
+    header.lodCount = 1;
+    std::vector<uint32_t> lodIndices = indices;
+    while (header.lodCount < MAX_LODS) {
+        std::vector<uint32_t> simplified = MeshSimplifier::Simplify(
+            vertices, lodIndices, lodIndices.size() / 2
+        );
+        if (simplified.size() * 4 > lodIndices.size() * 3) {
+            break;
+        }
+        header.lods[header.lodCount++]
+            = {.firstIndex = (uint32_t)indices.size(),
+               .indexCount = (uint32_t)simplified.size()};
+        indices.insert(indices.end(), simplified.begin(), simplified.end());
+        lodIndices = std::move(simplified);
+    }
+}
+
+// parse the OBJ file at `sourcePath` into the bytes of its cooked file
+std::vector<char> cook(
+    const std::string& sourcePath,
+    uint64_t sourceHash,
+    JobSystem* jobSystem
+) {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    ObjLoader::Load(sourcePath.c_str(), vertices, indices, jobSystem);
+
+    Header header{};
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.sourceHash = sourceHash;
+    header.vertexSize = sizeof(Vertex);
+    header.boundsMin = glm::vec3(std::numeric_limits<float>::max());
+    header.boundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+    for (const Vertex& vertex : vertices) {
+        header.boundsMin = glm::min(header.boundsMin, vertex.pos);
+        header.boundsMax = glm::max(header.boundsMax, vertex.pos);
+    }
+    const glm::vec3 center = (header.boundsMin + header.boundsMax) * 0.5f;
+    float radius = 0.f;
+    for (const Vertex& vertex : vertices) {
+        radius = std::max(radius, glm::distance(center, vertex.pos));
+    }
+    header.boundingSphere = glm::vec4(center, radius);
+
+    // meshlets reorder LOD 0, which the other levels are simplified from
+    const std::vector<Meshlet> meshlets = buildMeshlets(vertices, indices);
+    buildLods(vertices, indices, header);
+    DEBUG(
+        "Cooked {} into {} LODs and {} meshlets",
+        sourcePath,
+        header.lodCount,
+        meshlets.size()
+    );
+
+    header.vertexCount = (uint32_t)vertices.size();
+    header.indexCount = (uint32_t)indices.size();
+    header.meshletCount = (uint32_t)meshlets.size();
+    header.vertexOffset = alignUp(sizeof(Header));
+    header.indexOffset
+        = alignUp(header.vertexOffset + vertices.size() * sizeof(Vertex));
+    header.meshletOffset
+        = alignUp(header.indexOffset + indices.size() * sizeof(uint32_t));
+
+    std::vector<char> bytes(
+        header.meshletOffset + meshlets.size() * sizeof(Meshlet)
+    );
+    memcpy(bytes.data(), &header, sizeof(Header));
+    memcpy(
+        bytes.data() + header.vertexOffset,
+        vertices.data(),
+        vertices.size() * sizeof(Vertex)
+    );
+    memcpy(
+        bytes.data() + header.indexOffset,
+        indices.data(),
+        indices.size() * sizeof(uint32_t)
+    );
+    memcpy(
+        bytes.data() + header.meshletOffset,
+        meshlets.data(),
+        meshlets.size() * sizeof(Meshlet)
+    );
+    return bytes;
+}
+
+// write `bytes` to `path` through a temporary file renamed over it, so that
+// a concurrent or interrupted run never maps a partial file
+void writeFile(
+    const std::filesystem::path& path,
+    const std::vector<char>& bytes
+) {
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+    const size_t threadId
+        = std::hash<std::thread::id>()(std::this_thread::get_id());
+    std::filesystem::path temporaryPath = path;
+    temporaryPath += ".tmp" + std::to_string(threadId);
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        file.write(bytes.data(), (std::streamsize)bytes.size());
+        if (!file) {
+            WARN("Failed to write cooked mesh {}", path.string());
+            file.close();
+            std::filesystem::remove(temporaryPath, error);
+            return;
+        }
+    }
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error) {
+        WARN(
+            "Failed to write cooked mesh {}: {}",
+            path.string(),
+            error.message()
+        );
+        std::filesystem::remove(temporaryPath, error);
+    }
+}
+} // namespace
+
+CookedMesh::~CookedMesh() {
+    if (_mapping) {
+        munmap(_mapping, _mappingSize);
+    }
+}
+
+CookedMesh::CookedMesh(CookedMesh&& other) noexcept
+    : _mapping(other._mapping), _mappingSize(other._mappingSize),
+      _owned(std::move(other._owned)) {
+    other._mapping = nullptr;
+    other._mappingSize = 0;
+}
+
+CookedMesh& CookedMesh::operator=(CookedMesh&& other) noexcept {
+    if (this != &other) {
+        if (_mapping) {
+            munmap(_mapping, _mappingSize);
+        }
+        _mapping = other._mapping;
+        _mappingSize = other._mappingSize;
+        _owned = std::move(other._owned);
+        other._mapping = nullptr;
+        other._mappingSize = 0;
+    }
+    return *this;
+}
+
+CookedMesh Load(const std::string& sourcePath, JobSystem* jobSystem) {
+    size_t sourceSize = 0;
+    void* source = mapFile(sourcePath, sourceSize);
+    if (source == nullptr) {
+        FATAL("Failed to open mesh {}", sourcePath);
+    }
+    const uint64_t sourceHash = hashBytes(source, sourceSize);
+    munmap(source, sourceSize);
+
+    char fileName[32];
+    snprintf(
+        fileName,
+        sizeof(fileName),
+        "%016llx.vqmesh",
+        (unsigned long long)sourceHash
+    );
+    const std::filesystem::path cachePath
+        = std::filesystem::path(DIRECTORY) / fileName;
+
+    CookedMesh mesh;
+    mesh._mapping = mapFile(cachePath.string(), mesh._mappingSize);
+    if (mesh._mapping) {
+        if (isValid(mesh._mapping, mesh._mappingSize, sourceHash)) {
+            DEBUG(
+                "Mapped cooked mesh {} of {}", cachePath.string(), sourcePath
+            );
+            return mesh;
+        }
+        WARN(
+            "Cooked mesh {} is outdated or corrupt, cooking {} again",
+            cachePath.string(),
+            sourcePath
+        );
+        munmap(mesh._mapping, mesh._mappingSize);
+        mesh._mapping = nullptr;
+        mesh._mappingSize = 0;
+    }
+
+    INFO("Cooking mesh {} into {}", sourcePath, cachePath.string());
+    mesh._owned = cook(sourcePath, sourceHash, jobSystem);
+    writeFile(cachePath, mesh._owned);
+    return mesh;
+}
+} // namespace MeshCache
@@ -0,0 +1,131 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "structs/Vertex.h"
+
+class JobSystem;
+
+// Cooked meshes: the vertices and indices `ObjLoader::Load()` produces
+// from an OBJ file, along with their levels of detail and meshlets, stored on
+// disk in a form that is mapped into memory as is instead of being parsed and
+// processed again.
+//
+// A cooked file is a `Header` followed by the vertex, index and meshlet blobs,
+// each aligned to `BLOB_ALIGNMENT`. Files live in `DIRECTORY`, named after the
+// hash of their source file's contents, so that editing a source file cooks
+// it anew and identical files share one cooked mesh.
+namespace MeshCache
+{
+// bumped whenever the cooked layout, what `ObjLoader::Load()`,
+// `MeshletBuilder` or `MeshSimplifier` produce, or the constants below change
+const uint32_t VERSION = 4;
+const char* const DIRECTORY = "cache/meshes";
+const size_t BLOB_ALIGNMENT = 64;
+
+// levels of detail, each simplified from the one before to about half its
+// triangles; the chain ends early once simplification stalls on the mesh's
+// borders or seams
+const uint32_t MAX_LODS = 4;
+// meshes of at least `MESHLET_MIN_TRIANGLES` triangles are split into meshlets
+// of at most `MESHLET_MAX_VERTICES` vertices and `MESHLET_MAX_TRIANGLES`
+// triangles, reordering the triangles of LOD 0
+const uint32_t MESHLET_MAX_VERTICES = 64;
+const uint32_t MESHLET_MAX_TRIANGLES = 124;
+const uint32_t MESHLET_MIN_TRIANGLES = 1024;
+
+// indices of a level of detail, all of which index the same vertices
+struct Lod
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+};
+
+// see `MeshletBuilder::Meshlet`, padded to 16 bytes to be uploaded as is
+struct Meshlet
+{
+    glm::vec4 boundingSphere; // center in xyz, radius in w
+    glm::vec4 cone;           // axis in xyz, cutoff in w
+    uint32_t firstIndex;      // from the first index of LOD 0
+    uint32_t indexCount;
+    uint32_t padding[2];
+};
+
+struct Header
+{
+    char magic[4]; // "VQMC"
+    uint32_t version;
+    uint64_t sourceHash;
+    uint32_t vertexSize; // sizeof(Vertex) of the build that cooked the mesh
+    uint32_t vertexCount;
+    uint32_t indexCount; // of all levels of detail
+    uint32_t meshletCount; // 0 for meshes of too few triangles
+    // axis-aligned bounds of the vertex positions
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+    // bounding sphere around the center of the bounds, radius in w
+    glm::vec4 boundingSphere;
+    uint32_t lodCount;
+    Lod lods[MAX_LODS]; // the mesh itself first
+    // offsets of the blobs from the start of the file
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    uint64_t meshletOffset;
+};
+
+// A cooked mesh, mapped read-only from its cache file, or held in memory when
+// the cache couldn't be written to.
+class CookedMesh
+{
+  public:
+    CookedMesh() = default;
+    ~CookedMesh();
+    CookedMesh(CookedMesh&& other) noexcept;
+    CookedMesh& operator=(CookedMesh&& other) noexcept;
+    CookedMesh(const CookedMesh&) = delete;
+    CookedMesh& operator=(const CookedMesh&) = delete;
+
+    const Header& GetHeader() const {
+        return *reinterpret_cast<const Header*>(data());
+    }
+    const Vertex* GetVertices() const {
+        return reinterpret_cast<const Vertex*>(
+            data() + GetHeader().vertexOffset
+        );
+    }
+    const uint32_t* GetIndices() const {
+        return reinterpret_cast<const uint32_t*>(
+            data() + GetHeader().indexOffset
+        );
+    }
+    const Meshlet* GetMeshlets() const {
+        return reinterpret_cast<const Meshlet*>(
+            data() + GetHeader().meshletOffset
+        );
+    }
+    size_t GetVertexCount() const { return GetHeader().vertexCount; }
+    size_t GetIndexCount() const { return GetHeader().indexCount; }
+    size_t GetMeshletCount() const { return GetHeader().meshletCount; }
+    size_t GetLodCount() const { return GetHeader().lodCount; }
+    const Lod& GetLod(size_t lod) const { return GetHeader().lods[lod]; }
+
+  private:
+    friend CookedMesh Load(const std::string& sourcePath, JobSystem* jobSystem);
+
+    const char* data() const {
+        return _mapping ? static_cast<const char*>(_mapping) : _owned.data();
+    }
+
+    void* _mapping = nullptr;
+    size_t _mappingSize = 0;
+    std::vector<char> _owned;
+};
+
+// The cooked mesh of the OBJ file at `sourcePath`. The source is hashed, and
+// the cooked file of that hash mapped; on a miss, the source is parsed,
+// simplified and split into meshlets, and its cooked file written for the
+// next run. The source is parsed in parallel on `jobSystem` if given.
+CookedMesh Load(const std::string& sourcePath, JobSystem* jobSystem = nullptr);
+} // namespace MeshCache
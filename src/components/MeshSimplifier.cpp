@@ -0,0 +1,278 @@
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+
+#include "MeshSimplifier.h"
+
+namespace
+{
+// symmetric 4x4 matrix of the summed squared distances to a set of planes,
+// upper triangle in row-major order
+struct Quadric
+{
+    double a[10] = {};
+
+    void AddPlane(const glm::dvec4& p, double weight) {
+        a[0] += weight * p.x * p.x;
+        a[1] += weight * p.x * p.y;
+        a[2] += weight * p.x * p.z;
+        a[3] += weight * p.x * p.w;
+        a[4] += weight * p.y * p.y;
+        a[5] += weight * p.y * p.z;
+        a[6] += weight * p.y * p.w;
+        a[7] += weight * p.z * p.z;
+        a[8] += weight * p.z * p.w;
+        a[9] += weight * p.w * p.w;
+    }
+
+    Quadric& operator+=(const Quadric& other) {
+        for (int i = 0; i < 10; i++) {
+            a[i] += other.a[i];
+        }
+        return *this;
+    }
+
+    // squared distance of `v` to the planes
+    double Evaluate(const glm::vec3& v) const {
+        const double x = v.x, y = v.y, z = v.z;
+        return a[0] * x * x + 2 * a[1] * x * y + 2 * a[2] * x * z
+               + 2 * a[3] * x + a[4] * y * y + 2 * a[5] * y * z + 2 * a[6] * y
+               + a[7] * z * z + 2 * a[8] * z + a[9];
+    }
+};
+
+struct Collapse
+{
+    uint32_t from; // position collapsed away
+    uint32_t to;   // position collapsed onto
+    double error;
+};
+
+uint64_t edgeKey(uint32_t a, uint32_t b) {
+    return a < b ? (uint64_t(a) << 32 | b) : (uint64_t(b) << 32 | a);
+}
+} // namespace
+
+std::vector<uint32_t> MeshSimplifier::Simplify(
+    const std::vector<Vertex>& vertices,
+    const std::vector<uint32_t>& indices,
+    size_t targetIndexCount
+) {
+    const uint32_t numVertices = vertices.size();
+
+    // weld the vertices sharing a position into the first of them, keeping
+    // a ring of each position's vertices
+    std::vector<uint32_t> positionOf(numVertices);
+    std::vector<uint32_t> nextWedge(numVertices);
+    {
+        std::unordered_map<glm::vec3, uint32_t> positions;
+        for (uint32_t v = 0; v < numVertices; v++) {
+            const uint32_t position
+                = positions.insert({vertices[v].pos, v}).first->second;
+            positionOf[v] = position;
+            nextWedge[v] = v;
+            if (position != v) {
+                nextWedge[v] = nextWedge[position];
+                nextWedge[position] = v;
+            }
+        }
+    }
+
+    // area-weighted planes of the triangles around each position
+    std::vector<Quadric> quadrics(numVertices);
+    std::unordered_map<uint64_t, uint32_t> edgeCounts;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        const uint32_t p[3] = {
+            positionOf[indices[i]],
+            positionOf[indices[i + 1]],
+            positionOf[indices[i + 2]]
+        };
+        const glm::dvec3 p0 = vertices[p[0]].pos;
+        const glm::dvec3 normal = glm::cross(
+            glm::dvec3(vertices[p[1]].pos) - p0,
+            glm::dvec3(vertices[p[2]].pos) - p0
+        );
+        const double area = glm::length(normal) * 0.5;
+        if (area > 0) {
+            const glm::dvec3 n = glm::normalize(normal);
+            const glm::dvec4 plane(n, -glm::dot(n, p0));
+            for (uint32_t position : p) {
+                quadrics[position].AddPlane(plane, area);
+            }
+        }
+        for (int corner = 0; corner < 3; corner++) {
+            edgeCounts[edgeKey(p[corner], p[(corner + 1) % 3])]++;
+        }
+    }
+
+    // an edge of a single triangle lies on a border, whose positions are
+    // locked lest the mesh shrinks away from them
+    std::vector<bool> locked(numVertices, false);
+    for (const auto& [key, count] : edgeCounts) {
+        if (count == 1) {
+            locked[key >> 32] = true;
+            locked[key & 0xFFFFFFFF] = true;
+        }
+    }
+
+    std::vector<uint32_t> result = indices;
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> wedgeRemap(numVertices);
+    std::vector<bool> touched(numVertices);
+    // triangles around each position, <offsets, triangles>
+    std::vector<uint32_t> adjacencyOffsets(numVertices + 1);
+    std::vector<uint32_t> adjacency;
+
+    while (result.size() > targetIndexCount) {
+        const size_t numTriangles = result.size() / 3;
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+        for (uint32_t index : result) {
+            adjacencyOffsets[positionOf[index] + 1]++;
+        }
+        for (uint32_t v = 0; v < numVertices; v++) {
+            adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+        }
+        adjacency.resize(result.size());
+        {
+            std::vector<uint32_t> fill(
+                adjacencyOffsets.begin(), adjacencyOffsets.end() - 1
+            );
+            for (size_t i = 0; i < result.size(); i++) {
+                adjacency[fill[positionOf[result[i]]]++] = i / 3;
+            }
+        }
+
+        // every interior edge, once, in its cheaper direction
+        collapses.clear();
+        for (size_t i = 0; i < result.size(); i++) {
+            const uint32_t a = positionOf[result[i]];
+            const uint32_t b = positionOf[result[i - i % 3 + (i + 1) % 3]];
+            if (a >= b || (locked[a] && locked[b])) {
+                continue;
+            }
+            Quadric quadric = quadrics[a];
+            quadric += quadrics[b];
+            const double infinity = std::numeric_limits<double>::infinity();
+            const double errorAB
+                = locked[a] ? infinity : quadric.Evaluate(vertices[b].pos);
+            const double errorBA
+                = locked[b] ? infinity : quadric.Evaluate(vertices[a].pos);
+            if (errorAB <= errorBA) {
+                collapses.push_back({a, b, errorAB});
+            } else {
+                collapses.push_back({b, a, errorBA});
+            }
+        }
+        if (collapses.empty()) {
+            break;
+        }
+        std::sort(
+            collapses.begin(),
+            collapses.end(),
+            [](const Collapse& lhs, const Collapse& rhs) {
+                return lhs.error < rhs.error;
+            }
+        );
+
+        // apply the cheapest collapses with disjoint neighborhoods, each
+        // removing about 2 triangles
+        const size_t maxCollapses
+            = (numTriangles - targetIndexCount / 3) / 2 + 1;
+        size_t numCollapses = 0;
+        std::fill(touched.begin(), touched.end(), false);
+        for (uint32_t v = 0; v < numVertices; v++) {
+            wedgeRemap[v] = v;
+        }
+        for (const Collapse& collapse : collapses) {
+            if (numCollapses >= maxCollapses) {
+                break;
+            }
+            if (touched[collapse.from] || touched[collapse.to]) {
+                continue;
+            }
+
+            // skip collapses that flip the triangles around `from`
+            const glm::vec3 to = vertices[collapse.to].pos;
+            bool flips = false;
+            for (uint32_t a = adjacencyOffsets[collapse.from];
+                 a < adjacencyOffsets[collapse.from + 1] && !flips;
+                 a++) {
+                const uint32_t* triangle = &result[adjacency[a] * 3];
+                glm::vec3 p[3];
+                glm::vec3 moved[3];
+                bool degenerates = false;
+                for (int corner = 0; corner < 3; corner++) {
+                    const uint32_t position = positionOf[triangle[corner]];
+                    degenerates |= position == collapse.to;
+                    p[corner] = vertices[position].pos;
+                    moved[corner] = position == collapse.from ? to : p[corner];
+                }
+                if (degenerates) {
+                    continue;
+                }
+                const glm::vec3 before
+                    = glm::cross(p[1] - p[0], p[2] - p[0]);
+                const glm::vec3 after
+                    = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+                flips = glm::dot(before, after) <= 0.f;
+            }
+            if (flips) {
+                continue;
+            }
+
+            // keep the neighborhood still for the rest of the pass
+            for (uint32_t a = adjacencyOffsets[collapse.from];
+                 a < adjacencyOffsets[collapse.from + 1];
+                 a++) {
+                const uint32_t* triangle = &result[adjacency[a] * 3];
+                for (int corner = 0; corner < 3; corner++) {
+                    touched[positionOf[triangle[corner]]] = true;
+                }
+            }
+            touched[collapse.to] = true;
+
+            // each vertex at `from` moves to the closest match at `to`
+            uint32_t wedge = collapse.from;
+            do {
+                const Vertex& vertex = vertices[wedge];
+                float bestDistance = std::numeric_limits<float>::max();
+                uint32_t target = collapse.to;
+                do {
+                    const Vertex& candidate = vertices[target];
+                    const glm::vec2 uv = candidate.texCoord - vertex.texCoord;
+                    const float distance
+                        = glm::dot(uv, uv)
+                          + (1.f - glm::dot(candidate.normal, vertex.normal));
+                    if (distance < bestDistance) {
+                        bestDistance = distance;
+                        wedgeRemap[wedge] = target;
+                    }
+                    target = nextWedge[target];
+                } while (target != collapse.to);
+                wedge = nextWedge[wedge];
+            } while (wedge != collapse.from);
+            quadrics[collapse.to] += quadrics[collapse.from];
+            numCollapses++;
+        }
+        if (numCollapses == 0) {
+            break;
+        }
+
+        // drop the triangles that collapsed into lines
+        size_t write = 0;
+        for (size_t i = 0; i < result.size(); i += 3) {
+            const uint32_t a = wedgeRemap[result[i]];
+            const uint32_t b = wedgeRemap[result[i + 1]];
+            const uint32_t c = wedgeRemap[result[i + 2]];
+            if (positionOf[a] == positionOf[b] || positionOf[b] == positionOf[c]
+                || positionOf[c] == positionOf[a]) {
+                continue;
+            }
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+    }
+    return result;
+}
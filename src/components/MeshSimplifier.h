@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "structs/Vertex.h"
+
+namespace MeshSimplifier
+{
+// Simplify the triangle list `indices` down to about `targetIndexCount`
+// indices, by collapsing the edges of the least quadric error (Garland &
+// Heckbert) onto one of their ends. The result indexes the same `vertices`.
+//
+// Vertices that share a position but not their other attributes, as on UV
+// seams, collapse together, each onto the destination's closest match.
+// Vertices on the mesh's borders stay put, and collapses that would flip a
+// triangle are skipped, so the result may have more indices than asked for.
+std::vector<uint32_t> Simplify(
+    const std::vector<Vertex>& vertices,
+    const std::vector<uint32_t>& indices,
+    size_t targetIndexCount
+);
+} // namespace MeshSimplifier
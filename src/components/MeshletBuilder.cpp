@@ -0,0 +1,242 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+#include "MeshletBuilder.h"
+
+namespace
+{
+// bounding sphere and normal cone of the triangles of `indices`
+void computeBounds(
+    const std::vector<Vertex>& vertices,
+    const uint32_t* indices,
+    uint32_t indexCount,
+    MeshletBuilder::Meshlet& meshlet
+) {
+    // sphere around the center of the AABB
+    glm::vec3 min(std::numeric_limits<float>::max());
+    glm::vec3 max(std::numeric_limits<float>::lowest());
+    for (uint32_t i = 0; i < indexCount; i++) {
+        min = glm::min(min, vertices[indices[i]].pos);
+        max = glm::max(max, vertices[indices[i]].pos);
+    }
+    const glm::vec3 center = (min + max) * 0.5f;
+    float radius = 0.f;
+    for (uint32_t i = 0; i < indexCount; i++) {
+        radius
+            = std::max(radius, glm::distance(center, vertices[indices[i]].pos));
+    }
+    meshlet.boundingSphere = glm::vec4(center, radius);
+
+    // the cone around the average of the triangles' normals that holds them
+    // all
+    auto triangleNormal = [&](uint32_t i) {
+        const glm::vec3 p0 = vertices[indices[i]].pos;
+        const glm::vec3 normal = glm::cross(
+            vertices[indices[i + 1]].pos - p0, vertices[indices[i + 2]].pos - p0
+        );
+        const float length = glm::length(normal);
+        return length > 0.f ? normal / length : glm::vec3(0.f);
+    };
+    glm::vec3 axis(0.f);
+    for (uint32_t i = 0; i + 2 < indexCount; i += 3) {
+        axis += triangleNormal(i);
+    }
+    const float axisLength = glm::length(axis);
+    float minDot = 1.f;
+    for (uint32_t i = 0; i + 2 < indexCount && axisLength > 0.f; i += 3) {
+        const glm::vec3 normal = triangleNormal(i);
+        if (normal != glm::vec3(0.f)) {
+            minDot = std::min(minDot, glm::dot(normal, axis / axisLength));
+        }
+    }
+    if (axisLength == 0.f || minDot <= 0.1f) {
+        // too wide to ever face away as a whole
+        meshlet.cone = glm::vec4(0.f, 0.f, 1.f, 1.f);
+        return;
+    }
+    // sine of the cone's half angle
+    meshlet.cone
+        = glm::vec4(axis / axisLength, std::sqrt(1.f - minDot * minDot));
+}
+
+// interleave the low 10 bits of `v` with 2 zero bits each
+uint32_t spreadBits(uint32_t v) {
+    v = (v | (v << 16)) & 0x030000FF;
+    v = (v | (v << 8)) & 0x0300F00F;
+    v = (v | (v << 4)) & 0x030C30C3;
+    v = (v | (v << 2)) & 0x09249249;
+    return v;
+}
+} // namespace
+
+std::vector<MeshletBuilder::Meshlet> MeshletBuilder::Build(
+    const std::vector<Vertex>& vertices,
+    std::vector<uint32_t>& indices,
+    uint32_t maxVertices,
+    uint32_t maxTriangles
+) {
+    const uint32_t numVertices = vertices.size();
+    const uint32_t numTriangles = indices.size() / 3;
+
+    // triangles are adjacent through their positions, so that meshlets grow
+    // across UV seams
+    std::vector<uint32_t> positionOf(numVertices);
+    {
+        std::unordered_map<glm::vec3, uint32_t> positions;
+        for (uint32_t v = 0; v < numVertices; v++) {
+            positionOf[v]
+                = positions.insert({vertices[v].pos, v}).first->second;
+        }
+    }
+
+    // triangles around each position, <offsets, triangles>
+    std::vector<uint32_t> adjacencyOffsets(numVertices + 1, 0);
+    for (uint32_t i = 0; i < numTriangles * 3; i++) {
+        adjacencyOffsets[positionOf[indices[i]] + 1]++;
+    }
+    for (uint32_t v = 0; v < numVertices; v++) {
+        adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+    }
+    std::vector<uint32_t> adjacency(numTriangles * 3);
+    {
+        std::vector<uint32_t> fill(
+            adjacencyOffsets.begin(), adjacencyOffsets.end() - 1
+        );
+        for (uint32_t i = 0; i < numTriangles * 3; i++) {
+            adjacency[fill[positionOf[indices[i]]]++] = i / 3;
+        }
+    }
+
+    // triangles along a Z-order curve through the mesh's bounds, the order
+    // new meshlets are seeded in, and that disconnected parts join meshlets
+    // in
+    std::vector<uint32_t> order(numTriangles);
+    {
+        glm::vec3 min(std::numeric_limits<float>::max());
+        glm::vec3 max(std::numeric_limits<float>::lowest());
+        for (const Vertex& vertex : vertices) {
+            min = glm::min(min, vertex.pos);
+            max = glm::max(max, vertex.pos);
+        }
+        const glm::vec3 extent = glm::max(max - min, glm::vec3(1e-6f));
+        std::vector<uint32_t> codes(numTriangles);
+        for (uint32_t t = 0; t < numTriangles; t++) {
+            const glm::vec3 centroid = (vertices[indices[t * 3]].pos
+                                        + vertices[indices[t * 3 + 1]].pos
+                                        + vertices[indices[t * 3 + 2]].pos)
+                                       / 3.f;
+            const glm::vec3 cell = (centroid - min) / extent * 1023.f;
+            codes[t] = spreadBits(uint32_t(cell.x))
+                       | spreadBits(uint32_t(cell.y)) << 1
+                       | spreadBits(uint32_t(cell.z)) << 2;
+            order[t] = t;
+        }
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return codes[a] < codes[b];
+        });
+    }
+
+    std::vector<Meshlet> meshlets;
+    std::vector<uint32_t> reordered;
+    reordered.reserve(numTriangles * 3);
+    std::vector<bool> emitted(numTriangles, false);
+    // meshlet each vertex was last added to, + 1
+    std::vector<uint32_t> vertexMeshlet(numVertices, 0);
+    std::vector<uint32_t> meshletVertices;
+    uint32_t nextSeed = 0;
+
+    while (true) {
+        while (nextSeed < numTriangles && emitted[order[nextSeed]]) {
+            nextSeed++;
+        }
+        if (nextSeed == numTriangles) {
+            break;
+        }
+        const uint32_t meshletId = meshlets.size() + 1;
+        Meshlet meshlet{};
+        meshlet.firstIndex = reordered.size();
+        meshletVertices.clear();
+
+        uint32_t triangle = order[nextSeed];
+        uint32_t triangleCount = 0;
+        while (true) {
+            emitted[triangle] = true;
+            triangleCount++;
+            for (int corner = 0; corner < 3; corner++) {
+                const uint32_t v = indices[triangle * 3 + corner];
+                reordered.push_back(v);
+                if (vertexMeshlet[v] != meshletId) {
+                    vertexMeshlet[v] = meshletId;
+                    meshletVertices.push_back(v);
+                }
+            }
+            if (triangleCount == maxTriangles) {
+                break;
+            }
+
+            // the neighbor that adds the fewest vertices, and still fits
+            uint32_t best = numTriangles;
+            uint32_t bestNewVertices = 4;
+            for (uint32_t v : meshletVertices) {
+                const uint32_t position = positionOf[v];
+                for (uint32_t a = adjacencyOffsets[position];
+                     a < adjacencyOffsets[position + 1];
+                     a++) {
+                    const uint32_t candidate = adjacency[a];
+                    if (emitted[candidate]) {
+                        continue;
+                    }
+                    uint32_t newVertices = 0;
+                    for (int corner = 0; corner < 3; corner++) {
+                        newVertices
+                            += vertexMeshlet[indices[candidate * 3 + corner]]
+                               != meshletId;
+                    }
+                    if (newVertices < bestNewVertices) {
+                        best = candidate;
+                        bestNewVertices = newVertices;
+                    }
+                }
+            }
+            if (best == numTriangles) {
+                // no neighbors left: a small meshlet continues with the next
+                // triangle along the curve, a large one is done before its
+                // bounds and normal cone widen
+                if (triangleCount * 4 >= maxTriangles) {
+                    break;
+                }
+                while (nextSeed < numTriangles && emitted[order[nextSeed]]) {
+                    nextSeed++;
+                }
+                if (nextSeed == numTriangles) {
+                    break;
+                }
+                best = order[nextSeed];
+                bestNewVertices = 0;
+                for (int corner = 0; corner < 3; corner++) {
+                    bestNewVertices
+                        += vertexMeshlet[indices[best * 3 + corner]]
+                           != meshletId;
+                }
+            }
+            if (meshletVertices.size() + bestNewVertices > maxVertices) {
+                break;
+            }
+            triangle = best;
+        }
+
+        meshlet.indexCount = triangleCount * 3;
+        computeBounds(
+            vertices,
+            reordered.data() + meshlet.firstIndex,
+            meshlet.indexCount,
+            meshlet
+        );
+        meshlets.push_back(meshlet);
+    }
+
+    indices = std::move(reordered);
+    return meshlets;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "structs/Vertex.h"
+
+namespace MeshletBuilder
+{
+struct Meshlet
+{
+    glm::vec4 boundingSphere; // center in xyz, radius in w
+    // axis in xyz, cutoff in w: all of the meshlet's triangles face away from
+    // any point `p` with
+    // dot(center - p, axis) >= cutoff * length(center - p) + radius
+    glm::vec4 cone;
+    uint32_t firstIndex; // into the reordered indices
+    uint32_t indexCount;
+};
+
+// Split the triangle list `indices` into meshlets of at most `maxVertices`
+// distinct vertices and `maxTriangles` triangles, reordering `indices` so
+// that each meshlet's triangles are contiguous.
+//
+// Meshlets are grown greedily from a seed triangle, taking the adjacent
+// triangle that adds the fewest new vertices, so that they stay compact and
+// their bounds tight. Small, disconnected parts are gathered into meshlets
+// by their order along a Z-order curve.
+std::vector<Meshlet> Build(
+    const std::vector<Vertex>& vertices,
+    std::vector<uint32_t>& indices,
+    uint32_t maxVertices,
+    uint32_t maxTriangles
+);
+} // namespace MeshletBuilder
@@ -0,0 +1,605 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+
+#ifndef __cpp_lib_to_chars
+#include <locale.h>
+#ifdef __APPLE__
+#include <xlocale.h>
+#endif
+#endif
+
+#include "JobSystem.h"
+#include "ObjLoader.h"
+
+namespace
+{
+// chunks are at least this large, so that small files are parsed in one go
+const size_t MIN_CHUNK_SIZE = 256 * 1024;
+// chunks per thread, to even out chunks of slow lines
+const uint32_t CHUNKS_PER_THREAD = 4;
+// corners or vertices handled per job by the passes after parsing
+const uint32_t BATCH_SIZE = 64 * 1024;
+
+const int32_t NO_TEX_COORD = INT32_MIN;
+// corners ahead of the one being inserted whose slots are prefetched
+const uint32_t PREFETCH_DISTANCE = 16;
+// normal of vertices whose faces have no direction to average
+const glm::vec3 DEFAULT_NORMAL(0.f, 0.f, 1.f);
+
+// corner of a triangle, as written in the file: 0-based, or relative to the
+// number of elements the chunk had parsed so far if the file's index was
+// negative
+struct Corner
+{
+    int32_t position;
+    int32_t texCoord;
+    bool positionRelative;
+    bool texCoordRelative;
+};
+
+struct Chunk
+{
+    const char* begin;
+    const char* end;
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> texCoords;
+    std::vector<Corner> corners; // three per triangle
+    // elements of the chunks before this one
+    size_t positionBase = 0;
+    size_t texCoordBase = 0;
+    size_t cornerBase = 0;
+    bool malformed = false;
+};
+
+// what deduplication compares: two corners with the same key are the same
+// vertex. Tightly packed, so that keys are hashed and compared as bytes.
+struct Key
+{
+    float position[3];
+    float texCoord[2];
+
+    bool operator==(const Key& other) const {
+        return memcmp(this, &other, sizeof(Key)) == 0;
+    }
+};
+static_assert(sizeof(Key) == 5 * sizeof(float));
+
+// run `fn` over [0, count) in batches, on the job system if there's one
+void parallelFor(
+    JobSystem* jobSystem,
+    uint32_t count,
+    uint32_t batchSize,
+    const std::function<void(uint32_t begin, uint32_t end)>& fn
+) {
+    if (count == 0) {
+        return;
+    }
+    if (jobSystem == nullptr || count <= batchSize) {
+        for (uint32_t begin = 0; begin < count; begin += batchSize) {
+            fn(begin, std::min(begin + batchSize, count));
+        }
+        return;
+    }
+    jobSystem->ParallelFor(nullptr, count, batchSize, fn);
+}
+
+uint64_t mix(uint64_t a, uint64_t b) {
+    __uint128_t product = (__uint128_t)a * b;
+    return (uint64_t)product ^ (uint64_t)(product >> 64);
+}
+
+// wyhash-style: two 128-bit multiplies over the key's 20 bytes
+uint64_t hashKey(const Key& key) {
+    const uint64_t SEED0 = 0xa0761d6478bd642full;
+    const uint64_t SEED1 = 0xe7037ed1a0b428dbull;
+    const uint64_t SEED2 = 0x8ebc6af09c88c6e3ull;
+    uint64_t words[3] = {};
+    memcpy(words, &key, sizeof(Key));
+    return mix(
+        mix(words[0] ^ SEED0, words[1] ^ SEED1) ^ words[2], SEED2 ^ sizeof(Key)
+    );
+}
+
+bool isHorizontalSpace(char c) { return c == ' ' || c == '\t'; }
+
+const char* skipSpaces(const char* p, const char* end) {
+    while (p < end && isHorizontalSpace(*p)) {
+        p++;
+    }
+    return p;
+}
+
+// parse a float at `p`, which must start a number on the same line.
+// `strtof` follows the C locale, and would stop at the '.' under one with a
+// decimal comma: `std::from_chars` doesn't, or `strtof_l` with the "C" locale
+// where the standard library lacks floating point `std::from_chars` (libc++)
+bool parseFloat(const char*& p, const char* end, float& value) {
+    p = skipSpaces(p, end);
+    // `std::from_chars` takes a '-' but no '+'
+    if (p < end && *p == '+') {
+        p++;
+        if (p < end && *p == '-') {
+            return false;
+        }
+    }
+    if (p == end
+        || !(isdigit((unsigned char)*p) || *p == '-' || *p == '.')) {
+        return false;
+    }
+#ifdef __cpp_lib_to_chars
+    std::from_chars_result result = std::from_chars(p, end, value);
+    if (result.ec == std::errc::result_out_of_range) {
+        // saturate to infinity or zero as `strtof` would, through a double
+        double wide;
+        result = std::from_chars(p, end, wide);
+        value = (float)wide;
+    }
+    if (result.ec != std::errc()) {
+        return false;
+    }
+    p = result.ptr;
+#else
+    static const locale_t cLocale = newlocale(LC_ALL_MASK, "C", nullptr);
+    char* numberEnd;
+    value = strtof_l(p, &numberEnd, cLocale);
+    if (numberEnd == p) {
+        return false;
+    }
+    p = numberEnd;
+#endif
+    return true;
+}
+
+bool parseInt(const char*& p, const char* end, int32_t& value) {
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+    if (p == end || !isdigit((unsigned char)*p)) {
+        return false;
+    }
+    int64_t result = 0;
+    while (p < end && isdigit((unsigned char)*p)) {
+        result = std::min<int64_t>(result * 10 + (*p - '0'), INT32_MAX);
+        p++;
+    }
+    value = (int32_t)(negative ? -result : result);
+    return true;
+}
+
+// parse a `v[/[vt][/vn]]` corner into chunk-local terms
+bool parseCorner(
+    const char*& p,
+    const char* end,
+    const Chunk& chunk,
+    Corner& corner
+) {
+    int32_t position;
+    if (!parseInt(p, end, position) || position == 0) {
+        return false;
+    }
+    corner.positionRelative = position < 0;
+    corner.position = position < 0 ? (int32_t)chunk.positions.size() + position
+                                   : position - 1;
+    corner.texCoord = NO_TEX_COORD;
+    corner.texCoordRelative = false;
+    if (p < end && *p == '/') {
+        p++;
+        int32_t texCoord;
+        if (p < end && *p != '/') {
+            if (!parseInt(p, end, texCoord) || texCoord == 0) {
+                return false;
+            }
+            corner.texCoordRelative = texCoord < 0;
+            corner.texCoord = texCoord < 0
+                                  ? (int32_t)chunk.texCoords.size() + texCoord
+                                  : texCoord - 1;
+        }
+        if (p < end && *p == '/') {
+            // normals are recomputed, the file's are skipped
+            p++;
+            int32_t normal;
+            if (!parseInt(p, end, normal)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void parseChunk(Chunk& chunk) {
+    std::vector<Corner> face;
+    const char* p = chunk.begin;
+    while (p < chunk.end) {
+        const char* lineEnd = static_cast<const char*>(
+            memchr(p, '\n', chunk.end - p)
+        );
+        if (lineEnd == nullptr) {
+            lineEnd = chunk.end;
+        }
+        const char* end = lineEnd;
+        if (end > p && end[-1] == '\r') {
+            end--;
+        }
+        p = skipSpaces(p, end);
+
+        if (end - p >= 2 && p[0] == 'v' && isHorizontalSpace(p[1])) {
+            p++;
+            glm::vec3 position;
+            if (!parseFloat(p, end, position.x)
+                || !parseFloat(p, end, position.y)
+                || !parseFloat(p, end, position.z)) {
+                chunk.malformed = true;
+                return;
+            }
+            chunk.positions.push_back(position);
+        } else if (end - p >= 3 && p[0] == 'v' && p[1] == 't'
+                   && isHorizontalSpace(p[2])) {
+            p += 2;
+            glm::vec2 texCoord(0.f);
+            if (!parseFloat(p, end, texCoord.x)) {
+                chunk.malformed = true;
+                return;
+            }
+            // the second coordinate is optional
+            parseFloat(p, end, texCoord.y);
+            chunk.texCoords.push_back(texCoord);
+        } else if (end - p >= 2 && p[0] == 'f' && isHorizontalSpace(p[1])) {
+            p++;
+            face.clear();
+            while ((p = skipSpaces(p, end)) < end) {
+                Corner corner;
+                if (!parseCorner(p, end, chunk, corner)) {
+                    chunk.malformed = true;
+                    return;
+                }
+                face.push_back(corner);
+            }
+            // fan the polygon into triangles
+            for (size_t i = 1; i + 1 < face.size(); i++) {
+                chunk.corners.push_back(face[0]);
+                chunk.corners.push_back(face[i]);
+                chunk.corners.push_back(face[i + 1]);
+            }
+        }
+        p = lineEnd + 1;
+    }
+}
+
+// split [data, data + size) into chunks of whole lines
+std::vector<Chunk> splitChunks(const char* data, size_t size, uint32_t count) {
+    std::vector<Chunk> chunks;
+    const char* end = data + size;
+    const char* begin = data;
+    for (uint32_t i = 1; i <= count && begin < end; i++) {
+        const char* chunkEnd = i == count ? end : data + size * i / count;
+        if (chunkEnd < begin) {
+            continue;
+        }
+        const char* newline = static_cast<const char*>(
+            memchr(chunkEnd, '\n', end - chunkEnd)
+        );
+        chunkEnd = newline ? newline + 1 : end;
+        chunks.push_back({.begin = begin, .end = chunkEnd});
+        begin = chunkEnd;
+    }
+    return chunks;
+}
+} // namespace
+
+void ObjLoader::Load(
+    const char* path,
+    std::vector<Vertex>& vertices,
+    std::vector<uint32_t>& indices,
+    JobSystem* jobSystem
+) {
+    vertices.clear();
+    indices.clear();
+
+    std::string data;
+    {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) {
+            FATAL("Failed to open OBJ file {}", path);
+        }
+        data.resize((size_t)file.tellg());
+        file.seekg(0);
+        file.read(data.data(), (std::streamsize)data.size());
+    }
+
+    // parse the chunks into chunk-local elements
+    uint32_t numChunks = jobSystem
+                             ? jobSystem->GetNumThreads() * CHUNKS_PER_THREAD
+                             : 1;
+    numChunks = (uint32_t)std::max<size_t>(
+        1, std::min<size_t>(numChunks, data.size() / MIN_CHUNK_SIZE)
+    );
+    std::vector<Chunk> chunks
+        = splitChunks(data.data(), data.size(), numChunks);
+    parallelFor(
+        jobSystem,
+        chunks.size(),
+        1,
+        [&chunks](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; i++) {
+                parseChunk(chunks[i]);
+            }
+        }
+    );
+
+    // number the elements across chunks
+    size_t numPositions = 0, numTexCoords = 0, numCorners = 0;
+    for (Chunk& chunk : chunks) {
+        if (chunk.malformed) {
+            FATAL("Malformed OBJ file {}", path);
+        }
+        chunk.positionBase = numPositions;
+        chunk.texCoordBase = numTexCoords;
+        chunk.cornerBase = numCorners;
+        numPositions += chunk.positions.size();
+        numTexCoords += chunk.texCoords.size();
+        numCorners += chunk.corners.size();
+    }
+    // so that every slot of the dedup table below has a 32-bit index
+    if (numCorners > INT32_MAX) {
+        FATAL("OBJ file {} has too many triangles", path);
+    }
+
+    // gather the chunks' elements into the whole file's
+    std::vector<glm::vec3> positions(numPositions);
+    std::vector<glm::vec2> texCoords(numTexCoords);
+    parallelFor(
+        jobSystem,
+        chunks.size(),
+        1,
+        [&](uint32_t begin, uint32_t end) {
+            for (uint32_t c = begin; c < end; c++) {
+                const Chunk& chunk = chunks[c];
+                std::copy(
+                    chunk.positions.begin(),
+                    chunk.positions.end(),
+                    positions.begin() + chunk.positionBase
+                );
+                std::copy(
+                    chunk.texCoords.begin(),
+                    chunk.texCoords.end(),
+                    texCoords.begin() + chunk.texCoordBase
+                );
+            }
+        }
+    );
+
+    // every corner's key, resolving its indices against the whole file
+    std::vector<Key> keys(numCorners);
+    std::atomic<bool> outOfRange = false;
+    parallelFor(
+        jobSystem,
+        chunks.size(),
+        1,
+        [&](uint32_t begin, uint32_t end) {
+            for (uint32_t c = begin; c < end; c++) {
+                const Chunk& chunk = chunks[c];
+                for (size_t i = 0; i < chunk.corners.size(); i++) {
+                    const Corner& corner = chunk.corners[i];
+                    int64_t position = corner.position;
+                    if (corner.positionRelative) {
+                        position += (int64_t)chunk.positionBase;
+                    }
+                    if (position < 0 || position >= (int64_t)numPositions) {
+                        outOfRange = true;
+                        return;
+                    }
+                    glm::vec2 texCoord(0.f);
+                    if (corner.texCoord != NO_TEX_COORD) {
+                        int64_t index = corner.texCoord;
+                        if (corner.texCoordRelative) {
+                            index += (int64_t)chunk.texCoordBase;
+                        }
+                        if (index < 0 || index >= (int64_t)numTexCoords) {
+                            outOfRange = true;
+                            return;
+                        }
+                        texCoord = texCoords[index];
+                    }
+                    // adding zero folds -0 into +0, which compares equal
+                    Key& key = keys[chunk.cornerBase + i];
+                    key.position[0] = positions[position].x + 0.f;
+                    key.position[1] = positions[position].y + 0.f;
+                    key.position[2] = positions[position].z + 0.f;
+                    key.texCoord[0] = texCoord.x + 0.f;
+                    key.texCoord[1] = 1.f - texCoord.y;
+                }
+            }
+        }
+    );
+    if (outOfRange) {
+        FATAL("OBJ file {} indexes past its vertices", path);
+    }
+    chunks.clear();
+    positions.clear();
+    texCoords.clear();
+    data.clear();
+
+    // dedup in an open-addressing table of at most half load, sized up front.
+    // A slot holds 1 + the first corner of its key, 0 while empty: corners of
+    // equal keys race to leave the smallest corner index in their slot.
+    size_t tableSize = 1;
+    while (tableSize < numCorners * 2) {
+        tableSize <<= 1;
+    }
+    const size_t mask = tableSize - 1;
+    // value-initialized, i.e. all empty
+    std::vector<std::atomic<uint32_t>> table(tableSize);
+    // each corner's home slot, then the slot its key ended up in
+    std::vector<uint32_t> slotOf(numCorners);
+    parallelFor(
+        jobSystem,
+        numCorners,
+        BATCH_SIZE,
+        [&](uint32_t begin, uint32_t end) {
+            for (uint32_t c = begin; c < end; c++) {
+                slotOf[c] = (uint32_t)(hashKey(keys[c]) & mask);
+            }
+        }
+    );
+    parallelFor(
+        jobSystem,
+        numCorners,
+        BATCH_SIZE,
+        [&](uint32_t begin, uint32_t end) {
+            for (uint32_t c = begin; c < end; c++) {
+                // the table is far larger than the caches, fetch the slots
+                // of the corners ahead while probing this one
+                if (c + PREFETCH_DISTANCE < end) {
+                    __builtin_prefetch(&table[slotOf[c + PREFETCH_DISTANCE]]);
+                }
+                size_t slot = slotOf[c];
+                while (true) {
+                    uint32_t current = table[slot].load();
+                    if (current == 0) {
+                        if (table[slot].compare_exchange_weak(current, c + 1)) {
+                            break;
+                        }
+                        // claimed in the meantime, compare against it
+                        continue;
+                    }
+                    if (keys[current - 1] == keys[c]) {
+                        while (c + 1 < current
+                               && !table[slot].compare_exchange_weak(
+                                   current, c + 1
+                               )) {
+                        }
+                        break;
+                    }
+                    slot = (slot + 1) & mask;
+                }
+                slotOf[c] = (uint32_t)slot;
+            }
+        }
+    );
+    // the first corner of `c`'s key, once all corners are in
+    auto firstCorner = [&](uint32_t c) {
+        return table[slotOf[c]].load(std::memory_order_relaxed) - 1;
+    };
+
+    // number the vertices in the order their first corner appears
+    const uint32_t numBatches = (numCorners + BATCH_SIZE - 1) / BATCH_SIZE;
+    std::vector<uint32_t> batchVertexBase(numBatches + 1, 0);
+    parallelFor(
+        jobSystem,
+        numCorners,
+        BATCH_SIZE,
+        [&](uint32_t begin, uint32_t end) {
+            uint32_t count = 0;
+            for (uint32_t c = begin; c < end; c++) {
+                count += firstCorner(c) == c;
+            }
+            batchVertexBase[begin / BATCH_SIZE + 1] = count;
+        }
+    );
+    for (uint32_t i = 0; i < numBatches; i++) {
+        batchVertexBase[i + 1] += batchVertexBase[i];
+    }
+    vertices.assign(batchVertexBase[numBatches], Vertex(glm::vec3(0.f)));
+    // vertex of each first corner
+    std::vector<uint32_t> vertexOf(numCorners);
+    parallelFor(
+        jobSystem,
+        numCorners,
+        BATCH_SIZE,
+        [&](uint32_t begin, uint32_t end) {
+            uint32_t vertex = batchVertexBase[begin / BATCH_SIZE];
+            for (uint32_t c = begin; c < end; c++) {
+                if (firstCorner(c) != c) {
+                    continue;
+                }
+                const Key& key = keys[c];
+                Vertex& v = vertices[vertex];
+                v.pos = glm::vec3(
+                    key.position[0], key.position[1], key.position[2]
+                );
+                v.color = glm::vec3(1.f);
+                v.texCoord = glm::vec2(key.texCoord[0], key.texCoord[1]);
+                v.normal = glm::vec3(0.f);
+                vertexOf[c] = vertex++;
+            }
+        }
+    );
+    indices.resize(numCorners);
+    parallelFor(
+        jobSystem,
+        numCorners,
+        BATCH_SIZE,
+        [&](uint32_t begin, uint32_t end) {
+            for (uint32_t c = begin; c < end; c++) {
+                indices[c] = vertexOf[firstCorner(c)];
+            }
+        }
+    );
+
+    // normals: the faces' normals in one flat pass, then each vertex sums
+    // those of its faces, in face order as a sequential pass would
+    const uint32_t numTriangles = numCorners / 3;
+    std::vector<glm::vec3> faceNormals(numTriangles);
+    parallelFor(
+        jobSystem,
+        numTriangles,
+        BATCH_SIZE,
+        [&](uint32_t begin, uint32_t end) {
+            for (uint32_t t = begin; t < end; t++) {
+                const glm::vec3 p0 = vertices[indices[3 * t + 0]].pos;
+                const glm::vec3 p1 = vertices[indices[3 * t + 1]].pos;
+                const glm::vec3 p2 = vertices[indices[3 * t + 2]].pos;
+                // zero-area faces have no direction, they add nothing to
+                // their vertices' normals
+                const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+                const float length2 = glm::dot(normal, normal);
+                faceNormals[t] = length2 > 0.f
+                                     ? normal / std::sqrt(length2)
+                                     : glm::vec3(0.f);
+            }
+        }
+    );
+    // faces of each vertex, [faceBegin[v], faceBegin[v + 1]) of `faces`
+    std::vector<uint32_t> faceBegin(vertices.size() + 1, 0);
+    for (uint32_t index : indices) {
+        faceBegin[index + 1]++;
+    }
+    for (size_t v = 0; v < vertices.size(); v++) {
+        faceBegin[v + 1] += faceBegin[v];
+    }
+    std::vector<uint32_t> faces(indices.size());
+    {
+        std::vector<uint32_t> cursor(faceBegin.begin(), faceBegin.end() - 1);
+        for (uint32_t i = 0; i < numTriangles * 3; i++) {
+            faces[cursor[indices[i]]++] = i / 3;
+        }
+    }
+    parallelFor(
+        jobSystem,
+        vertices.size(),
+        BATCH_SIZE,
+        [&](uint32_t begin, uint32_t end) {
+            for (uint32_t v = begin; v < end; v++) {
+                glm::vec3 normal(0.f);
+                for (uint32_t f = faceBegin[v]; f < faceBegin[v + 1]; f++) {
+                    normal += faceNormals[faces[f]];
+                }
+                // vertices only on degenerate faces, or on faces that
+                // cancel out, get a default rather than a NaN normal
+                const float length2 = glm::dot(normal, normal);
+                vertices[v].normal = length2 > 0.f
+                                         ? normal / std::sqrt(length2)
+                                         : DEFAULT_NORMAL;
+            }
+        }
+    );
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "structs/Vertex.h"
+
+class JobSystem;
+
+namespace ObjLoader
+{
+// Parse the OBJ file at `path` into a triangle list: polygons are fanned into
+// triangles, vertices with the same position and texture coordinate are
+// merged, and normals are averaged from the faces around each vertex.
+//
+// With `jobSystem`, the file is split into chunks of whole lines parsed in
+// parallel, and deduplication and normals run in parallel as well. The result
+// is the same as parsing on a single thread: vertices are numbered in the
+// order they first appear in the file.
+//
+// Supports `v`, `vt` and `f` statements, with negative (relative) indices;
+// everything else, including the file's normals, is ignored.
+void Load(
+    const char* path,
+    std::vector<Vertex>& vertices,
+    std::vector<uint32_t>& indices,
+    JobSystem* jobSystem = nullptr
+);
+} // namespace ObjLoader
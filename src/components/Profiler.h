@@ -38,6 +38,13 @@ class Profiler
         int level;
     };
 
+    // a value sampled once per profile, e.g. the # of culled objects
+    struct Counter
+    {
+        const char* name;
+        uint64_t value;
+    };
+
     Profiler() {
         _currEntryLevel = 0;
         _profileData = std::make_unique<std::vector<Profiler::Entry>>();
@@ -72,9 +79,35 @@ class Profiler
         return lastProfileData;
     }
 
+    void Count(const char* name, uint64_t value) {
+        _counters.push_back({name, value});
+    }
+
+    // Clears all counters, returns all counters that has been recorded since
+    // the last call
+    std::vector<Profiler::Counter> NewCounters() {
+        std::vector<Profiler::Counter> lastCounters = std::move(_counters);
+        _counters.clear();
+        return lastCounters;
+    }
+
+    // Nest entries recorded by another profiler -- e.g. one owned by a worker
+    // thread -- under the currently open scope.
+    void Append(const std::vector<Profiler::Entry>& entries) {
+        for (Entry entry : entries) {
+            entry.level += _currEntryLevel;
+            _profileData->push_back(entry);
+        }
+    }
+
+    void Append(const std::vector<Profiler::Counter>& counters) {
+        _counters.insert(_counters.end(), counters.begin(), counters.end());
+    }
+
   private:
     int _currEntryLevel = 0;
     std::unique_ptr<std::vector<Profiler::Entry>> _profileData;
+    std::vector<Profiler::Counter> _counters;
 };
 
 // profiler macros
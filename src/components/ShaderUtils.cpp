@@ -1,7 +1,16 @@
 #include "ShaderUtils.h"
+#include <filesystem>
 #include <vulkan/vulkan_core.h>
 
 VkShaderModule ShaderCreation::createShaderModule(VkDevice logicalDevice, const char* shaderCodeFile) {
+#ifdef SHADER_BINARY_DIR
+    // the build compiled the current sources, prefer those over the committed binaries
+    const std::string builtFile
+        = (std::filesystem::path(SHADER_BINARY_DIR) / std::filesystem::path(shaderCodeFile).filename()).string();
+    if (std::filesystem::exists(builtFile)) {
+        shaderCodeFile = builtFile.c_str();
+    }
+#endif
     std::vector<char> shaderCode;
     try {
         shaderCode = readFile(shaderCodeFile);
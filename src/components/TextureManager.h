@@ -1,5 +1,7 @@
 #pragma once
 #include <vulkan/vulkan_core.h>
+
+#include "lib/VQAllocator.h"
 class VQDevice;
 
 // TODO: use a single command buffe for higher throughput; may implement our own command buffer "buffer".
@@ -25,15 +27,10 @@ class TextureManager
     {
         VkImage textureImage;
         VkImageView textureImageView;
-        VkDeviceMemory textureImageMemory; // gpu memory that holds the image.
+        VQAllocation textureImageMemory; // gpu memory that holds the image.
         VkSampler textureSampler;          // sampler for shaders
     };
 
-    void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout);
-
-    // copy over content  in the staging buffer to the actual image
-    void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
-
     std::unordered_map<std::string, __TextureInternal> _textures; // image path -> texture obj
     std::shared_ptr<VQDevice> _device;
 };
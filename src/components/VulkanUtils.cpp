@@ -1,42 +1,6 @@
 #include "VulkanUtils.h"
 #include <vulkan/vulkan_core.h>
 
-VkCommandBuffer VulkanUtils::beginSingleTimeCommands(VkDevice device, VkCommandPool commandPool) {
-    VkCommandBufferAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandPool = commandPool;
-    allocInfo.commandBufferCount = 1;
-
-    VkCommandBuffer commandBuffer;
-    vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer);
-
-    VkCommandBufferBeginInfo beginInfo{};
-    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-    vkBeginCommandBuffer(commandBuffer, &beginInfo);
-
-    return commandBuffer;
-}
-
-void VulkanUtils::endSingleTimeCommands(
-    VkCommandBuffer commandBuffer,
-    VkDevice device,
-    VkQueue graphicsQueue,
-    VkCommandPool commandPool
-) {
-    vkEndCommandBuffer(commandBuffer);
-
-    VkSubmitInfo submitInfo{};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffer;
-
-    vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(graphicsQueue);
-
-    vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
 }
 
 void VulkanUtils::createCommandBuffers(
@@ -110,30 +74,6 @@ uint32_t VulkanUtils::findMemoryType(
     FATAL("Failed to find suitable memory type!");
 }
 
-void VulkanUtils::vkMemCopy(void* src, VkDeviceMemory dstMemory, VkDeviceSize size, VkDevice dstDevice) {
-    void* data;
-    vkMapMemory(dstDevice, dstMemory, 0, size, 0, &data);
-    memcpy(data, src, static_cast<size_t>(size));
-    vkUnmapMemory(dstDevice, dstMemory);
-}
-
-void VulkanUtils::copyBuffer(
-    VkDevice device,
-    VkCommandPool commandPool,
-    VkQueue queue,
-    VkBuffer srcBuffer,
-    VkBuffer dstBuffer,
-    VkDeviceSize size
-) {
-    VkCommandBuffer commandBuffer = beginSingleTimeCommands(device, commandPool);
-
-    VkBufferCopy copyRegion{};
-    copyRegion.size = size;
-    vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
-
-    endSingleTimeCommands(commandBuffer, device, queue, commandPool);
-}
-
 VkImageView VulkanUtils::createImageView(
     VkImage& textureImage,
     VkDevice& logicalDevice,
@@ -168,9 +108,8 @@ void VulkanUtils::createImage(
     VkImageUsageFlags usage,
     VkMemoryPropertyFlags properties,
     VkImage& image,
-    VkDeviceMemory& imageMemory,
-    VkPhysicalDevice physicalDevice,
-    VkDevice logicalDevice
+    VQAllocation& imageAllocation,
+    VQDevice& device
 ) {
     VkImageCreateInfo imageInfo{};
     imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -187,23 +126,11 @@ void VulkanUtils::createImage(
     imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
     imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-    if (vkCreateImage(logicalDevice, &imageInfo, nullptr, &image) != VK_SUCCESS) {
+    if (vkCreateImage(device.logicalDevice, &imageInfo, nullptr, &image) != VK_SUCCESS) {
         throw std::runtime_error("failed to create image!");
     }
 
-    VkMemoryRequirements memRequirements;
-    vkGetImageMemoryRequirements(logicalDevice, image, &memRequirements);
-
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = VulkanUtils::findMemoryType(physicalDevice, memRequirements.memoryTypeBits, properties);
-
-    if (vkAllocateMemory(logicalDevice, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-        FATAL("Failed to allocate image memory!");
-    }
-
-    vkBindImageMemory(logicalDevice, image, imageMemory, 0);
+    imageAllocation = device.allocator.AllocateForImage(image, tiling, properties);
 }
 
 VkFormat VulkanUtils::findDepthFormat(VkPhysicalDevice physicalDevice) {
@@ -233,33 +160,3 @@ VkFormat VulkanUtils::findBestFormat(
     FATAL("Failed tot find format!");
     return VK_FORMAT_R8G8B8A8_SRGB; // unreacheable
 };
-
-VulkanUtils::QuickCommandBuffer::QuickCommandBuffer(std::shared_ptr<VQDevice> device) : device(device) {
-    VkCommandBufferAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandPool = device->graphicsCommandPool;
-    allocInfo.commandBufferCount = 1;
-
-    vkAllocateCommandBuffers(device->logicalDevice, &allocInfo, &cmdBuffer);
-
-    VkCommandBufferBeginInfo beginInfo{};
-    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-    vkBeginCommandBuffer(cmdBuffer, &beginInfo);
-}
-
-VulkanUtils::QuickCommandBuffer::~QuickCommandBuffer() {
-    vkEndCommandBuffer(cmdBuffer);
-
-    VkSubmitInfo submitInfo{};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &cmdBuffer;
-
-    vkQueueSubmit(device->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(device->graphicsQueue);
-
-    vkFreeCommandBuffers(device->logicalDevice, device->graphicsCommandPool, 1, &cmdBuffer);
-}
@@ -6,31 +6,6 @@
 
 namespace VulkanUtils
 {
-/**
- * @brief RAII command buffer wrapper. Use it the same way you do for lock_guard.
- *
- */
-struct QuickCommandBuffer
-{
-    QuickCommandBuffer(std::shared_ptr<VQDevice> device);
-
-    ~QuickCommandBuffer();
-
-    VkCommandBuffer cmdBuffer;
-
-  private:
-    std::shared_ptr<VQDevice> device;
-};
-
-VkCommandBuffer beginSingleTimeCommands(VkDevice device, VkCommandPool commandPool);
-
-void endSingleTimeCommands(
-    VkCommandBuffer commandBuffer,
-    VkDevice device,
-    VkQueue graphicsQueue,
-    VkCommandPool commandPool
-);
-
 void createCommandPool(
     VkCommandPool* commandPool,
     VkCommandPoolCreateFlags flags,
@@ -71,17 +46,6 @@ void createCommandPoolAndBuffers(
  */
 uint32_t findMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeFilter, VkMemoryPropertyFlags properties);
 
-void vkMemCopy(void* src, VkDeviceMemory dstMemory, VkDeviceSize size, VkDevice dstDevice);
-
-void copyBuffer(
-    VkDevice device,
-    VkCommandPool commandPool,
-    VkQueue queue,
-    VkBuffer srcBuffer,
-    VkBuffer dstBuffer,
-    VkDeviceSize size
-);
-
 VkImageView createImageView(
     VkImage& textureImage,
     VkDevice& logicalDevice,
@@ -106,9 +70,8 @@ void createImage(
     VkImageUsageFlags usage,
     VkMemoryPropertyFlags properties,
     VkImage& image,
-    VkDeviceMemory& imageMemory,
-    VkPhysicalDevice physicalDevice,
-    VkDevice logicalDevice
+    VQAllocation& imageAllocation,
+    VQDevice& device
 );
 
 } // namespace VulkanUtils
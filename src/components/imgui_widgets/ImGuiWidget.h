@@ -44,6 +44,8 @@ class ImGuiWidgetPerfPlot : public ImGuiWidget
     };
 
     std::map<const char*, ScrollingBuffer> _scrollingBuffers;
+    // GPU scope names may collide with CPU ones, keep them apart
+    std::map<const char*, ScrollingBuffer> _gpuScrollingBuffers;
 
     // shows the profiler plot; note on
     // lower-end systems the profiler plot itself consumes
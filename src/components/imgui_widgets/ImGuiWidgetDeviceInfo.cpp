@@ -16,6 +16,51 @@ void ImGuiWidgetDeviceInfo::Draw(const VulkanEngine* engine) {
             ImGui::Text("%s", extension);
         }
         ImGui::Indent(-INDENT);
+        const QueueFamilyIndices& families = device->queueFamilyIndices;
+        ImGui::Text(
+            "Transfer queue: %s",
+            device->HasDedicatedTransferQueue() ? "dedicated" : "graphics"
+        );
+        ImGui::Text(
+            "Compute queue: %s",
+            families.computeFamily != families.graphicsFamily ? "async"
+                                                              : "graphics"
+        );
+    }
+    { // Memory
+        ImGui::SeparatorText("Memory");
+        const float MiB = 1024.f * 1024.f;
+        std::vector<VQAllocator::HeapStats> heaps
+            = engine->_device->allocator.GetHeapStats();
+        for (size_t i = 0; i < heaps.size(); i++) {
+            const VQAllocator::HeapStats& heap = heaps[i];
+            ImGui::Text(
+                "Heap %zu: %.0f MiB%s",
+                i,
+                heap.heapSize / MiB,
+                heap.heapFlags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT
+                    ? ", device local"
+                    : ""
+            );
+            ImGui::Indent(INDENT);
+            ImGui::Text(
+                "Allocated: %.1f MiB, used: %.1f MiB",
+                heap.allocatedBytes / MiB,
+                heap.usedBytes / MiB
+            );
+            ImGui::Text(
+                "Blocks: %u, allocations: %u, dedicated: %u",
+                heap.blockCount,
+                heap.allocationCount,
+                heap.dedicatedAllocationCount
+            );
+            ImGui::Text(
+                "Largest free range: %.1f MiB, fragmentation: %.0f%%",
+                heap.largestFreeRange / MiB,
+                heap.GetFragmentation() * 100.f
+            );
+            ImGui::Indent(-INDENT);
+        }
     }
     { // Display
         ImGui::SeparatorText("Display");
@@ -99,6 +99,57 @@ void ImGuiWidgetPerfPlot::Draw(const VulkanEngine* engine) {
             }
         }
     }
+
+    if (!engine->_lastProfilerCounters.empty()) {
+        ImGui::SeparatorText("Counters");
+    }
+    for (const Profiler::Counter& counter : engine->_lastProfilerCounters) {
+        ImGui::Text("%s: %llu", counter.name, (unsigned long long)counter.value);
+    }
+
+    // GPU entries, read back NUM_FRAME_IN_FLIGHT frames late
+    const std::vector<GPUProfiler::Entry>& gpuEntries
+        = engine->_gpuProfiler.GetLastProfile();
+    if (!gpuEntries.empty()) {
+        ImGui::SeparatorText("GPU");
+    }
+    for (const GPUProfiler::Entry& entry : gpuEntries) {
+        if (showingPlot) {
+            auto it = _gpuScrollingBuffers.find(entry.name);
+            if (it == _gpuScrollingBuffers.end()) {
+                auto res = _gpuScrollingBuffers.emplace(
+                    entry.name, ScrollingBuffer()
+                );
+                ASSERT(res.second); // insertion success
+                it = res.first;
+            }
+            ScrollingBuffer& buf = it->second;
+
+            buf.AddPoint(engine->_timeSinceStartSeconds, entry.ms);
+            std::string label = fmt::format("GPU: {}", entry.name);
+            ImPlot::PlotLine(
+                label.c_str(),
+                &buf.Data[0].x,
+                &buf.Data[0].y,
+                buf.Data.size(),
+                0,
+                buf.Offset,
+                2 * sizeof(float)
+            );
+        }
+        { // text section
+            int indentWidth = entry.level * 10;
+            if (indentWidth != 0) {
+                ImGui::Indent(indentWidth);
+            }
+            ImGui::Text("%s", entry.name);
+            ImGui::Text("%f MS", entry.ms);
+            if (indentWidth != 0) {
+                ImGui::Unindent(indentWidth);
+            }
+        }
+    }
+
     if (showingPlot) {
         ImPlot::EndPlot();
     }
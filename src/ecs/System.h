@@ -1,4 +1,6 @@
 #pragma once
+#include <typeindex>
+#include <unordered_set>
 
 #include "structs/SharedEngineStructs.h"
 
@@ -25,20 +27,58 @@ class ISystem
     // TODO: handle entity removal
     // may need to make entity point to systems
 
+    // component types read and written in `Tick()`, and system types that
+    // must tick before this one; see `SystemManager`
+    const std::unordered_set<std::type_index>& GetReads() const {
+        return _reads;
+    }
+
+    const std::unordered_set<std::type_index>& GetWrites() const {
+        return _writes;
+    }
+
+    const std::unordered_set<std::type_index>& GetRunsAfter() const {
+        return _runsAfter;
+    }
+
   protected:
+    // Scheduling declarations, to be made in the constructor.
+    // Systems that write a component type the other reads or writes never
+    // tick concurrently.
+    template <typename T>
+    void Reads() {
+        _reads.insert(typeid(T));
+    }
+
+    template <typename T>
+    void Writes() {
+        _writes.insert(typeid(T));
+    }
+
+    // tick after system `T` within the same phase
+    template <typename T>
+    void RunsAfter() {
+        _runsAfter.insert(typeid(T));
+    }
+
     std::vector<Entity*> _entities;
+
+  private:
+    std::unordered_set<std::type_index> _reads;
+    std::unordered_set<std::type_index> _writes;
+    std::unordered_set<std::type_index> _runsAfter;
 };
 
 // System that supports ImGui drawing
 // Overload DrawImGui() to draw imgui elements
-class ImGuiSystem : public ISystem
+class ImGuiSystem : public virtual ISystem
 {
   public:
     virtual void DrawImGui() = 0;
 };
 
 // System that works as-is and does not need entity at all.
-class ISingletonSystem : public ISystem
+class ISingletonSystem : public virtual ISystem
 {
     virtual void AddEntity(Entity* entity) override {
         FATAL("Singleton systems cannot have entities");
@@ -46,8 +86,27 @@ class ISingletonSystem : public ISystem
 };
 
 // system that belongs to the graphics render pass.
-// each system has its own pipeline and own render logic
-class IRenderSystem : public ISystem
+// each system has its own pipeline and own render logic.
+// `Tick()` records into a secondary command buffer of the main render pass,
+// see `SystemManager::TickRender()`
+class IRenderSystem : public virtual ISystem
 {
+  public:
+    // record work that `Tick()` depends on, e.g. compute dispatches, into the
+    // frame's primary command buffer ahead of the main render pass.
+    // Called for every render system before any of them ticks, on the
+    // rendering thread; see `SystemManager::PrepareRender()`
+    virtual void PrepareFrame(const TickContext* tickData) {}
+
+    // Late pass of two-phase occlusion culling, for systems that return true
+    // from `HasLatePass()`. Once everything `Tick()` drew is in the depth
+    // pyramid, `PrepareLateFrame()` records into the primary command buffer,
+    // and `TickLate()` into a secondary of the resumed main render pass.
+    virtual bool HasLatePass() const { return false; }
+
+    virtual void PrepareLateFrame(const TickContext* tickData) {}
+
+    virtual void TickLate(const TickContext* tickData) {}
+
   protected:
 };
@@ -0,0 +1,226 @@
+#include "SystemManager.h"
+#include "components/JobSystem.h"
+#include "components/Profiler.h"
+
+void SystemManager::Init(const InitContext* initData) {
+    for (Node& node : _nodes) {
+        node.system->Init(initData);
+    }
+}
+
+void SystemManager::Cleanup() {
+    for (auto it = _nodes.rbegin(); it != _nodes.rend(); it++) {
+        it->system->Cleanup();
+        delete it->system;
+    }
+    _nodes.clear();
+    _systemsByType.clear();
+}
+
+size_t SystemManager::GetNumRenderSystems() const {
+    size_t numRenderSystems = 0;
+    for (const Node& node : _nodes) {
+        numRenderSystems += inPhase(node, Phase::RENDER);
+    }
+    return numRenderSystems;
+}
+
+size_t SystemManager::GetNumLateRenderSystems() const {
+    size_t numLateRenderSystems = 0;
+    for (const Node& node : _nodes) {
+        numLateRenderSystems += inPhase(node, Phase::RENDER_LATE);
+    }
+    return numLateRenderSystems;
+}
+
+bool SystemManager::inPhase(const Node& node, Phase phase) const {
+    switch (phase) {
+    case Phase::COMPUTE:
+        return node.renderSystem == nullptr;
+    case Phase::RENDER:
+        return node.renderSystem != nullptr;
+    case Phase::RENDER_LATE:
+        return node.renderSystem != nullptr
+               && node.renderSystem->HasLatePass();
+    }
+    return false;
+}
+
+void SystemManager::TickCompute(const TickContext* tickData) {
+    PROFILE_SCOPE(tickData->profiler, "Compute Systems");
+    Graph graph = buildGraph(Phase::COMPUTE);
+    runGraph(graph, tickData, [&](uint32_t position, const TickContext* ctx) {
+        _nodes[graph.order[position]].system->Tick(ctx);
+    });
+}
+
+void SystemManager::PrepareRender(const TickContext* tickData) {
+    PROFILE_SCOPE(tickData->profiler, "Prepare Render Systems");
+    // all systems record into the same command buffer, so they can't run
+    // concurrently
+    for (size_t node : buildGraph(Phase::RENDER).order) {
+        _nodes[node].renderSystem->PrepareFrame(tickData);
+    }
+}
+
+void SystemManager::TickRender(
+    const TickContext* tickData,
+    const RenderTickFunction& tick
+) {
+    PROFILE_SCOPE(tickData->profiler, "Render Systems");
+    Graph graph = buildGraph(Phase::RENDER);
+    runGraph(graph, tickData, [&](uint32_t position, const TickContext* ctx) {
+        tick(_nodes[graph.order[position]].renderSystem, ctx, position);
+    });
+}
+
+void SystemManager::PrepareRenderLate(const TickContext* tickData) {
+    PROFILE_SCOPE(tickData->profiler, "Prepare Late Render Systems");
+    for (size_t node : buildGraph(Phase::RENDER_LATE).order) {
+        _nodes[node].renderSystem->PrepareLateFrame(tickData);
+    }
+}
+
+void SystemManager::TickRenderLate(
+    const TickContext* tickData,
+    const RenderTickFunction& tick
+) {
+    PROFILE_SCOPE(tickData->profiler, "Late Render Systems");
+    Graph graph = buildGraph(Phase::RENDER_LATE);
+    runGraph(graph, tickData, [&](uint32_t position, const TickContext* ctx) {
+        tick(_nodes[graph.order[position]].renderSystem, ctx, position);
+    });
+}
+
+SystemManager::Graph SystemManager::buildGraph(Phase phaseType) const {
+    std::vector<size_t> phase; // the phase's systems, in the order added
+    for (size_t i = 0; i < _nodes.size(); i++) {
+        if (inPhase(_nodes[i], phaseType)) {
+            phase.push_back(i);
+        }
+    }
+
+    // does system `a` have to run after system `b`?
+    auto runsAfter = [this](size_t a, size_t b) {
+        for (const std::type_index& type : _nodes[a].system->GetRunsAfter()) {
+            auto it = _systemsByType.find(type);
+            if (it != _systemsByType.end() && it->second == b) {
+                return true;
+            }
+        }
+        return false;
+    };
+    auto overlaps = [](const std::unordered_set<std::type_index>& a,
+                       const std::unordered_set<std::type_index>& b) {
+        for (const std::type_index& type : a) {
+            if (b.count(type)) {
+                return true;
+            }
+        }
+        return false;
+    };
+    auto conflicts = [&](size_t a, size_t b) {
+        const ISystem* sa = _nodes[a].system;
+        const ISystem* sb = _nodes[b].system;
+        return overlaps(sa->GetWrites(), sb->GetWrites())
+               || overlaps(sa->GetWrites(), sb->GetReads())
+               || overlaps(sa->GetReads(), sb->GetWrites());
+    };
+
+    // topologically sort by the explicit constraints; among the systems ready
+    // to run, the earliest added goes first, so that the order is stable
+    Graph graph;
+    std::vector<bool> placed(phase.size(), false);
+    while (graph.order.size() < phase.size()) {
+        bool progress = false;
+        for (size_t i = 0; i < phase.size() && !progress; i++) {
+            if (placed[i]) {
+                continue;
+            }
+            bool ready = true;
+            for (size_t j = 0; j < phase.size() && ready; j++) {
+                ready = placed[j] || j == i || !runsAfter(phase[i], phase[j]);
+            }
+            if (ready) {
+                placed[i] = true;
+                graph.order.push_back(phase[i]);
+                progress = true;
+            }
+        }
+        if (!progress) {
+            FATAL("Cyclic RunsAfter() constraints between systems");
+        }
+    }
+
+    // an edge goes from every earlier system to every later system that has
+    // to run after it, or that conflicts with it
+    graph.successors.resize(phase.size());
+    graph.numDependencies.resize(phase.size(), 0);
+    for (uint32_t a = 0; a < graph.order.size(); a++) {
+        for (uint32_t b = a + 1; b < graph.order.size(); b++) {
+            size_t nodeA = graph.order[a];
+            size_t nodeB = graph.order[b];
+            if (runsAfter(nodeB, nodeA) || conflicts(nodeA, nodeB)) {
+                graph.successors[a].push_back(b);
+                graph.numDependencies[b]++;
+            }
+        }
+    }
+    return graph;
+}
+
+void SystemManager::runGraph(
+    const Graph& graph,
+    const TickContext* tickData,
+    const std::function<void(uint32_t, const TickContext*)>& tick
+) {
+    // `Profiler` isn't thread-safe, each system profiles into its own
+    std::vector<Profiler> profilers(graph.order.size());
+    auto tickSystem = [&](uint32_t position) {
+        TickContext ctx = *tickData;
+        ctx.profiler = &profilers[position];
+        PROFILE_SCOPE(ctx.profiler, _nodes[graph.order[position]].name);
+        tick(position, &ctx);
+    };
+
+    JobSystem* jobSystem = tickData->jobSystem;
+    if (jobSystem == nullptr) {
+        // the topological order satisfies all edges
+        for (uint32_t position = 0; position < graph.order.size(); position++) {
+            tickSystem(position);
+        }
+    } else {
+        std::unique_ptr<std::atomic<uint32_t>[]> numPending(
+            new std::atomic<uint32_t>[graph.order.size()]
+        );
+        for (uint32_t position = 0; position < graph.order.size(); position++) {
+            numPending[position] = graph.numDependencies[position];
+        }
+        // a system schedules the successors whose last dependency it was.
+        // They become child jobs, so `counter` covers them.
+        std::function<void(uint32_t)> run = [&](uint32_t position) {
+            tickSystem(position);
+            for (uint32_t successor : graph.successors[position]) {
+                if (--numPending[successor] == 0) {
+                    jobSystem->Schedule(nullptr, [&run, successor]() {
+                        run(successor);
+                    });
+                }
+            }
+        };
+        JobSystem::Counter counter;
+        for (uint32_t position = 0; position < graph.order.size(); position++) {
+            if (graph.numDependencies[position] == 0) {
+                jobSystem->Schedule(
+                    nullptr, [&run, position]() { run(position); }, &counter
+                );
+            }
+        }
+        jobSystem->Wait(&counter);
+    }
+
+    for (Profiler& profiler : profilers) {
+        tickData->profiler->Append(*profiler.NewProfile());
+        tickData->profiler->Append(profiler.NewCounters());
+    }
+}
@@ -1,24 +1,122 @@
 #pragma once
+#include <functional>
+#include <typeindex>
+
 #include "System.h"
 
+// Owns all systems and ticks them in two phases. The compute phase ticks every
+// system that isn't an `IRenderSystem`; the render phase then ticks every
+// render system, each into its own secondary command buffer. Render systems
+// with a late pass tick once more in the late render phase, see
+// `IRenderSystem::HasLatePass()`.
+//
+// Every tick, each phase is built into a DAG: a system depends on the systems
+// it `RunsAfter()`, and on every earlier-added system whose component reads
+// and writes conflict with its own. Systems without a path between them tick
+// concurrently on the job system. Each `Tick()` gets a profiler scope of the
+// system's name.
 class SystemManager
 {
   public:
-    enum class SystemType
-    {
-        ComputeSystem,
-        RenderSystem
-    };
+    // Ticks a render system, e.g. into a secondary command buffer. `order` is
+    // the system's position in the render phase's execution order, in which
+    // the recorded commands should be executed.
+    using RenderTickFunction = std::function<
+        void(IRenderSystem* system, const TickContext* ctx, uint32_t order)>;
 
-    void AddSystem(ISystem* system) { _renderSystems.push_back(system); }
+    // create a system of type `T`, owned by the manager
+    template <typename T, typename... Args>
+    T* AddSystem(const char* name, Args&&... args) {
+        if (_systemsByType.find(typeid(T)) != _systemsByType.end()) {
+            FATAL("System {} is already added", name);
+        }
+        T* system = new T(std::forward<Args>(args)...);
+        Node node{name, system, nullptr, system};
+        if constexpr (std::is_base_of_v<IRenderSystem, T>) {
+            node.renderSystem = system;
+        }
+        _systemsByType.emplace(typeid(T), _nodes.size());
+        _nodes.push_back(node);
+        return system;
+    }
 
-    void TickRender(const TickData* tickData) {
-        for (ISystem* system : _renderSystems) {
-            system->Tick(tickData);
+    // returns nullptr if no system of type `T` was added
+    template <typename T>
+    T* GetSystem() const {
+        auto it = _systemsByType.find(typeid(T));
+        if (it == _systemsByType.end()) {
+            return nullptr;
         }
+        return static_cast<T*>(_nodes[it->second].instance);
     }
 
+    // Init all systems, in the order they were added
+    void Init(const InitContext* initData);
+
+    // Clean up and destroy all systems, in reverse order
+    void Cleanup();
+
+    // Tick the compute phase, returns once all its systems ticked
+    void TickCompute(const TickContext* tickData);
+
+    // Let every render system record into `tickData->graphics.CB` before the
+    // main render pass, sequentially in the render phase's order
+    void PrepareRender(const TickContext* tickData);
+
+    // Tick the render phase through `tick`, returns once all its systems
+    // ticked
+    void TickRender(
+        const TickContext* tickData,
+        const RenderTickFunction& tick
+    );
+
+    // `PrepareRender()` and `TickRender()` of the late render phase, where
+    // `tick` should call `IRenderSystem::TickLate()`
+    void PrepareRenderLate(const TickContext* tickData);
+    void TickRenderLate(
+        const TickContext* tickData,
+        const RenderTickFunction& tick
+    );
+
+    size_t GetNumRenderSystems() const;
+    size_t GetNumLateRenderSystems() const;
+
   private:
-    std::vector<ISystem*> _renderSystems;
-    std::vector<ISystem*> _computeSystems;
+    enum class Phase
+    {
+        COMPUTE,
+        RENDER,
+        RENDER_LATE
+    };
+
+    struct Node
+    {
+        const char* name;
+        ISystem* system;
+        IRenderSystem* renderSystem; // nullptr for compute phase systems
+        void* instance;              // the system as its own type
+    };
+
+    // a phase's systems in topological order, with their dependency edges
+    struct Graph
+    {
+        std::vector<size_t> order;                     // indices into `_nodes`
+        std::vector<std::vector<uint32_t>> successors; // by position in order
+        std::vector<uint32_t> numDependencies;         // by position in order
+    };
+
+    bool inPhase(const Node& node, Phase phase) const;
+
+    Graph buildGraph(Phase phase) const;
+
+    // Run `tick(position, ctx)` for every system of `graph` once all its
+    // dependencies ran, on the job system if `tickData` has one.
+    void runGraph(
+        const Graph& graph,
+        const TickContext* tickData,
+        const std::function<void(uint32_t, const TickContext*)>& tick
+    );
+
+    std::vector<Node> _nodes; // in the order the systems were added
+    std::unordered_map<std::type_index, size_t> _systemsByType;
 };
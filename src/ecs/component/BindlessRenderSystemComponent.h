@@ -1,8 +1,18 @@
 #pragma once
+#include <cstdint>
+
 #include "ecs/Component.h"
 
 class BindlessRenderSystem;
 
+// generational handle of a bindless instance: it addresses a slot of the
+// system, and is only valid while `generation` matches the slot's
+struct BindlessInstanceHandle
+{
+    uint32_t index;
+    uint32_t generation;
+};
+
 struct BindlessRenderSystemComponent : IComponent
 {
     friend BindlessRenderSystem;
@@ -10,5 +20,5 @@ struct BindlessRenderSystemComponent : IComponent
   private:
     BindlessRenderSystemComponent() = default;
     BindlessRenderSystem* parentSystem;
-    int instanceDataOffset; // used to update the instance data
+    BindlessInstanceHandle handle; // used to update the instance data
 };
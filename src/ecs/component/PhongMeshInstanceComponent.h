@@ -6,6 +6,5 @@ struct PhongMesh;
 struct PhongMeshComponent : IComponent
 {
     PhongMesh* mesh;
-    size_t dynamicUBOId; // id, id * sizeof(dynamicUBO) = offset of its own dynamic UBO
     int textureOffset; // index into the texture array
 };
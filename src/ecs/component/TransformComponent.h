@@ -31,6 +31,19 @@ struct TransformComponent : public IComponent
         model = glm::scale(model, scale);
     }
 
+    // rotation of the model matrix, as a quaternion
+    glm::quat GetRotation() const {
+        return glm::angleAxis(
+                   glm::radians(rotation.x), glm::vec3(1.f, 0.f, 0.f)
+               )
+               * glm::angleAxis(
+                   glm::radians(rotation.y), glm::vec3(0.f, 1.f, 0.f)
+               )
+               * glm::angleAxis(
+                   glm::radians(rotation.z), glm::vec3(0.f, 0.f, 1.f)
+               );
+    }
+
     // get model matrix of the transform
     glm::mat4 GetModelMatrix() {
         glm::mat4 model;
@@ -1,3 +1,9 @@
+#include <algorithm>
+#include <limits>
+#include <tuple>
+
+#include "components/GPUProfiler.h"
+#include "components/MeshCache.h"
 #include "components/Profiler.h"
 #include "components/ShaderUtils.h"
 #include "components/VulkanUtils.h"
@@ -6,11 +12,53 @@
 #include "structs/Vertex.h"
 
 #include "components/Camera.h"
+#include "components/DepthPyramid.h"
 #include "components/TextureManager.h"
 
 #include "BindlessRenderSystem.h"
 #include "ecs/component/TransformComponent.h"
 
+namespace
+{
+// Create a descriptor pool holding exactly `numSets` sets of the layout of
+// `bindings`.
+VkDescriptorPool createDescriptorPool(
+    VkDevice device,
+    const VkDescriptorSetLayoutBinding* bindings,
+    size_t bindingCount,
+    uint32_t numSets
+) {
+    std::vector<VkDescriptorPoolSize> poolSizes;
+    for (size_t i = 0; i < bindingCount; i++) {
+        auto it = std::find_if(
+            poolSizes.begin(),
+            poolSizes.end(),
+            [&](const VkDescriptorPoolSize& size) {
+                return size.type == bindings[i].descriptorType;
+            }
+        );
+        if (it == poolSizes.end()) {
+            poolSizes.push_back({bindings[i].descriptorType, 0});
+            it = poolSizes.end() - 1;
+        }
+        it->descriptorCount += bindings[i].descriptorCount * numSets;
+    }
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = poolSizes.size();
+    poolInfo.pPoolSizes = poolSizes.data();
+    poolInfo.maxSets = numSets;
+
+    VkDescriptorPool pool;
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &pool)
+        != VK_SUCCESS) {
+        FATAL("Failed to create descriptor pool!");
+    }
+    return pool;
+}
+} // namespace
+
 // TODO: this is too much repetitive code. IRenderSystem should share some
 // common pipeline creator
 void BindlessRenderSystem::createGraphicsPipeline(
@@ -21,9 +69,9 @@ void BindlessRenderSystem::createGraphicsPipeline(
     DEBUG("Creating descriptor...");
     /////  ---------- descriptor ---------- /////
     VkDescriptorSetLayoutBinding uboStaticBinding{};
-    VkDescriptorSetLayoutBinding samplerLayoutBinding{};
     VkDescriptorSetLayoutBinding instanceDataArrayBinding{};
     VkDescriptorSetLayoutBinding instanceIndexArrayBinding{};
+    VkDescriptorSetLayoutBinding instanceMatrixArrayBinding{};
     { // UBO static -- vertex
         uboStaticBinding.binding = (int)BindingLocation::UBO_STATIC_ENGINE;
         uboStaticBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
@@ -53,23 +101,23 @@ void BindlessRenderSystem::createGraphicsPipeline(
             = VK_SHADER_STAGE_VERTEX_BIT; // only used in vertex shader
         instanceIndexArrayBinding.pImmutableSamplers = nullptr; // Optional
     }
-    { // combined image sampler array -- fragment
-        samplerLayoutBinding.binding = (int)BindingLocation::TEXTURE_SAMPLER;
-        samplerLayoutBinding.descriptorCount = TEXTURE_ARRAY_SIZE;
-        samplerLayoutBinding.descriptorType
-            = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        samplerLayoutBinding.stageFlags
-            = VK_SHADER_STAGE_FRAGMENT_BIT; // only used on fragment shader;
-                                            // (may use for vertex shader for
-                                            // height mapping)
-        samplerLayoutBinding.pImmutableSamplers = nullptr;
+    { // instance matrix array -- vertex
+        instanceMatrixArrayBinding.binding
+            = (int)BindingLocation::INSTANCE_MATRIX;
+        instanceMatrixArrayBinding.descriptorType
+            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        instanceMatrixArrayBinding.descriptorCount
+            = 1; // number of values in the array
+        instanceMatrixArrayBinding.stageFlags
+            = VK_SHADER_STAGE_VERTEX_BIT; // only used in vertex shader
+        instanceMatrixArrayBinding.pImmutableSamplers = nullptr; // Optional
     }
 
     std::array<VkDescriptorSetLayoutBinding, 4> bindings
         = {uboStaticBinding,
-           samplerLayoutBinding,
            instanceDataArrayBinding,
-           instanceIndexArrayBinding};
+           instanceIndexArrayBinding,
+           instanceMatrixArrayBinding};
 
     { // _descriptorSetLayout
         VkDescriptorSetLayoutCreateInfo layoutInfo{};
@@ -93,32 +141,13 @@ void BindlessRenderSystem::createGraphicsPipeline(
         });
     }
 
-    { // _descriptorPool
-        uint32_t numDescriptorPerType
-            = 50; // each render group has its own set of descriptors
-        VkDescriptorPoolSize poolSizes[]
-            = {{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-                static_cast<uint32_t>(numDescriptorPerType)},
-               {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-                static_cast<uint32_t>(numDescriptorPerType)},
-               {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                static_cast<uint32_t>(5000)}}; // to fit all textures
-
-        VkDescriptorPoolCreateInfo poolInfo{};
-        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-        poolInfo.poolSizeCount
-            = sizeof(poolSizes)
-              / sizeof(VkDescriptorPoolSize); // number of pool sizes
-        poolInfo.pPoolSizes = poolSizes;
-        poolInfo.maxSets = NUM_FRAME_IN_FLIGHT * poolInfo.poolSizeCount;
-        poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
-
-        if (vkCreateDescriptorPool(
-                _device->logicalDevice, &poolInfo, nullptr, &_descriptorPool
-            )
-            != VK_SUCCESS) {
-            FATAL("Failed to create descriptor pool!");
-        }
+    { // _descriptorPool, a set per frame in flight
+        _descriptorPool = createDescriptorPool(
+            _device->logicalDevice,
+            bindings.data(),
+            bindings.size(),
+            NUM_FRAME_IN_FLIGHT
+        );
         _deletionStack.push([this]() {
             vkDestroyDescriptorPool(
                 _device->logicalDevice, _descriptorPool, nullptr
@@ -150,65 +179,33 @@ void BindlessRenderSystem::createGraphicsPipeline(
         }
     }
 
+    // the buffers are bound by `updateBufferDescriptorSets()`
     for (size_t i = 0; i < NUM_FRAME_IN_FLIGHT; i++) {
-        std::array<VkWriteDescriptorSet, 3> descriptorWrites{};
-
         // engine ubo static
-        descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[0].dstSet = this->_descriptorSets[i];
-        descriptorWrites[0].dstBinding
-            = (int)BindingLocation::UBO_STATIC_ENGINE;
-        descriptorWrites[0].dstArrayElement = 0;
-        descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        descriptorWrites[0].descriptorCount = 1;
-        descriptorWrites[0].pBufferInfo
+        VkWriteDescriptorSet descriptorWrite{};
+        descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrite.dstSet = this->_descriptorSets[i];
+        descriptorWrite.dstBinding = (int)BindingLocation::UBO_STATIC_ENGINE;
+        descriptorWrite.dstArrayElement = 0;
+        descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        descriptorWrite.descriptorCount = 1;
+        descriptorWrite.pBufferInfo
             = &initData->engineUBOStaticDescriptorBufferInfo[i];
 
-        // instance data
-        VkDescriptorBufferInfo bufferInfoInstanceData{};
-        bufferInfoInstanceData.buffer
-            = _bindlessBuffers[i].instanceDataArray.buffer;
-        bufferInfoInstanceData.offset = 0;
-        bufferInfoInstanceData.range
-            = _bindlessBuffers[i].instanceDataArray.size;
-        descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[1].dstSet = this->_descriptorSets[i];
-        descriptorWrites[1].dstBinding = (int)BindingLocation::INSTANCE_DATA;
-        descriptorWrites[1].dstArrayElement = 0;
-        descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        descriptorWrites[1].descriptorCount = 1;
-        descriptorWrites[1].pBufferInfo = &bufferInfoInstanceData;
-
-        // instance index
-        VkDescriptorBufferInfo bufferInfoInstanceIndex{};
-        bufferInfoInstanceIndex.buffer
-            = _bindlessBuffers[i].instanceIndexArray.buffer;
-        bufferInfoInstanceIndex.offset = 0;
-        bufferInfoInstanceIndex.range
-            = _bindlessBuffers[i].instanceIndexArray.size;
-        descriptorWrites[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[2].dstSet = this->_descriptorSets[i];
-        descriptorWrites[2].dstBinding = (int)BindingLocation::INSTANCE_INDEX;
-        descriptorWrites[2].dstArrayElement = 0;
-        descriptorWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        descriptorWrites[2].descriptorCount = 1;
-        descriptorWrites[2].pBufferInfo = &bufferInfoInstanceIndex;
-
         vkUpdateDescriptorSets(
-            _device->logicalDevice,
-            descriptorWrites.size(),
-            descriptorWrites.data(),
-            0,
-            nullptr
+            _device->logicalDevice, 1, &descriptorWrite, 0, nullptr
         );
     }
 
+    createTextureDescriptorSet();
+
     DEBUG("Setting up shaders...");
 
     /////  ---------- shader ---------- /////
 
     VkShaderModule vertShaderModule = ShaderCreation::createShaderModule(
-        _device->logicalDevice, VERTEX_SHADER_SRC
+        _device->logicalDevice,
+        useBufferDeviceAddress() ? VERTEX_SHADER_BDA_SRC : VERTEX_SHADER_SRC
     );
     VkShaderModule fragShaderModule = ShaderCreation::createShaderModule(
         _device->logicalDevice, FRAGMENT_SHADER_SRC
@@ -243,12 +240,15 @@ void BindlessRenderSystem::createGraphicsPipeline(
         vertexInputInfo.sType
             = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 
-        vertexInputInfo.vertexBindingDescriptionCount = 1;
-        vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-        vertexInputInfo.vertexAttributeDescriptionCount
-            = static_cast<uint32_t>(attributeDescriptions->size());
-        vertexInputInfo.pVertexAttributeDescriptions
-            = attributeDescriptions->data();
+        // the vertex shader pulls the vertices itself through their address
+        if (!useBufferDeviceAddress()) {
+            vertexInputInfo.vertexBindingDescriptionCount = 1;
+            vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+            vertexInputInfo.vertexAttributeDescriptionCount
+                = static_cast<uint32_t>(attributeDescriptions->size());
+            vertexInputInfo.pVertexAttributeDescriptions
+                = attributeDescriptions->data();
+        }
     }
 
     // Input assembly
@@ -336,8 +336,10 @@ void BindlessRenderSystem::createGraphicsPipeline(
                                                    // polygon with fragments
     rasterizer.lineWidth
         = 1.0f; // thickness of lines in terms of number of fragments
-    // rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;    // cull back faces
-    rasterizer.cullMode = VK_CULL_MODE_NONE; // don't cull any faces
+    // the meshlet cull drops back-facing meshlets only if back faces are
+    // culled here as well
+    rasterizer.cullMode
+        = CULL_BACK_FACES ? VK_CULL_MODE_BACK_BIT : VK_CULL_MODE_NONE;
     rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
     rasterizer.depthBiasEnable = VK_FALSE;     // depth biasing
     rasterizer.depthBiasConstantFactor = 0.0f; // optional
@@ -396,11 +398,19 @@ void BindlessRenderSystem::createGraphicsPipeline(
     // pipeline layout - controlling uniform values
     VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
     pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.setLayoutCount = 1;
-    pipelineLayoutInfo.pSetLayouts
-        = &_descriptorSetLayout;                      // bind our own layout
-    pipelineLayoutInfo.pushConstantRangeCount = 0;    // Optional
-    pipelineLayoutInfo.pPushConstantRanges = nullptr; // Optional
+    // our own layout, and the texture array
+    const std::array<VkDescriptorSetLayout, 2> setLayouts
+        = {_descriptorSetLayout, _textureDescriptorSetLayout};
+    pipelineLayoutInfo.setLayoutCount = setLayouts.size();
+    pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+    // the buffer addresses, if the buffers are reached through them
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    pushConstantRange.size = sizeof(DrawPushConstants);
+    if (useBufferDeviceAddress()) {
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    }
 
     if (vkCreatePipelineLayout(
             _device->logicalDevice,
@@ -460,382 +470,1435 @@ void BindlessRenderSystem::createGraphicsPipeline(
     vkDestroyShaderModule(_device->logicalDevice, vertShaderModule, nullptr);
 }
 
-void BindlessRenderSystem::Init(const InitContext* initData) {
-    _device = initData->device;
-    _textureManager = initData->textureManager;
-    createBindlessResources();
-    // create graphics pipeline
-    createGraphicsPipeline(initData->renderPass.mainPass, initData);
-}
+void BindlessRenderSystem::createTextureDescriptorSet() {
+    DEBUG("Creating texture descriptor set...");
+    // update-after-bind lets a texture be written while the frames in flight
+    // use the set, partially bound lets the rest of the array stay unwritten
+    const bool updateAfterBind
+        = _device->enabledFeatures12
+              .descriptorBindingSampledImageUpdateAfterBind;
+    VkDescriptorBindingFlags bindingFlags = 0;
+    if (_device->enabledFeatures12.descriptorBindingPartiallyBound) {
+        bindingFlags |= VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+    }
+    if (updateAfterBind) {
+        bindingFlags |= VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT;
+    }
 
-void BindlessRenderSystem::Cleanup() {
-    DEBUG("Cleaning up...");
-    _deletionStack.flush();
-    DEBUG("Done cleaning up");
-}
+    { // _textureDescriptorSetLayout
+        VkDescriptorSetLayoutBinding samplerLayoutBinding{};
+        samplerLayoutBinding.binding
+            = (int)TextureBindingLocation::TEXTURE_SAMPLER;
+        samplerLayoutBinding.descriptorCount = TEXTURE_ARRAY_SIZE;
+        samplerLayoutBinding.descriptorType
+            = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        samplerLayoutBinding.stageFlags
+            = VK_SHADER_STAGE_FRAGMENT_BIT; // only used on fragment shader;
+                                            // (may use for vertex shader for
+                                            // height mapping)
+        samplerLayoutBinding.pImmutableSamplers = nullptr;
 
-void BindlessRenderSystem::AddEntity(Entity* entity) {
-    // must have a bindless component
-    ASSERT(entity->GetComponent<BindlessRenderSystemComponent>() != nullptr);
-    _entities.push_back(entity);
-}
+        VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+        bindingFlagsInfo.sType
+            = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+        bindingFlagsInfo.bindingCount = 1;
+        bindingFlagsInfo.pBindingFlags = &bindingFlags;
 
-void BindlessRenderSystem::Tick(const TickContext* ctx) {
-    PROFILE_SCOPE(ctx->profiler, "Bindless System Tick");
-    VkCommandBuffer CB = ctx->graphics.CB;
-    VkFramebuffer FB = ctx->graphics.currentFB;
-    VkExtent2D FBExt = ctx->graphics.currentFBextend;
-    int currFrame = ctx->graphics.currentFrameInFlight;
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.pNext = &bindingFlagsInfo;
+        if (updateAfterBind) {
+            layoutInfo.flags
+                = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+        }
+        layoutInfo.bindingCount = 1;
+        layoutInfo.pBindings = &samplerLayoutBinding;
 
-    // flush the update queue of the current frame
-    for (auto closure : _updateQueue[currFrame]) {
-        closure();
+        if (vkCreateDescriptorSetLayout(
+                _device->logicalDevice,
+                &layoutInfo,
+                nullptr,
+                &_textureDescriptorSetLayout
+            )
+            != VK_SUCCESS) {
+            FATAL("Failed to create texture descriptor set layout!");
+        }
+        _deletionStack.push([this]() {
+            vkDestroyDescriptorSetLayout(
+                _device->logicalDevice, _textureDescriptorSetLayout, nullptr
+            );
+        });
     }
-    _updateQueue[currFrame].clear();
-
-    vkCmdBindPipeline(CB, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipeline);
-
-    // only use the global engine UBO, so need to bind once only
-    vkCmdBindDescriptorSets(
-        CB,
-        VK_PIPELINE_BIND_POINT_GRAPHICS,
-        _pipelineLayout,
-        0,
-        1,
-        &_descriptorSets[currFrame],
-        0,
-        0
-    );
 
-    VkDeviceSize offsets[] = {0};
-    vkCmdBindVertexBuffers(CB, 0, 1, &_vertexBuffers.buffer, offsets);
-    vkCmdBindIndexBuffer(CB, _indexBuffers.buffer, 0, VK_INDEX_TYPE_UINT32);
-    vkCmdDrawIndexedIndirect(
-        CB,
-        _bindlessBuffers[currFrame].drawCommandArray.buffer,
-        0, // offset
-        _drawCommandArrayOffset
-            / sizeof(VkDrawIndexedIndirectCommand), // drawCount
-        sizeof(VkDrawIndexedIndirectCommand)        // stride
-    );
-}
+    { // _textureDescriptorPool
+        VkDescriptorPoolSize poolSize{
+            VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, TEXTURE_ARRAY_SIZE
+        };
 
-void BindlessRenderSystem::DestroyComponent(
-    BindlessRenderSystemComponent* component
-) {
-    // internally we perform the "copy and decrement method":
-    // 1. overwrite the instance data in the array with the last instance
-    // data
-    // 2. decrement the total # of instances
-    int instanceDataOffset = component->instanceDataOffset;
-    for (int i = 0; i < NUM_FRAME_IN_FLIGHT; i++) {
-        SSBOInstanceData* pData;
-        SSBOInstanceData* pLastData;
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.poolSizeCount = 1;
+        poolInfo.pPoolSizes = &poolSize;
+        poolInfo.maxSets = 1;
+        if (updateAfterBind) {
+            poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+        }
 
-        pData = reinterpret_cast<SSBOInstanceData*>(
-            reinterpret_cast<char*>( // char for byte ptr arithmetics
-                _bindlessBuffers[i].instanceDataArray.bufferAddress
+        if (vkCreateDescriptorPool(
+                _device->logicalDevice,
+                &poolInfo,
+                nullptr,
+                &_textureDescriptorPool
             )
-            + instanceDataOffset
-        );
+            != VK_SUCCESS) {
+            FATAL("Failed to create texture descriptor pool!");
+        }
+        _deletionStack.push([this]() {
+            vkDestroyDescriptorPool(
+                _device->logicalDevice, _textureDescriptorPool, nullptr
+            );
+        });
+    }
 
-        pLastData = reinterpret_cast<SSBOInstanceData*>(
-            reinterpret_cast<char*>( // char for byte ptr arithmetics
-                _bindlessBuffers[i].instanceDataArray.bufferAddress
-            )
-            + _instanceDataArrayOffset - sizeof(SSBOInstanceData)
-        );
+    { // _textureDescriptorSet
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = _textureDescriptorPool;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &_textureDescriptorSetLayout;
 
-        if (pLastData != pData) {
-            memcpy(pData, pLastData, sizeof(SSBOInstanceData));
+        if (vkAllocateDescriptorSets(
+                _device->logicalDevice, &allocInfo, &_textureDescriptorSet
+            )
+            != VK_SUCCESS) {
+            FATAL("Failed to allocate texture descriptor set!");
         }
     }
-    _instanceDataArrayOffset -= sizeof(SSBOInstanceData);
 }
 
-std::vector<BindlessRenderSystemComponent*> BindlessRenderSystem::
-    MakeComponents(
-        const std::string& meshPath,
-        const std::string& texturePath,
-        unsigned int count
-    ) {
-    NEEDS_IMPLEMENTATION();
-}
+void BindlessRenderSystem::createCullPipelines(const InitContext* initData) {
+    DEBUG("Creating cull pipelines...");
+    std::array<VkDescriptorSetLayoutBinding, 17> bindings{};
+    for (unsigned int i = 0; i < bindings.size(); i++) {
+        bindings[i].binding = i;
+        // all but the engine UBO and the depth pyramid are storage buffers of
+        // `_bindlessBuffers`
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        bindings[i].pImmutableSamplers = nullptr;
+    }
+    bindings[(int)CullBindingLocation::UBO_STATIC_ENGINE].descriptorType
+        = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    bindings[(int)CullBindingLocation::DEPTH_PYRAMID].descriptorType
+        = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 
-BindlessRenderSystemComponent* BindlessRenderSystem::MakeComponent(
-    const std::string& meshPath,
-    const std::string& texturePath
-) {
-    size_t instanceID = 0;
-    int textureIndex = 0;
-    ASSERT(_textureManager);
+    { // _cullDescriptorSetLayout
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = bindings.size();
+        layoutInfo.pBindings = bindings.data();
 
-    { // load or create new texture
-        auto it = _textureDescriptorIndices.find(texturePath);
-        if (it == _textureDescriptorIndices.end()) {
-            int textureOffset = _textureDescriptorIndices.size();
-            // load texture into textures[textureOffset]
-            DEBUG("loading {} into {}", texturePath, textureOffset);
-            _textureManager->GetDescriptorImageInfo(
-                texturePath, _textureDescriptorInfo[textureOffset]
-            );
-            textureOffset = textureOffset;
-            _textureDescriptorInfoIdx++;
-            // must update the descriptor set to reflect loading newtexture
-            for (int i = 0; i < NUM_FRAME_IN_FLIGHT; i++) {
-                _updateQueue[i].push_back([this, i]() {
-                    updateTextureDescriptorSet(i);
-                });
-            }
-            auto res
-                = _textureDescriptorIndices.insert({texturePath, textureOffset}
-                );
-            ASSERT(res.second);
-            textureIndex = res.first->second;
-        } else {
-            textureIndex = it->second;
+        if (vkCreateDescriptorSetLayout(
+                _device->logicalDevice,
+                &layoutInfo,
+                nullptr,
+                &_cullDescriptorSetLayout
+            )
+            != VK_SUCCESS) {
+            FATAL("Failed to create cull descriptor set layout!");
         }
+        _deletionStack.push([this]() {
+            vkDestroyDescriptorSetLayout(
+                _device->logicalDevice, _cullDescriptorSetLayout, nullptr
+            );
+        });
     }
 
-    // look for a batch to put the instance into.
-    // if no batch is available, create a new batch with 1.5x the
-    // old batch's size
-    auto it = _modelBatches.find(meshPath);
-    if (it == _modelBatches.end()) {
-        auto res = _modelBatches.insert({meshPath, {}});
-        ASSERT(res.second);
-        it = res.first;
+    { // _cullDescriptorPool, a set per frame in flight
+        _cullDescriptorPool = createDescriptorPool(
+            _device->logicalDevice,
+            bindings.data(),
+            bindings.size(),
+            NUM_FRAME_IN_FLIGHT
+        );
+        _deletionStack.push([this]() {
+            vkDestroyDescriptorPool(
+                _device->logicalDevice, _cullDescriptorPool, nullptr
+            );
+        });
     }
-    RenderBatch* pBatch = nullptr;
-    for (RenderBatch& batch : it->second) {
-        if (batch.instanceCount < batch.maxSize) {
-            pBatch = std::addressof(batch);
-            break;
+
+    { // _cullDescriptorSets
+        std::vector<VkDescriptorSetLayout> layouts(
+            NUM_FRAME_IN_FLIGHT, _cullDescriptorSetLayout
+        );
+
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = _cullDescriptorPool;
+        allocInfo.descriptorSetCount = NUM_FRAME_IN_FLIGHT;
+        allocInfo.pSetLayouts = layouts.data();
+
+        if (vkAllocateDescriptorSets(
+                _device->logicalDevice, &allocInfo, _cullDescriptorSets.data()
+            )
+            != VK_SUCCESS) {
+            FATAL("Failed to allocate cull descriptor sets!");
         }
     }
 
-    // didn't find a suitable batch, create a new batch
-    if (pBatch == nullptr) {
-        // currently use geometric scaling
-        int batchSize = 10;
-        // each batch is 10x the size of the last
-        batchSize *= (it->second.empty() ? 1 : it->second.back().maxSize);
-        it->second.push_back(createRenderBatch(meshPath, batchSize));
-        pBatch = std::addressof(it->second.back());
+    // the buffers are bound by `updateBufferDescriptorSets()`, the depth
+    // pyramid by `updateDepthPyramidDescriptorSet()`
+    for (size_t i = 0; i < NUM_FRAME_IN_FLIGHT; i++) {
+        VkWriteDescriptorSet descriptorWrite{};
+        descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrite.dstSet = _cullDescriptorSets[i];
+        descriptorWrite.dstBinding
+            = (int)CullBindingLocation::UBO_STATIC_ENGINE;
+        descriptorWrite.dstArrayElement = 0;
+        descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        descriptorWrite.descriptorCount = 1;
+        descriptorWrite.pBufferInfo
+            = &initData->engineUBOStaticDescriptorBufferInfo[i];
+
+        vkUpdateDescriptorSets(
+            _device->logicalDevice, 1, &descriptorWrite, 0, nullptr
+        );
     }
 
-    pBatch->instanceCount += 1; // the model now belongs to the batch
+    { // _cullPipelineLayout
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(CullPushConstants);
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType
+            = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &_cullDescriptorSetLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+        if (vkCreatePipelineLayout(
+                _device->logicalDevice,
+                &pipelineLayoutInfo,
+                nullptr,
+                &_cullPipelineLayout
+            )
+            != VK_SUCCESS) {
+            FATAL("Failed to create cull pipeline layout!");
+        }
+        _deletionStack.push([this]() {
+            vkDestroyPipelineLayout(
+                _device->logicalDevice, _cullPipelineLayout, nullptr
+            );
+        });
+    }
 
-    BindlessRenderSystemComponent* ret = new BindlessRenderSystemComponent();
-    ret->parentSystem = this;
-    ret->instanceDataOffset = _instanceDataArrayOffset;
-    DEBUG("_instanceDataArrayOffset = {}", _instanceDataArrayOffset);
+    auto createComputePipeline = [this](const char* shaderSrc) {
+        VkShaderModule shaderModule = ShaderCreation::createShaderModule(
+            _device->logicalDevice, shaderSrc
+        );
 
-    // create new instance data, push to instance data array
-    SSBOInstanceData data{
-        .model = glm::mat4(1.f),
-        .transparency = 0.f,
-        .textureIndex = {.albedo = textureIndex},
-        .drawCmdIndex
-        = pBatch->drawCmdOffset
-          / static_cast<unsigned int>(sizeof(VkDrawIndexedIndirectCommand)),
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage.sType
+            = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineInfo.stage.module = shaderModule;
+        pipelineInfo.stage.pName = "main";
+        pipelineInfo.layout = _cullPipelineLayout;
+
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        if (vkCreateComputePipelines(
+                _device->logicalDevice,
+                VK_NULL_HANDLE,
+                1,
+                &pipelineInfo,
+                nullptr,
+                &pipeline
+            )
+            != VK_SUCCESS) {
+            FATAL("Failed to create compute pipeline from {}!", shaderSrc);
+        }
+        vkDestroyShaderModule(_device->logicalDevice, shaderModule, nullptr);
+        return pipeline;
     };
-    // push data to the array
-    for (int i = 0; i < NUM_FRAME_IN_FLIGHT; i++) {
-        char* addr = reinterpret_cast<char*>(
-                         _bindlessBuffers[i].instanceDataArray.bufferAddress
-                     )
-                     + _instanceDataArrayOffset;
-        memcpy(addr, std::addressof(data), sizeof(SSBOInstanceData));
-    }
-    _instanceDataArrayOffset += sizeof(SSBOInstanceData);
 
-    {
-        DEBUG("Culling hack begin for {}", meshPath);
-        // hack in the process of compute shader culling by
-        // 1. inserting the instance index into lookup array manually,
-        // 2. modifying the render command's draw number to draw an additional
-        // index therefore the command draws all added components in its batch
-        for (int i = 0; i < NUM_FRAME_IN_FLIGHT; i++) {
-            VkDrawIndexedIndirectCommand cmd;
-            // read command from drawCommandArray
-            VkDrawIndexedIndirectCommand* pCmd
-                = reinterpret_cast<VkDrawIndexedIndirectCommand*>(
-                    (char*)_bindlessBuffers[i].drawCommandArray.bufferAddress
-                    + pBatch->drawCmdOffset
-                );
-            DEBUG(
-                "render command instance count = {} first instance = {}",
-                pCmd->instanceCount,
-                pCmd->firstInstance
-            );
-            unsigned int* pIndex = reinterpret_cast<unsigned int*>(
-                (char*)_bindlessBuffers[i].instanceIndexArray.bufferAddress
-                + ((pCmd->firstInstance + pCmd->instanceCount)
-                   * sizeof(SSBOInstanceIndex))
+    _cullPipeline = createComputePipeline(CULL_SHADER_SRC);
+    _compactPipeline = createComputePipeline(COMPACT_SHADER_SRC);
+    _transformPipeline = createComputePipeline(TRANSFORM_SHADER_SRC);
+    _meshletCullPipeline = createComputePipeline(MESHLET_CULL_SHADER_SRC);
+    // reads the depth pyramid, which must be bound
+    if (_depthPyramid) {
+        _cullLatePipeline = createComputePipeline(CULL_LATE_SHADER_SRC);
+    }
+    _deletionStack.push([this]() {
+        if (_cullLatePipeline != VK_NULL_HANDLE) {
+            vkDestroyPipeline(
+                _device->logicalDevice, _cullLatePipeline, nullptr
             );
-            pCmd->instanceCount++;
-            DEBUG("cmd now has instance count of {}", pCmd->instanceCount);
-            *pIndex = ret->instanceDataOffset
-                      / sizeof(SSBOInstanceData
-                      ); // offset divided by size to get index
-            DEBUG("pindex: {}", *pIndex);
         }
-    }
-
-    return ret;
+        vkDestroyPipeline(
+            _device->logicalDevice, _meshletCullPipeline, nullptr
+        );
+        vkDestroyPipeline(
+            _device->logicalDevice, _transformPipeline, nullptr
+        );
+        vkDestroyPipeline(_device->logicalDevice, _compactPipeline, nullptr);
+        vkDestroyPipeline(_device->logicalDevice, _cullPipeline, nullptr);
+    });
 }
 
-void BindlessRenderSystem::updateTextureDescriptorSet(int frame) {
-    DEBUG("updating texture descirptor set for frame {}", frame);
-    std::array<VkWriteDescriptorSet, 1> descriptorWrites{};
-    descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    descriptorWrites[0].dstSet = this->_descriptorSets[frame];
-    descriptorWrites[0].dstBinding = (int)BindingLocation::TEXTURE_SAMPLER;
-    descriptorWrites[0].dstArrayElement = 0;
-    descriptorWrites[0].descriptorType
-        = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    descriptorWrites[0].descriptorCount
-        = _textureDescriptorInfoIdx; // descriptors are 0-indexed, +1 for
-                                     // the # of valid samplers
-    descriptorWrites[0].pImageInfo = _textureDescriptorInfo.data();
-
-    DEBUG("descriptor count: {}", descriptorWrites[0].descriptorCount);
+void BindlessRenderSystem::updateDepthPyramidDescriptorSet(int frame) {
+    VkDescriptorImageInfo imageInfo{};
+    imageInfo.sampler = _depthPyramid->GetSampler();
+    imageInfo.imageView = _depthPyramid->GetImageView();
+    imageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    VkWriteDescriptorSet descriptorWrite{};
+    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrite.dstSet = _cullDescriptorSets[frame];
+    descriptorWrite.dstBinding = (int)CullBindingLocation::DEPTH_PYRAMID;
+    descriptorWrite.dstArrayElement = 0;
+    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptorWrite.descriptorCount = 1;
+    descriptorWrite.pImageInfo = &imageInfo;
+    vkUpdateDescriptorSets(
+        _device->logicalDevice, 1, &descriptorWrite, 0, nullptr
+    );
+    _cullDepthPyramidViews[frame] = imageInfo.imageView;
+}
 
+void BindlessRenderSystem::updateBufferDescriptorSets(int frame) {
+    BindlessBuffer& buffers = _bindlessBuffers[frame];
+    // <set, binding, buffer>
+    const std::array<std::tuple<VkDescriptorSet, unsigned int, VQBuffer*>, 18>
+        bindings = {
+            {{_descriptorSets[frame],
+              (unsigned int)BindingLocation::INSTANCE_DATA,
+              &buffers.instanceDataArray},
+             {_descriptorSets[frame],
+              (unsigned int)BindingLocation::INSTANCE_INDEX,
+              &buffers.instanceIndexArray},
+             {_descriptorSets[frame],
+              (unsigned int)BindingLocation::INSTANCE_MATRIX,
+              &buffers.instanceMatrixArray},
+             {_cullDescriptorSets[frame],
+              (unsigned int)CullBindingLocation::INSTANCE_DATA,
+              &buffers.instanceDataArray},
+             {_cullDescriptorSets[frame],
+              (unsigned int)CullBindingLocation::INSTANCE_TRANSFORM,
+              &buffers.instanceTransformArray},
+             {_cullDescriptorSets[frame],
+              (unsigned int)CullBindingLocation::INSTANCE_MATRIX,
+              &buffers.instanceMatrixArray},
+             {_cullDescriptorSets[frame],
+              (unsigned int)CullBindingLocation::DRAW_COMMAND,
+              &buffers.drawCommandArray},
+             {_cullDescriptorSets[frame],
+              (unsigned int)CullBindingLocation::INSTANCE_INDEX,
+              &buffers.instanceIndexArray},
+             {_cullDescriptorSets[frame],
+              (unsigned int)CullBindingLocation::COMPACTED_DRAW_COMMAND,
+              &buffers.compactedDrawCommandArray},
+             {_cullDescriptorSets[frame],
+              (unsigned int)CullBindingLocation::DRAW_COUNT,
+              &buffers.drawCount},
+             {_cullDescriptorSets[frame],
+              (unsigned int)CullBindingLocation::LATE_DRAW_COMMAND,
+              &buffers.lateDrawCommandArray},
+             {_cullDescriptorSets[frame],
+              (unsigned int)CullBindingLocation::EARLY_INSTANCE_COUNT,
+              &buffers.earlyInstanceCounts},
+             {_cullDescriptorSets[frame],
+              (unsigned int)CullBindingLocation::INSTANCE_VISIBILITY,
+              &_instanceVisibility},
+             {_cullDescriptorSets[frame],
+              (unsigned int)CullBindingLocation::CULL_STATS,
+              &buffers.cullStats},
+             {_cullDescriptorSets[frame],
+              (unsigned int)CullBindingLocation::MESHLET,
+              &_meshletBuffer},
+             {_cullDescriptorSets[frame],
+              (unsigned int)CullBindingLocation::DRAW_MESHLETS,
+              &buffers.drawMeshletArray},
+             {_cullDescriptorSets[frame],
+              (unsigned int)CullBindingLocation::MESHLET_DRAW_COMMAND,
+              &buffers.meshletDrawCommandArray},
+             {_cullDescriptorSets[frame],
+              (unsigned int)CullBindingLocation::MESHLET_COUNTS,
+              &buffers.meshletCounts}}
+        };
+
+    std::array<VkDescriptorBufferInfo, bindings.size()> bufferInfos{};
+    std::array<VkWriteDescriptorSet, bindings.size()> descriptorWrites{};
+    uint32_t numWrites = 0;
+    for (auto [set, binding, buffer] : bindings) {
+        // the vertex shader reaches its buffers through their addresses
+        if (useBufferDeviceAddress() && set == _descriptorSets[frame]) {
+            continue;
+        }
+        const uint32_t i = numWrites++;
+        bufferInfos[i].buffer = buffer->buffer;
+        bufferInfos[i].offset = 0;
+        bufferInfos[i].range = buffer->size;
+
+        descriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[i].dstSet = set;
+        descriptorWrites[i].dstBinding = binding;
+        descriptorWrites[i].dstArrayElement = 0;
+        descriptorWrites[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[i].descriptorCount = 1;
+        descriptorWrites[i].pBufferInfo = &bufferInfos[i];
+    }
     vkUpdateDescriptorSets(
-        _device->logicalDevice,
-        descriptorWrites.size(),
-        descriptorWrites.data(),
-        0,
-        nullptr
+        _device->logicalDevice, numWrites, descriptorWrites.data(), 0, nullptr
     );
-};
+    _bufferDescriptorsDirty[frame] = false;
+}
 
-void BindlessRenderSystem::FlagUpdate(Entity* entity) {
-    ASSERT(entity->GetComponent<BindlessRenderSystemComponent>() != nullptr);
-    // internally we push the entity to the update queue for each buffer, so
-    // that it can be updated before the buffer are used for drawing
-    // TODO: can have another staging buffer layer for better flushing
-    // performance
+void BindlessRenderSystem::Init(const InitContext* initData) {
+    _device = initData->device;
+    _jobSystem = initData->jobSystem;
+    _textureManager = initData->textureManager;
+    _depthPyramid = initData->depthPyramid;
+    if (_device->enabledFeatures12.bufferDeviceAddress) {
+        INFO("Reaching bindless buffers through buffer device addresses");
+        _bufferAddressUsage = VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+    }
+    createBindlessResources();
+    // create graphics pipeline
+    createGraphicsPipeline(initData->renderPass.mainPass, initData);
+    createCullPipelines(initData);
     for (int i = 0; i < NUM_FRAME_IN_FLIGHT; i++) {
-        _updateQueue[i].push_back([this, i, entity]() {
-            // this is not really cache friendly -- should we pre-cache the
-            // transforms into a vector/switch up the update job into the
-            // compute tick?
-            BindlessRenderSystemComponent* systemComponent
-                = entity->GetComponent<BindlessRenderSystemComponent>();
-            ASSERT(systemComponent);
-
-            // get pointer to the instance's data
-            SSBOInstanceData* instanceData
-                = reinterpret_cast<SSBOInstanceData*>(
-                    reinterpret_cast<char*>(
-                        _bindlessBuffers[i].instanceDataArray.bufferAddress
-                    )
-                    + systemComponent->instanceDataOffset
-                );
+        updateBufferDescriptorSets(i);
+    }
+}
 
-            // transform
-            TransformComponent* transform
-                = entity->GetComponent<TransformComponent>();
-            if (transform) {
-                transform->GetModelMatrix(instanceData->model);
-            }
-        });
+void BindlessRenderSystem::Cleanup() {
+    DEBUG("Cleaning up...");
+    _deletionStack.flush();
+    DEBUG("Done cleaning up");
+}
+
+void BindlessRenderSystem::AddEntity(Entity* entity) {
+    // must have a bindless component
+    ASSERT(entity->GetComponent<BindlessRenderSystemComponent>() != nullptr);
+    _entities.push_back(entity);
+}
+
+namespace
+{
+// Extract the planes of the frustum of `viewProj` (Gribb & Hartmann), in the
+// form (normal, distance) with normalized, inward-pointing normals.
+// Assumes a [0, 1] depth range.
+void getFrustumPlanes(const glm::mat4& viewProj, glm::vec4 planes[6]) {
+    // glm is column-major
+    glm::mat4 rows = glm::transpose(viewProj);
+    planes[0] = rows[3] + rows[0]; // left
+    planes[1] = rows[3] - rows[0]; // right
+    planes[2] = rows[3] + rows[1]; // bottom
+    planes[3] = rows[3] - rows[1]; // top
+    planes[4] = rows[2];           // near
+    planes[5] = rows[3] - rows[2]; // far
+    for (int i = 0; i < 6; i++) {
+        planes[i] /= glm::length(glm::vec3(planes[i]));
     }
 }
 
-BindlessRenderSystem::MeshBufferOffsets BindlessRenderSystem::loadMeshBuffer(
-    const std::string& meshPath
+// coalesce the runs of set bits among the first `count` bits of `dirty` into
+// [begin, end) ranges, clearing the bits
+void collectDirtyRanges(
+    std::vector<uint64_t>& dirty,
+    uint32_t count,
+    std::vector<std::pair<uint32_t, uint32_t>>& ranges
 ) {
-    DEBUG("Loading mesh into buffer array from {}", meshPath);
-    // load mesh into vertex and index buffer
-    std::vector<Vertex> vertices;
-    std::vector<uint32_t> indices;
-    CoreUtils::loadModel(meshPath.c_str(), vertices, indices);
-
-    VkDeviceSize vertexBufferSize = sizeof(Vertex) * vertices.size();
-    VkDeviceSize indexBufferSize = sizeof(uint32_t) * indices.size();
-
-    // make staging buffer for both vertex and index buffer
-    std::pair<VkBuffer, VkDeviceMemory> res
-        = CoreUtils::createVulkanStagingBuffer(
-            _device->physicalDevice,
-            _device->logicalDevice,
-            vertexBufferSize + indexBufferSize
+    ranges.clear();
+    // the bits past `count` are of reclaimed instances
+    const size_t numWords = (count + 63) / 64;
+    for (size_t word = 0; word < numWords; word++) {
+        uint64_t bits = dirty[word];
+        dirty[word] = 0;
+        while (bits) {
+            const uint32_t index = word * 64 + __builtin_ctzll(bits);
+            bits &= bits - 1; // clear the lowest bit
+            if (index >= count) {
+                break;
+            }
+            if (!ranges.empty() && ranges.back().second == index) {
+                ranges.back().second++;
+            } else {
+                ranges.push_back({index, index + 1});
+            }
+        }
+    }
+}
+} // namespace
+
+void BindlessRenderSystem::PrepareFrame(const TickContext* ctx) {
+    VkCommandBuffer CB = ctx->graphics.CB;
+    int currFrame = ctx->graphics.currentFrameInFlight;
+    std::lock_guard<std::mutex> lock(_instanceMutex);
+    _frameCount++;
+    reclaimInstances(CB);
+
+    for (auto it = _retiredBuffers.begin(); it != _retiredBuffers.end();) {
+        // also kept until the upload batch that copied out of it completes
+        if (--it->framesLeft <= 0
+            && _device->uploadManager.IsComplete(it->ticket)) {
+            it->buffer.Cleanup();
+            it = _retiredBuffers.erase(it);
+        } else {
+            it++;
+        }
+    }
+
+    reserveFrameBuffers(ctx);
+
+    if (_bufferDescriptorsDirty[currFrame]) {
+        updateBufferDescriptorSets(currFrame);
+    }
+
+    // the pyramid is re-created with the depth buffer
+    if (_depthPyramid
+        && _cullDepthPyramidViews[currFrame]
+               != _depthPyramid->GetImageView()) {
+        updateDepthPyramidDescriptorSet(currFrame);
+    }
+
+    BindlessBuffer& buffers = _bindlessBuffers[currFrame];
+
+    // stats of the last cull of this frame in flight, which has completed
+    const CullStats* stats
+        = reinterpret_cast<const CullStats*>(buffers.cullStats.bufferAddress);
+    ctx->profiler->Count("Bindless: visible instances", stats->visible);
+    ctx->profiler->Count(
+        "Bindless: frustum culled instances", stats->frustumCulled
+    );
+    ctx->profiler->Count("Bindless: occluded instances", stats->occluded);
+    ctx->profiler->Count("Bindless: culled meshlets", stats->meshletsCulled);
+
+    PROFILE_GPU_SCOPE(ctx->gpuProfiler, CB, "Bindless Culling");
+
+    // the instances and draw commands that changed since the frame's last
+    // `PrepareFrame()`, made visible to the shaders by the barrier below
+    uploadFrameData(ctx);
+
+    vkCmdFillBuffer(CB, buffers.drawCount.buffer, 0, VK_WHOLE_SIZE, 0);
+    vkCmdFillBuffer(CB, buffers.cullStats.buffer, 0, VK_WHOLE_SIZE, 0);
+    // no clustered instances nor meshlet draws yet, in either phase
+    const uint32_t meshletCounts[8] = {0, 1, 1, 0, 0, 1, 1, 0};
+    vkCmdUpdateBuffer(
+        CB,
+        buffers.meshletCounts.buffer,
+        0,
+        sizeof(meshletCounts),
+        meshletCounts
+    );
+    if (!_instanceVisibilityCleared) {
+        // nothing was visible last frame, the late pass tests everything
+        vkCmdFillBuffer(CB, _instanceVisibility.buffer, 0, VK_WHOLE_SIZE, 0);
+        _instanceVisibilityCleared = true;
+    }
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT
+                            | VK_ACCESS_SHADER_READ_BIT
+                            | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(
+        CB,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT
+            | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
+            | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+        0,
+        1,
+        &barrier,
+        0,
+        nullptr,
+        0,
+        nullptr
+    );
+
+    recordTransforms(ctx);
+    // without a depth pyramid there is no late pass, draw everything that
+    // passes the frustum test
+    recordCull(ctx, _depthPyramid ? CullPhase::EARLY : CullPhase::ALL);
+}
+
+void BindlessRenderSystem::PrepareLateFrame(const TickContext* ctx) {
+    PROFILE_GPU_SCOPE(
+        ctx->gpuProfiler, ctx->graphics.CB, "Bindless Late Culling"
+    );
+    recordCull(ctx, CullPhase::LATE);
+}
+
+void BindlessRenderSystem::recordTransforms(const TickContext* ctx) {
+    VkCommandBuffer CB = ctx->graphics.CB;
+    int currFrame = ctx->graphics.currentFrameInFlight;
+
+    CullPushConstants pushConstants{};
+    pushConstants.instanceCount = _instanceData.size();
+
+    vkCmdBindDescriptorSets(
+        CB,
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        _cullPipelineLayout,
+        0,
+        1,
+        &_cullDescriptorSets[currFrame],
+        0,
+        0
+    );
+    vkCmdPushConstants(
+        CB,
+        _cullPipelineLayout,
+        VK_SHADER_STAGE_COMPUTE_BIT,
+        0,
+        sizeof(CullPushConstants),
+        &pushConstants
+    );
+
+    // one thread per instance
+    vkCmdBindPipeline(CB, VK_PIPELINE_BIND_POINT_COMPUTE, _transformPipeline);
+    vkCmdDispatch(
+        CB,
+        (pushConstants.instanceCount + CULL_WORKGROUP_SIZE - 1)
+            / CULL_WORKGROUP_SIZE,
+        1,
+        1
+    );
+
+    // the cull shaders read the matrices; the vertex shader reads them after
+    // the barrier at the end of `recordCull()`
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(
+        CB,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        1,
+        &barrier,
+        0,
+        nullptr,
+        0,
+        nullptr
+    );
+}
+
+void BindlessRenderSystem::recordCull(
+    const TickContext* ctx,
+    CullPhase phase
+) {
+    VkCommandBuffer CB = ctx->graphics.CB;
+    int currFrame = ctx->graphics.currentFrameInFlight;
+
+    CullPushConstants pushConstants{};
+    getFrustumPlanes(
+        ctx->graphics.mainProjectionMatrix * ctx->mainCamera->GetViewMatrix(),
+        pushConstants.frustumPlanes
+    );
+    pushConstants.instanceCount = _instanceData.size();
+    pushConstants.drawCount = _drawCommands.size();
+    pushConstants.phase = phase;
+    pushConstants.clusterInstanceOffset
+        = _instanceIndexAllocator.GetCapacity();
+    pushConstants.meshletDrawCapacity = getMeshletDrawCapacity();
+    pushConstants.coneCulling = CULL_BACK_FACES;
+
+    // always re-bind, the depth pyramid build binds its own set in between
+    vkCmdBindDescriptorSets(
+        CB,
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        _cullPipelineLayout,
+        0,
+        1,
+        &_cullDescriptorSets[currFrame],
+        0,
+        0
+    );
+    vkCmdPushConstants(
+        CB,
+        _cullPipelineLayout,
+        VK_SHADER_STAGE_COMPUTE_BIT,
+        0,
+        sizeof(CullPushConstants),
+        &pushConstants
+    );
+
+    // one thread per instance
+    vkCmdBindPipeline(
+        CB,
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        phase == CullPhase::LATE ? _cullLatePipeline : _cullPipeline
+    );
+    vkCmdDispatch(
+        CB,
+        (pushConstants.instanceCount + CULL_WORKGROUP_SIZE - 1)
+            / CULL_WORKGROUP_SIZE,
+        1,
+        1
+    );
+
+    // the compact shader reads the instance counts the cull shader wrote, the
+    // meshlet cull shader is dispatched over the clustered instances
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT
+                            | VK_ACCESS_SHADER_READ_BIT
+                            | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(
+        CB,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT
+            | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        1,
+        &barrier,
+        0,
+        nullptr,
+        0,
+        nullptr
+    );
+
+    // one workgroup per clustered instance
+    if (pushConstants.meshletDrawCapacity > 0) {
+        const VkDeviceSize phaseIndex = phase == CullPhase::LATE ? 1 : 0;
+        vkCmdBindPipeline(
+            CB, VK_PIPELINE_BIND_POINT_COMPUTE, _meshletCullPipeline
         );
-    VkBuffer stagingBuffer = res.first;
-    VkDeviceMemory stagingBufferMemory = res.second;
+        vkCmdDispatchIndirect(
+            CB,
+            _bindlessBuffers[currFrame].meshletCounts.buffer,
+            phaseIndex * 4 * sizeof(uint32_t)
+        );
+    }
 
-    // copy vertex and index buffer to staging buffer
-    void* vertexBufferDst;
-    void* indexBufferDst;
-    vkMapMemory(
-        _device->logicalDevice,
-        stagingBufferMemory,
+    // one thread per draw command
+    vkCmdBindPipeline(CB, VK_PIPELINE_BIND_POINT_COMPUTE, _compactPipeline);
+    vkCmdDispatch(
+        CB,
+        (pushConstants.drawCount + CULL_WORKGROUP_SIZE - 1)
+            / CULL_WORKGROUP_SIZE,
+        1,
+        1
+    );
+
+    // the draws read the compacted draw commands, the meshlet draws and their
+    // counts, the vertex shader reads the instance indices, the late pass
+    // reads and writes the rest,
+    // and the host reads the stats once the frame completes
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT
+                            | VK_ACCESS_SHADER_READ_BIT
+                            | VK_ACCESS_SHADER_WRITE_BIT
+                            | VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(
+        CB,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT
+            | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT
+            | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
+            | VK_PIPELINE_STAGE_HOST_BIT,
         0,
-        vertexBufferSize,
+        1,
+        &barrier,
         0,
-        &vertexBufferDst
+        nullptr,
+        0,
+        nullptr
     );
-    memcpy(vertexBufferDst, vertices.data(), (size_t)vertexBufferSize);
-    vkUnmapMemory(_device->logicalDevice, stagingBufferMemory);
+}
 
-    vkMapMemory(
-        _device->logicalDevice,
-        stagingBufferMemory,
-        vertexBufferSize,
-        indexBufferSize,
+void BindlessRenderSystem::Tick(const TickContext* ctx) {
+    PROFILE_GPU_SCOPE(ctx->gpuProfiler, ctx->graphics.CB, "Bindless");
+    recordDraws(ctx, false);
+}
+
+void BindlessRenderSystem::TickLate(const TickContext* ctx) {
+    PROFILE_GPU_SCOPE(ctx->gpuProfiler, ctx->graphics.CB, "Bindless Late");
+    recordDraws(ctx, true);
+}
+
+void BindlessRenderSystem::recordDraws(const TickContext* ctx, bool late) {
+    VkCommandBuffer CB = ctx->graphics.CB;
+    int currFrame = ctx->graphics.currentFrameInFlight;
+
+    vkCmdBindPipeline(CB, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipeline);
+
+    // only use the global engine UBO, so need to bind once only
+    const std::array<VkDescriptorSet, 2> descriptorSets
+        = {_descriptorSets[currFrame], _textureDescriptorSet};
+    vkCmdBindDescriptorSets(
+        CB,
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        _pipelineLayout,
+        0,
+        descriptorSets.size(),
+        descriptorSets.data(),
         0,
-        &indexBufferDst
+        0
     );
-    memcpy(indexBufferDst, indices.data(), (size_t)indexBufferSize);
-    vkUnmapMemory(_device->logicalDevice, stagingBufferMemory);
 
-    // copy from staging buffer to vertex/index buffer array
-    CoreUtils::copyVulkanBuffer(
-        _device->logicalDevice,
-        _device->graphicsCommandPool,
-        _device->graphicsQueue,
-        stagingBuffer,
-        _vertexBuffers.buffer,
-        vertexBufferSize,
+    const BindlessBuffer& buffers = _bindlessBuffers[currFrame];
+    if (useBufferDeviceAddress()) {
+        // the buffers as they are this frame, whether or not they just grew
+        const DrawPushConstants pushConstants{
+            .instanceDataArray = buffers.instanceDataArray.deviceAddress,
+            .instanceIndexArray = buffers.instanceIndexArray.deviceAddress,
+            .instanceMatrixArray = buffers.instanceMatrixArray.deviceAddress,
+            .vertexArray = _vertexBuffers.deviceAddress
+        };
+        vkCmdPushConstants(
+            CB,
+            _pipelineLayout,
+            VK_SHADER_STAGE_VERTEX_BIT,
+            0,
+            sizeof(pushConstants),
+            &pushConstants
+        );
+    } else {
+        VkDeviceSize offsets[] = {0};
+        vkCmdBindVertexBuffers(CB, 0, 1, &_vertexBuffers.buffer, offsets);
+    }
+    vkCmdBindIndexBuffer(CB, _indexBuffers.buffer, 0, VK_INDEX_TYPE_UINT32);
+
+    const VkBuffer drawCommands
+        = late ? buffers.lateDrawCommandArray.buffer
+               : buffers.compactedDrawCommandArray.buffer;
+    // the late count follows the early one's visible and culled counts
+    const VkDeviceSize countOffset = late ? 2 * sizeof(uint32_t) : 0;
+    const uint32_t numDrawCommands = _drawCommands.size();
+    if (_device->enabledFeatures12.drawIndirectCount) {
+        // only issue the draws with visible instances
+        vkCmdDrawIndexedIndirectCount(
+            CB,
+            drawCommands,
+            0, // offset
+            buffers.drawCount.buffer,
+            countOffset,
+            numDrawCommands,                     // maxDrawCount
+            sizeof(VkDrawIndexedIndirectCommand) // stride
+        );
+    } else {
+        // culled draw commands are at the back, with 0 instances
+        vkCmdDrawIndexedIndirect(
+            CB,
+            drawCommands,
+            0,                                   // offset
+            numDrawCommands,                     // drawCount
+            sizeof(VkDrawIndexedIndirectCommand) // stride
+        );
+    }
+
+    // a draw per visible meshlet of the clustered instances, each drawing
+    // the instance whose index the cull shader put at `firstInstance`
+    const uint32_t meshletDrawCapacity = getMeshletDrawCapacity();
+    if (meshletDrawCapacity > 0) {
+        const VkDeviceSize phaseIndex = late ? 1 : 0;
+        vkCmdDrawIndexedIndirectCount(
+            CB,
+            buffers.meshletDrawCommandArray.buffer,
+            phaseIndex * meshletDrawCapacity
+                * sizeof(VkDrawIndexedIndirectCommand),
+            buffers.meshletCounts.buffer,
+            (phaseIndex * 4 + 3) * sizeof(uint32_t),
+            meshletDrawCapacity,
+            sizeof(VkDrawIndexedIndirectCommand)
+        );
+    }
+}
+
+uint32_t BindlessRenderSystem::getMeshletDrawCapacity() const {
+    // the meshlet draws need their count from the GPU
+    if (!_device->enabledFeatures12.drawIndirectCount) {
+        return 0;
+    }
+    return MAX_CLUSTERED_INSTANCES * _maxMeshletCount;
+}
+
+BindlessRenderSystem::InstanceSlot& BindlessRenderSystem::getInstanceSlot(
+    BindlessInstanceHandle handle
+) {
+    ASSERT(handle.index < _instanceSlots.size());
+    InstanceSlot& slot = _instanceSlots[handle.index];
+    if (slot.generation != handle.generation) {
+        PANIC(
+            "Stale bindless instance handle {}:{}, slot is at generation {}",
+            handle.index,
+            handle.generation,
+            slot.generation
+        );
+    }
+    return slot;
+}
+
+void BindlessRenderSystem::DestroyComponent(
+    BindlessRenderSystemComponent* component
+) {
+    std::lock_guard<std::mutex> lock(_instanceMutex);
+    const uint32_t slotIndex = component->handle.index;
+    InstanceSlot& slot = getInstanceSlot(component->handle);
+    slot.generation++; // invalidates the handle
+    slot.component = nullptr;
+
+    // mark the instance destroyed, so that the cull shaders skip it until
+    // `reclaimInstances()` moves another instance into its place
+    _instanceData[slot.dataIndex].drawCmdIndex = DRAW_CMD_NONE;
+    markInstanceDirty(slot.dataIndex);
+    _destroyedInstances.push_back({slotIndex, _frameCount});
+
+    // release the instance's slot in its batch
+    RenderBatch& batch = *slot.batch;
+    ASSERT(batch.instanceCount > 0);
+    batch.instanceCount--;
+    slot.batch = nullptr;
+    if (batch.instanceCount > 0) {
+        fitRenderBatch(batch, batch.instanceCount);
+        return;
+    }
+    for (auto it = _modelBatches.begin(); it != _modelBatches.end(); it++) {
+        if (&it->second == &batch) {
+            // invalidates `batch`
+            unloadMesh(std::string(it->first));
+            return;
+        }
+    }
+}
+
+void BindlessRenderSystem::reclaimInstances(VkCommandBuffer CB) {
+    // where the visibility of each moved instance comes from, by the index
+    // it ends up at; a move of an instance moved earlier in this call copies
+    // from where it started, so that no copy reads another's destination
+    std::vector<std::pair<uint32_t, uint32_t>> visibilityMoves; // dst, src
+    auto eraseMoveTo = [&visibilityMoves](uint32_t dataIndex) {
+        for (auto it = visibilityMoves.begin(); it != visibilityMoves.end();
+             it++) {
+            if (it->first == dataIndex) {
+                uint32_t src = it->second;
+                visibilityMoves.erase(it);
+                return src;
+            }
+        }
+        return dataIndex;
+    };
+    for (unsigned int i = 0; i < INSTANCE_RECLAIM_BUDGET; i++) {
+        if (_destroyedInstances.empty()
+            || _destroyedInstances.front().frame + NUM_FRAME_IN_FLIGHT
+                   >= _frameCount) {
+            break;
+        }
+        const uint32_t slotIndex = _destroyedInstances.front().slot;
+        _destroyedInstances.pop_front();
+
+        // internally we perform the "copy and decrement method":
+        // 1. overwrite the instance data in the array with the last instance
+        // data, which may be a destroyed instance as well
+        // 2. decrement the total # of instances
+        const uint32_t dataIndex = _instanceSlots[slotIndex].dataIndex;
+        const uint32_t lastDataIndex = _instanceDataSlots.size() - 1;
+        // the destroyed instance's visibility dies with it
+        eraseMoveTo(dataIndex);
+        if (dataIndex != lastDataIndex) {
+            visibilityMoves.emplace_back(dataIndex, eraseMoveTo(lastDataIndex));
+            const uint32_t movedSlotIndex = _instanceDataSlots[lastDataIndex];
+            InstanceSlot& movedSlot = _instanceSlots[movedSlotIndex];
+            movedSlot.dataIndex = dataIndex;
+            _instanceDataSlots[dataIndex] = movedSlotIndex;
+            _instanceData[dataIndex] = _instanceData[lastDataIndex];
+            _instanceTransforms[dataIndex] = _instanceTransforms[lastDataIndex];
+            markInstanceDirty(dataIndex);
+        }
+        const uint64_t lastBit = uint64_t(1) << (lastDataIndex % 64);
+        for (int i = 0; i < NUM_FRAME_IN_FLIGHT; i++) {
+            _dirtyInstances[i][lastDataIndex / 64] &= ~lastBit;
+            _dirtyTransforms[i][lastDataIndex / 64] &= ~lastBit;
+        }
+        _instanceDataSlots.pop_back();
+        _instanceData.pop_back();
+        _instanceTransforms.pop_back();
+        _freeInstanceSlots.push_back(slotIndex);
+    }
+    if (visibilityMoves.empty()) {
+        return;
+    }
+
+    // instances made since the buffer last grew have no visibility yet, the
+    // growth fills it with zeros
+    const VkDeviceSize visibilityCount
+        = _instanceVisibility.size / sizeof(uint32_t);
+    std::vector<VkBufferCopy> copies;
+    std::vector<uint32_t> clears;
+    for (auto [dst, src] : visibilityMoves) {
+        if (dst >= visibilityCount) {
+            continue;
+        }
+        if (src >= visibilityCount) {
+            clears.push_back(dst);
+        } else {
+            copies.push_back(
+                {src * sizeof(uint32_t),
+                 dst * sizeof(uint32_t),
+                 sizeof(uint32_t)}
+            );
+        }
+    }
+    if (copies.empty() && clears.empty()) {
+        return;
+    }
+    // after the last frame's culling wrote the visibility, and before this
+    // frame's transfers touch it again
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask
+        = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(
+        CB,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
         0,
-        _vertexBuffersWriteOffset
+        1,
+        &barrier,
+        0,
+        nullptr,
+        0,
+        nullptr
     );
+    if (!copies.empty()) {
+        vkCmdCopyBuffer(
+            CB,
+            _instanceVisibility.buffer,
+            _instanceVisibility.buffer,
+            copies.size(),
+            copies.data()
+        );
+    }
+    for (uint32_t dst : clears) {
+        vkCmdFillBuffer(
+            CB,
+            _instanceVisibility.buffer,
+            dst * sizeof(uint32_t),
+            sizeof(uint32_t),
+            0
+        );
+    }
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(
+        CB,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        1,
+        &barrier,
+        0,
+        nullptr,
+        0,
+        nullptr
+    );
+}
 
-    CoreUtils::copyVulkanBuffer(
-        _device->logicalDevice,
-        _device->graphicsCommandPool,
-        _device->graphicsQueue,
-        stagingBuffer,
-        _indexBuffers.buffer,
-        indexBufferSize,
-        vertexBufferSize, // skip the vertex buffer region in staging buffer
-        _indexBuffersWriteOffset
+std::vector<BindlessRenderSystemComponent*> BindlessRenderSystem::
+    MakeComponents(
+        const std::string& meshPath,
+        const std::string& texturePath,
+        unsigned int count
+    ) {
+    ASSERT(_textureManager);
+    std::lock_guard<std::mutex> lock(_instanceMutex);
+    std::vector<BindlessRenderSystemComponent*> ret;
+    if (count == 0) {
+        return ret;
+    }
+    const int textureIndex = getTextureIndex(texturePath);
+
+    // the mesh's batch, grown to fit all the instances at once
+    auto it = _modelBatches.find(meshPath);
+    if (it == _modelBatches.end()) {
+        auto res
+            = _modelBatches.insert({meshPath, createRenderBatch(meshPath)});
+        ASSERT(res.second);
+        it = res.first;
+    }
+    RenderBatch& batch = it->second;
+    fitRenderBatch(batch, batch.instanceCount + count);
+
+    // the components are never destroyed on their own, so they're allocated
+    // in one go, and freed along with the system
+    BindlessRenderSystemComponent* components
+        = new BindlessRenderSystemComponent[count];
+    _componentPools.emplace_back(components);
+    ret.reserve(count);
+    _instanceDataSlots.reserve(_instanceDataSlots.size() + count);
+    const uint32_t firstDataIndex = _instanceData.size();
+    _instanceData.reserve(firstDataIndex + count);
+    _instanceTransforms.resize(
+        firstDataIndex + count,
+        {.position = glm::vec3(0.f),
+         .rotation = glm::vec4(0.f, 0.f, 0.f, 1.f),
+         .scale = glm::vec3(1.f)}
+    );
+    for (int i = 0; i < NUM_FRAME_IN_FLIGHT; i++) {
+        _dirtyInstances[i].resize((firstDataIndex + count + 63) / 64, 0);
+        _dirtyTransforms[i].resize((firstDataIndex + count + 63) / 64, 0);
+    }
+
+    const glm::vec4 boundingSphere
+        = _meshBufferData.at(meshPath).boundingSphere;
+
+    const unsigned int drawCmdIndex
+        = batch.drawCmdOffset / sizeof(VkDrawIndexedIndirectCommand);
+    for (unsigned int i = 0; i < count; i++) {
+        batch.instanceCount += 1; // the model now belongs to the batch
+
+        uint32_t slotIndex;
+        if (_freeInstanceSlots.empty()) {
+            slotIndex = _instanceSlots.size();
+            _instanceSlots.emplace_back();
+        } else {
+            slotIndex = _freeInstanceSlots.back();
+            _freeInstanceSlots.pop_back();
+        }
+        InstanceSlot& slot = _instanceSlots[slotIndex];
+        slot.dataIndex = _instanceDataSlots.size();
+        slot.batch = &batch;
+        _instanceDataSlots.push_back(slotIndex);
+
+        BindlessRenderSystemComponent* component = &components[i];
+        component->parentSystem = this;
+        component->handle = {slotIndex, slot.generation};
+        slot.component = component;
+        ret.push_back(component);
+
+        _instanceData.push_back(
+            {.boundingSphere = boundingSphere,
+             .transparency = 0.f,
+             .textureIndex = {.albedo = textureIndex},
+             .drawCmdIndex = drawCmdIndex,
+             .lodCount = batch.lodCount}
+        );
+        markInstanceDirty(slot.dataIndex);
+    }
+    DEBUG(
+        "made {} components of {} at instance data index {}",
+        count,
+        meshPath,
+        firstDataIndex
+    );
+
+    // the new instances are uploaded to each frame in flight as one range.
+    // The cull shader writes the instances' indices into their batch's range
+    // of `instanceIndexArray` and counts them into the batch's draw command
+    // every frame they're visible.
+    return ret;
+}
+
+BindlessRenderSystemComponent* BindlessRenderSystem::MakeComponent(
+    const std::string& meshPath,
+    const std::string& texturePath
+) {
+    return MakeComponents(meshPath, texturePath, 1).front();
+}
+
+int BindlessRenderSystem::getTextureIndex(const std::string& texturePath) {
+    auto it = _textureDescriptorIndices.find(texturePath);
+    if (it != _textureDescriptorIndices.end()) {
+        return it->second;
+    }
+
+    // load texture into textures[textureOffset]
+    int textureOffset = _textureDescriptorIndices.size();
+    if (textureOffset >= TEXTURE_ARRAY_SIZE) {
+        PANIC("Texture array is full, can't load {}", texturePath);
+    }
+    DEBUG("loading {} into {}", texturePath, textureOffset);
+    VkDescriptorImageInfo imageInfo{};
+    _textureManager->GetDescriptorImageInfo(texturePath, imageInfo);
+    writeTextureDescriptor(textureOffset, imageInfo);
+    auto res = _textureDescriptorIndices.insert({texturePath, textureOffset});
+    ASSERT(res.second);
+    return res.first->second;
+}
+
+void BindlessRenderSystem::writeTextureDescriptor(
+    uint32_t textureIndex,
+    const VkDescriptorImageInfo& imageInfo
+) {
+    if (!_device->enabledFeatures12
+             .descriptorBindingSampledImageUpdateAfterBind) {
+        // the set may not be written while the frames in flight use it
+        vkDeviceWaitIdle(_device->logicalDevice);
+    }
+
+    VkWriteDescriptorSet descriptorWrite{};
+    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrite.dstSet = _textureDescriptorSet;
+    descriptorWrite.dstBinding = (int)TextureBindingLocation::TEXTURE_SAMPLER;
+    descriptorWrite.dstArrayElement = textureIndex;
+    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptorWrite.descriptorCount = 1;
+    descriptorWrite.pImageInfo = &imageInfo;
+
+    vkUpdateDescriptorSets(
+        _device->logicalDevice, 1, &descriptorWrite, 0, nullptr
     );
+}
+
+void BindlessRenderSystem::FlagUpdate(Entity* entity) {
+    BindlessRenderSystemComponent* systemComponent
+        = entity->GetComponent<BindlessRenderSystemComponent>();
+    ASSERT(systemComponent);
+    TransformComponent* transform = entity->GetComponent<TransformComponent>();
+    if (transform == nullptr) {
+        return;
+    }
+    // the matrices are built from it on the GPU
+    const glm::quat rotation = transform->GetRotation();
+
+    std::lock_guard<std::mutex> lock(_instanceMutex);
+    const uint32_t dataIndex
+        = getInstanceSlot(systemComponent->handle).dataIndex;
+    _instanceTransforms[dataIndex] = {
+        .position = transform->position,
+        .rotation = glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w),
+        .scale = transform->scale
+    };
+    markTransformDirty(dataIndex);
+}
+
+void BindlessRenderSystem::markInstanceDirty(uint32_t dataIndex) {
+    const uint64_t bit = uint64_t(1) << (dataIndex % 64);
+    for (int i = 0; i < NUM_FRAME_IN_FLIGHT; i++) {
+        _dirtyInstances[i][dataIndex / 64] |= bit;
+        _dirtyTransforms[i][dataIndex / 64] |= bit;
+    }
+}
 
-    // clean up staging buffer
-    vkDestroyBuffer(_device->logicalDevice, stagingBuffer, nullptr);
-    vkFreeMemory(_device->logicalDevice, stagingBufferMemory, nullptr);
+void BindlessRenderSystem::markTransformDirty(uint32_t dataIndex) {
+    for (int i = 0; i < NUM_FRAME_IN_FLIGHT; i++) {
+        _dirtyTransforms[i][dataIndex / 64] |= uint64_t(1) << (dataIndex % 64);
+    }
+}
+
+void BindlessRenderSystem::uploadFrameData(const TickContext* ctx) {
+    const int frame = ctx->graphics.currentFrameInFlight;
+    BindlessBuffer& buffers = _bindlessBuffers[frame];
+    const uint32_t numInstances = _instanceData.size();
+    collectDirtyRanges(_dirtyInstances[frame], numInstances, _uploadRanges);
+    collectDirtyRanges(
+        _dirtyTransforms[frame], numInstances, _transformUploadRanges
+    );
+    // the draw commands and their meshlets are uploaded as a whole
+    const std::pair<uint32_t, uint32_t> drawCommandRange{
+        0, _drawCommands.size()
+    };
+    const size_t numDrawCommandRanges = _drawCommandsDirty[frame] ? 1 : 0;
+    _drawCommandsDirty[frame] = false;
+
+    // a CPU copy, its ranges of elements to upload, and where they go
+    struct Upload
+    {
+        const char* src;
+        size_t stride;
+        const std::pair<uint32_t, uint32_t>* ranges;
+        size_t numRanges;
+        const VQBuffer* dst;
+    };
+
+    const std::array<Upload, 4> uploads = {
+        {{reinterpret_cast<const char*>(_instanceData.data()),
+          sizeof(SSBOInstanceData),
+          _uploadRanges.data(),
+          _uploadRanges.size(),
+          &buffers.instanceDataArray},
+         {reinterpret_cast<const char*>(_instanceTransforms.data()),
+          sizeof(SSBOInstanceTransform),
+          _transformUploadRanges.data(),
+          _transformUploadRanges.size(),
+          &buffers.instanceTransformArray},
+         {reinterpret_cast<const char*>(_drawCommands.data()),
+          sizeof(VkDrawIndexedIndirectCommand),
+          &drawCommandRange,
+          numDrawCommandRanges,
+          &buffers.drawCommandArray},
+         {reinterpret_cast<const char*>(_drawMeshlets.data()),
+          sizeof(SSBOMeshletRange),
+          &drawCommandRange,
+          numDrawCommandRanges,
+          &buffers.drawMeshletArray}}
+    };
+
+    // resizable BAR: write into device memory directly
+    if (_uploadMemoryProperties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        for (const Upload& upload : uploads) {
+            char* dst = reinterpret_cast<char*>(upload.dst->bufferAddress);
+            for (size_t i = 0; i < upload.numRanges; i++) {
+                const auto [begin, end] = upload.ranges[i];
+                memcpy(
+                    dst + begin * upload.stride,
+                    upload.src + begin * upload.stride,
+                    (end - begin) * upload.stride
+                );
+            }
+        }
+        return;
+    }
+
+    // otherwise pack the ranges into the frame's staging buffer, and copy
+    // them over with a region each
+    VkDeviceSize stagingSize = 0;
+    for (const Upload& upload : uploads) {
+        for (size_t i = 0; i < upload.numRanges; i++) {
+            const auto [begin, end] = upload.ranges[i];
+            stagingSize += (end - begin) * upload.stride;
+        }
+    }
+    if (stagingSize == 0) {
+        return;
+    }
+    // the frame's previous uploads have completed
+    reserveBuffer(
+        buffers.stagingBuffer,
+        stagingSize,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+            | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        false
+    );
+    char* staging
+        = reinterpret_cast<char*>(buffers.stagingBuffer.bufferAddress);
+    VkDeviceSize stagingOffset = 0;
+
+    for (const Upload& upload : uploads) {
+        _uploadRegions.clear();
+        for (size_t i = 0; i < upload.numRanges; i++) {
+            const auto [begin, end] = upload.ranges[i];
+            const VkDeviceSize size = (end - begin) * upload.stride;
+            memcpy(
+                staging + stagingOffset,
+                upload.src + begin * upload.stride,
+                size
+            );
+            _uploadRegions.push_back(
+                {stagingOffset, begin * upload.stride, size}
+            );
+            stagingOffset += size;
+        }
+        if (_uploadRegions.empty()) {
+            continue;
+        }
+        vkCmdCopyBuffer(
+            ctx->graphics.CB,
+            buffers.stagingBuffer.buffer,
+            upload.dst->buffer,
+            _uploadRegions.size(),
+            _uploadRegions.data()
+        );
+    }
+    ctx->profiler->Count("Bindless: uploaded bytes", stagingSize);
+}
+
+BindlessRenderSystem::MeshBufferOffsets BindlessRenderSystem::loadMeshBuffer(
+    const std::string& meshPath
+) {
+    DEBUG("Loading mesh into buffer array from {}", meshPath);
+    // mapped from the mesh cache along with its LODs and meshlets, parsed and
+    // processed only if the source file changed
+    MeshCache::CookedMesh mesh = MeshCache::Load(meshPath, _jobSystem);
+
+    std::array<MeshBufferOffsets::MeshLod, MAX_MESH_LODS> lods{};
+    const unsigned int numLods = mesh.GetLodCount();
+    for (unsigned int lod = 0; lod < numLods; lod++) {
+        lods[lod]
+            = {.firstIndex = mesh.GetLod(lod).firstIndex,
+               .numIndices = mesh.GetLod(lod).indexCount};
+    }
+
+    VkDeviceSize vertexBufferSize = sizeof(Vertex) * mesh.GetVertexCount();
+    VkDeviceSize indexBufferSize = sizeof(uint32_t) * mesh.GetIndexCount();
+    VkDeviceSize meshletBufferSize
+        = sizeof(SSBOMeshlet) * mesh.GetMeshletCount();
+
+    // make room in the buffer arrays, the frames in flight keep drawing from
+    // the old buffers
+    reserveBuffer(
+        _vertexBuffers,
+        _vertexBuffersWriteOffset + vertexBufferSize,
+        VERTEX_BUFFER_USAGE | _bufferAddressUsage,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        true
+    );
+    reserveBuffer(
+        _indexBuffers,
+        _indexBuffersWriteOffset + indexBufferSize,
+        INDEX_BUFFER_USAGE,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        true
+    );
+    // bound to the cull descriptor sets, unlike the other two
+    if (reserveBuffer(
+            _meshletBuffer,
+            _meshletBufferWriteOffset + meshletBufferSize,
+            MESHLET_BUFFER_USAGE,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            true
+        )) {
+        _bufferDescriptorsDirty.fill(true);
+    }
+
+    // staged in the upload batch, which lands before the next frame draws
+    _device->uploadManager.Upload(
+        _vertexBuffers.buffer,
+        _vertexBuffersWriteOffset,
+        mesh.GetVertices(),
+        vertexBufferSize
+    );
+    _device->uploadManager.Upload(
+        _indexBuffers.buffer,
+        _indexBuffersWriteOffset,
+        mesh.GetIndices(),
+        indexBufferSize
+    );
+    if (meshletBufferSize > 0) {
+        _device->uploadManager.Upload(
+            _meshletBuffer.buffer,
+            _meshletBufferWriteOffset,
+            mesh.GetMeshlets(),
+            meshletBufferSize
+        );
+    }
 
     MeshBufferOffsets result{
         .vertexBeginOffset = _vertexBuffersWriteOffset,
         .vertexEndOffset = _vertexBuffersWriteOffset + vertexBufferSize,
         .indexBeginOffset = _indexBuffersWriteOffset,
         .indexEndOffset = _indexBuffersWriteOffset + indexBufferSize,
-        .numIndices = indices.size()
+        .meshletBeginOffset = _meshletBufferWriteOffset,
+        .meshletEndOffset = _meshletBufferWriteOffset + meshletBufferSize,
+        .boundingSphere = mesh.GetHeader().boundingSphere,
+        .lods = lods,
+        .numLods = numLods
     };
     // bump write offset
     _vertexBuffersWriteOffset = result.vertexEndOffset;
     _indexBuffersWriteOffset = result.indexEndOffset;
+    _meshletBufferWriteOffset = result.meshletEndOffset;
+    _maxMeshletCount
+        = std::max<unsigned int>(_maxMeshletCount, mesh.GetMeshletCount());
 
     return result;
 }
 
 BindlessRenderSystem::RenderBatch BindlessRenderSystem::createRenderBatch(
-    const std::string& meshPath,
-    unsigned int batchSize
+    const std::string& meshPath
 ) {
     DEBUG("creating render batch for {}", meshPath);
     // look up mesh buffer, if not found, load up the mesh
@@ -847,103 +1910,633 @@ BindlessRenderSystem::RenderBatch BindlessRenderSystem::createRenderBatch(
     }
     const MeshBufferOffsets& meshBuffer = it->second;
 
-    // create a draw command and store into `drawCommandArray`
-    VkDrawIndexedIndirectCommand cmd{};
-    cmd.firstIndex
-        = meshBuffer.indexBeginOffset / sizeof(INDEX_BUFFER_INDEX_TYPE);
-    cmd.indexCount = meshBuffer.numIndices;
-    cmd.vertexOffset = meshBuffer.vertexBeginOffset / sizeof(Vertex);
-    cmd.instanceCount = 0; // draw 0 instance by default
-    cmd.firstInstance = _instanceIndexArrayOffset / sizeof(SSBOInstanceIndex);
-    DEBUG("First instance {}", cmd.firstInstance);
+    RenderBatch batch{
+        .maxSize = 0, .instanceCount = 0, .lodCount = meshBuffer.numLods
+    };
 
-    for (int i = 0; i < NUM_FRAME_IN_FLIGHT; i++) {
-        // copy draw command to this addr
-        // NOTE: here we assume blindless buffer is CPU coherent and
-        // accessible.
-        // TODO: use staging for draw command creation; after creation draw
-        // command is almost never read/written by the CPU
-        void* addr = (char*)_bindlessBuffers[i].drawCommandArray.bufferAddress
-                     + _drawCommandArrayOffset;
+    // reuse the draw commands of an unloaded mesh
+    unsigned int drawCmdIndex;
+    if (!_freeDrawCommands.empty()) {
+        drawCmdIndex = _freeDrawCommands.back();
+        _freeDrawCommands.pop_back();
+    } else {
+        drawCmdIndex = _drawCommands.size();
+        _drawCommands.resize(drawCmdIndex + MAX_MESH_LODS);
+        _drawMeshlets.resize(drawCmdIndex + MAX_MESH_LODS);
+    }
+    batch.drawCmdOffset = drawCmdIndex * sizeof(VkDrawIndexedIndirectCommand);
+
+    // create a draw command per LOD and store into `drawCommandArray`
+    for (unsigned int lod = 0; lod < MAX_MESH_LODS; lod++) {
+        VkDrawIndexedIndirectCommand& cmd = _drawCommands[drawCmdIndex + lod];
+        cmd = {};
+        if (lod < meshBuffer.numLods) {
+            cmd.firstIndex
+                = meshBuffer.indexBeginOffset / sizeof(INDEX_BUFFER_INDEX_TYPE)
+                  + meshBuffer.lods[lod].firstIndex;
+            cmd.indexCount = meshBuffer.lods[lod].numIndices;
+        }
+        cmd.vertexOffset = meshBuffer.vertexBeginOffset / sizeof(Vertex);
+        cmd.instanceCount = 0; // draw 0 instance by default
+        cmd.firstInstance = 0; // set by `fitRenderBatch()`
+        _drawMeshlets[drawCmdIndex + lod] = {};
+    }
+    // only LOD 0 is drawn by meshlets
+    _drawMeshlets[drawCmdIndex] = {
+        .firstMeshlet = (uint32_t)(meshBuffer.meshletBeginOffset
+                                   / sizeof(SSBOMeshlet)),
+        .meshletCount = (uint32_t)((meshBuffer.meshletEndOffset
+                                    - meshBuffer.meshletBeginOffset)
+                                   / sizeof(SSBOMeshlet))
+    };
+    _drawCommandsDirty.fill(true);
+
+    return batch;
+}
 
-        memcpy(addr, std::addressof(cmd), sizeof(cmd));
-        // NOTE: we only handle creation of drawCommand, but not deletion so
-        // far
+void BindlessRenderSystem::fitRenderBatch(
+    RenderBatch& batch,
+    unsigned int instanceCount
+) {
+    // room for the count to double before the next move, in every LOD
+    const unsigned int size = instanceCount * 2 * batch.lodCount;
+    // fits, and not by much -- though none at all releases the range
+    const unsigned int lodSize = batch.maxSize / batch.lodCount;
+    const bool sameBlock
+        = instanceCount > 0
+          && batch.maxSize == _instanceIndexAllocator.GetBlockSize(size);
+    if (instanceCount <= lodSize && (instanceCount * 4 > lodSize || sameBlock)) {
+        return;
+    }
+    VkDrawIndexedIndirectCommand* cmds = &_drawCommands
+        [batch.drawCmdOffset / sizeof(VkDrawIndexedIndirectCommand)];
+    // freed first, so that the block may grow into its buddy
+    if (batch.maxSize > 0) {
+        _instanceIndexAllocator.Free(cmds[0].firstInstance, batch.maxSize);
     }
+    batch.maxSize = 0;
+    unsigned int firstInstance = 0;
+    if (instanceCount > 0) {
+        firstInstance = _instanceIndexAllocator.Allocate(size);
+        batch.maxSize = _instanceIndexAllocator.GetBlockSize(size);
+    }
+    for (unsigned int lod = 0; lod < batch.lodCount; lod++) {
+        cmds[lod].firstInstance
+            = firstInstance + lod * (batch.maxSize / batch.lodCount);
+    }
+    DEBUG(
+        "Fit render batch of {} instances into [{}, {})",
+        instanceCount,
+        firstInstance,
+        firstInstance + batch.maxSize
+    );
+    _drawCommandsDirty.fill(true);
+}
 
-    RenderBatch batch{
-        .maxSize = batchSize,
-        .instanceCount = 0,
-        .drawCmdOffset = _drawCommandArrayOffset
-    };
+void BindlessRenderSystem::unloadMesh(const std::string& meshPath) {
+    DEBUG("Unloading mesh {}", meshPath);
+    // the draw commands stay, drawing nothing
+    RenderBatch& batch = _modelBatches.at(meshPath);
+    ASSERT(batch.instanceCount == 0);
+    fitRenderBatch(batch, 0);
+    const unsigned int drawCmdIndex
+        = batch.drawCmdOffset / sizeof(VkDrawIndexedIndirectCommand);
+    for (unsigned int lod = 0; lod < MAX_MESH_LODS; lod++) {
+        _drawCommands[drawCmdIndex + lod].indexCount = 0;
+        _drawMeshlets[drawCmdIndex + lod] = {};
+    }
+    _freeDrawCommands.push_back(drawCmdIndex);
+    _drawCommandsDirty.fill(true);
+    _modelBatches.erase(meshPath);
+    _meshBufferData.erase(meshPath);
+    _maxMeshletCount = 0;
+    for (const auto& [path, meshBuffer] : _meshBufferData) {
+        _maxMeshletCount = std::max<unsigned int>(
+            _maxMeshletCount,
+            (meshBuffer.meshletEndOffset - meshBuffer.meshletBeginOffset)
+                / sizeof(SSBOMeshlet)
+        );
+    }
 
-    // bump offsets
+    defragmentMeshBuffers();
+}
 
-    // added a new draw command
-    _drawCommandArrayOffset += sizeof(VkDrawIndexedIndirectCommand);
+void BindlessRenderSystem::defragmentMeshBuffers() {
+    // move the meshes into new buffers rather than in place: the frames in
+    // flight still draw from the old ones
+    VQBuffer vertexBuffers{};
+    VQBuffer indexBuffers{};
+    VQBuffer meshletBuffer{};
+    _device->CreateBufferInPlace(
+        _vertexBuffers.size,
+        VERTEX_BUFFER_USAGE | _bufferAddressUsage,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        vertexBuffers
+    );
+    _device->CreateBufferInPlace(
+        _indexBuffers.size,
+        INDEX_BUFFER_USAGE,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        indexBuffers
+    );
+    _device->CreateBufferInPlace(
+        _meshletBuffer.size,
+        MESHLET_BUFFER_USAGE,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        meshletBuffer
+    );
 
-    // reserve `instanceNumber` * sizeof(unsigned int) in
-    // instanceLookupArray
-    // bumping the offset will do so
-    _instanceIndexArrayOffset += batchSize * sizeof(SSBOInstanceIndex);
+    std::vector<VkBufferCopy> vertexCopies;
+    std::vector<VkBufferCopy> indexCopies;
+    std::vector<VkBufferCopy> meshletCopies;
+    unsigned long vertexWriteOffset = 0;
+    unsigned long indexWriteOffset = 0;
+    unsigned long meshletWriteOffset = 0;
+    for (auto& [meshPath, meshBuffer] : _meshBufferData) {
+        const unsigned long vertexSize
+            = meshBuffer.vertexEndOffset - meshBuffer.vertexBeginOffset;
+        const unsigned long indexSize
+            = meshBuffer.indexEndOffset - meshBuffer.indexBeginOffset;
+        vertexCopies.push_back(
+            {meshBuffer.vertexBeginOffset, vertexWriteOffset, vertexSize}
+        );
+        indexCopies.push_back(
+            {meshBuffer.indexBeginOffset, indexWriteOffset, indexSize}
+        );
+        meshBuffer.vertexBeginOffset = vertexWriteOffset;
+        meshBuffer.vertexEndOffset = vertexWriteOffset + vertexSize;
+        meshBuffer.indexBeginOffset = indexWriteOffset;
+        meshBuffer.indexEndOffset = indexWriteOffset + indexSize;
+        vertexWriteOffset = meshBuffer.vertexEndOffset;
+        indexWriteOffset = meshBuffer.indexEndOffset;
+
+        const unsigned long meshletSize
+            = meshBuffer.meshletEndOffset - meshBuffer.meshletBeginOffset;
+        if (meshletSize > 0) {
+            meshletCopies.push_back(
+                {meshBuffer.meshletBeginOffset, meshletWriteOffset, meshletSize}
+            );
+        }
+        meshBuffer.meshletBeginOffset = meshletWriteOffset;
+        meshBuffer.meshletEndOffset = meshletWriteOffset + meshletSize;
+        meshletWriteOffset = meshBuffer.meshletEndOffset;
+
+        // point the mesh's draw commands to where it's moved
+        const unsigned int drawCmdIndex
+            = _modelBatches.at(meshPath).drawCmdOffset
+              / sizeof(VkDrawIndexedIndirectCommand);
+        VkDrawIndexedIndirectCommand* cmds = &_drawCommands[drawCmdIndex];
+        for (unsigned int lod = 0; lod < meshBuffer.numLods; lod++) {
+            cmds[lod].firstIndex
+                = meshBuffer.indexBeginOffset / sizeof(INDEX_BUFFER_INDEX_TYPE)
+                  + meshBuffer.lods[lod].firstIndex;
+            cmds[lod].vertexOffset
+                = meshBuffer.vertexBeginOffset / sizeof(Vertex);
+        }
+        _drawMeshlets[drawCmdIndex].firstMeshlet
+            = meshBuffer.meshletBeginOffset / sizeof(SSBOMeshlet);
+    }
+    _drawCommandsDirty.fill(true);
+
+    if (!vertexCopies.empty()) {
+        // meshes uploaded since the last frame are moved along as well
+        _device->uploadManager.TransferBarrier();
+        VkCommandBuffer CB = _device->uploadManager.GetCommandBuffer();
+        vkCmdCopyBuffer(
+            CB,
+            _vertexBuffers.buffer,
+            vertexBuffers.buffer,
+            vertexCopies.size(),
+            vertexCopies.data()
+        );
+        vkCmdCopyBuffer(
+            CB,
+            _indexBuffers.buffer,
+            indexBuffers.buffer,
+            indexCopies.size(),
+            indexCopies.data()
+        );
+        if (!meshletCopies.empty()) {
+            vkCmdCopyBuffer(
+                CB,
+                _meshletBuffer.buffer,
+                meshletBuffer.buffer,
+                meshletCopies.size(),
+                meshletCopies.data()
+            );
+        }
+    }
+    DEBUG(
+        "Defragmented mesh buffers: vertex {} -> {}, index {} -> {} bytes",
+        _vertexBuffersWriteOffset,
+        vertexWriteOffset,
+        _indexBuffersWriteOffset,
+        indexWriteOffset
+    );
 
-    return batch;
+    retireBuffer(_vertexBuffers);
+    retireBuffer(_indexBuffers);
+    retireBuffer(_meshletBuffer);
+    _vertexBuffers = vertexBuffers;
+    _indexBuffers = indexBuffers;
+    _meshletBuffer = meshletBuffer;
+    _vertexBuffersWriteOffset = vertexWriteOffset;
+    _indexBuffersWriteOffset = indexWriteOffset;
+    _meshletBufferWriteOffset = meshletWriteOffset;
+    _bufferDescriptorsDirty.fill(true);
+}
+
+void BindlessRenderSystem::retireBuffer(const VQBuffer& buffer) {
+    // a frame recorded after the buffer was replaced might still read it
+    // through `CB` of `reserveBuffer()`, until that frame completes, and the
+    // upload batch being recorded might copy out of it
+    _retiredBuffers.push_back(
+        {buffer,
+         NUM_FRAME_IN_FLIGHT,
+         _device->uploadManager.GetCurrentTicket()}
+    );
+}
+
+bool BindlessRenderSystem::reserveBuffer(
+    VQBuffer& buffer,
+    VkDeviceSize requiredSize,
+    VkBufferUsageFlags usage,
+    VkMemoryPropertyFlags properties,
+    bool preserve,
+    VkCommandBuffer CB
+) {
+    if (requiredSize <= buffer.size) {
+        return false;
+    }
+    VkDeviceSize size
+        = std::max(requiredSize, buffer.size * BUFFER_GROWTH_FACTOR);
+    DEBUG("Growing buffer from {} to {} bytes", buffer.size, size);
+
+    VQBuffer newBuffer{};
+    _device->CreateBufferInPlace(size, usage, properties, newBuffer);
+    if (preserve && buffer.size > 0) {
+        if (buffer.bufferAddress && newBuffer.bufferAddress) {
+            memcpy(newBuffer.bufferAddress, buffer.bufferAddress, buffer.size);
+        } else if (CB != VK_NULL_HANDLE) {
+            VkBufferCopy copy{0, 0, buffer.size};
+            vkCmdCopyBuffer(CB, buffer.buffer, newBuffer.buffer, 1, &copy);
+        } else {
+            // recorded between the batch's earlier uploads into the old
+            // buffer and its later ones into the new
+            VQUploadManager& uploads = _device->uploadManager;
+            uploads.TransferBarrier();
+            VkBufferCopy copy{0, 0, buffer.size};
+            vkCmdCopyBuffer(
+                uploads.GetCommandBuffer(),
+                buffer.buffer,
+                newBuffer.buffer,
+                1,
+                &copy
+            );
+            uploads.TransferBarrier();
+        }
+    }
+    retireBuffer(buffer);
+    buffer = newBuffer;
+    return true;
+}
+
+void BindlessRenderSystem::reserveFrameBuffers(const TickContext* ctx) {
+    const int frame = ctx->graphics.currentFrameInFlight;
+    BindlessBuffer& buffers = _bindlessBuffers[frame];
+    const VkDeviceSize numInstances = _instanceData.size();
+    const VkDeviceSize numDrawCommands = _drawCommands.size();
+
+    bool grown = false;
+    // rather than copying the old contents over, the whole CPU copy is
+    // uploaded into the new buffer
+    if (reserveBuffer(
+            buffers.instanceDataArray,
+            numInstances * sizeof(SSBOInstanceData),
+            INSTANCE_DATA_USAGE | _bufferAddressUsage,
+            _uploadMemoryProperties,
+            false
+        )) {
+        std::fill(
+            _dirtyInstances[frame].begin(),
+            _dirtyInstances[frame].end(),
+            ~uint64_t(0)
+        );
+        grown = true;
+    }
+    if (reserveBuffer(
+            buffers.instanceTransformArray,
+            numInstances * sizeof(SSBOInstanceTransform),
+            INSTANCE_DATA_USAGE,
+            _uploadMemoryProperties,
+            false
+        )) {
+        std::fill(
+            _dirtyTransforms[frame].begin(),
+            _dirtyTransforms[frame].end(),
+            ~uint64_t(0)
+        );
+        grown = true;
+    }
+    // rewritten by every frame's transform pass
+    grown |= reserveBuffer(
+        buffers.instanceMatrixArray,
+        numInstances * sizeof(SSBOInstanceMatrices),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | _bufferAddressUsage,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        false
+    );
+    // the buffers below are rewritten by every frame's culling. The
+    // clustered instances of both phases follow the render batches' ranges.
+    grown |= reserveBuffer(
+        buffers.instanceIndexArray,
+        (_instanceIndexAllocator.GetCapacity() + 2 * MAX_CLUSTERED_INSTANCES)
+            * sizeof(SSBOInstanceIndex),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | _bufferAddressUsage,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        false
+    );
+    if (reserveBuffer(
+            buffers.drawCommandArray,
+            numDrawCommands * sizeof(VkDrawIndexedIndirectCommand),
+            DRAW_COMMAND_USAGE,
+            _uploadMemoryProperties,
+            false
+        )) {
+        _drawCommandsDirty[frame] = true;
+        grown = true;
+    }
+    if (reserveBuffer(
+            buffers.drawMeshletArray,
+            numDrawCommands * sizeof(SSBOMeshletRange),
+            DRAW_COMMAND_USAGE,
+            _uploadMemoryProperties,
+            false
+        )) {
+        _drawCommandsDirty[frame] = true;
+        grown = true;
+    }
+    grown |= reserveBuffer(
+        buffers.compactedDrawCommandArray,
+        numDrawCommands * sizeof(VkDrawIndexedIndirectCommand),
+        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT
+            | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        false
+    );
+    grown |= reserveBuffer(
+        buffers.lateDrawCommandArray,
+        numDrawCommands * sizeof(VkDrawIndexedIndirectCommand),
+        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT
+            | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        false
+    );
+    grown |= reserveBuffer(
+        buffers.earlyInstanceCounts,
+        numDrawCommands * sizeof(uint32_t),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        false
+    );
+    grown |= reserveBuffer(
+        buffers.meshletDrawCommandArray,
+        2 * getMeshletDrawCapacity() * sizeof(VkDrawIndexedIndirectCommand),
+        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT
+            | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        false
+    );
+    if (grown) {
+        _bufferDescriptorsDirty[frame] = true;
+    }
+
+    // shared by all frames: the old visibility is copied on the GPU, and the
+    // new instances start out invisible
+    const VkDeviceSize oldVisibilitySize = _instanceVisibility.size;
+    const VkDeviceSize visibilitySize = numInstances * sizeof(uint32_t);
+    if (visibilitySize > oldVisibilitySize && oldVisibilitySize > 0) {
+        // the previous frame's late culling may still be writing the old
+        // visibility the copy reads
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask
+            = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier(
+            ctx->graphics.CB,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            1,
+            &barrier,
+            0,
+            nullptr,
+            0,
+            nullptr
+        );
+    }
+    if (reserveBuffer(
+            _instanceVisibility,
+            visibilitySize,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+                | VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+                | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            true,
+            ctx->graphics.CB
+        )) {
+        vkCmdFillBuffer(
+            ctx->graphics.CB,
+            _instanceVisibility.buffer,
+            oldVisibilitySize,
+            VK_WHOLE_SIZE,
+            0
+        );
+        _bufferDescriptorsDirty.fill(true);
+    }
 }
 
 void BindlessRenderSystem::createBindlessResources() {
+    // with resizable BAR the host writes straight into VRAM, otherwise the
+    // writes are staged
+    if (_device->HasLargeHostVisibleDeviceLocalMemory()) {
+        INFO("Writing bindless instance data directly into device memory");
+        _uploadMemoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+                                  | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+                                  | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    } else {
+        _uploadMemoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    }
+
     for (int i = 0; i < NUM_FRAME_IN_FLIGHT; i++) {
         _device->CreateBufferInPlace(
-            5000,
-            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-                | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            INITIAL_DRAW_COMMAND_CAPACITY
+                * sizeof(VkDrawIndexedIndirectCommand),
+            DRAW_COMMAND_USAGE,
+            _uploadMemoryProperties,
             _bindlessBuffers[i].drawCommandArray
         );
+        // only ever written by the GPU
         _device->CreateBufferInPlace(
-            5000,
-            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            INITIAL_DRAW_COMMAND_CAPACITY
+                * sizeof(VkDrawIndexedIndirectCommand),
+            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT
+                | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            _bindlessBuffers[i].compactedDrawCommandArray
+        );
+        _device->CreateBufferInPlace(
+            INITIAL_DRAW_COMMAND_CAPACITY
+                * sizeof(VkDrawIndexedIndirectCommand),
+            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT
+                | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            _bindlessBuffers[i].lateDrawCommandArray
+        );
+        // early and late draw counts
+        _device->CreateBufferInPlace(
+            4 * sizeof(uint32_t),
+            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT
+                | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+                | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            _bindlessBuffers[i].drawCount
+        );
+        _device->CreateBufferInPlace(
+            INITIAL_DRAW_COMMAND_CAPACITY * sizeof(SSBOMeshletRange),
+            DRAW_COMMAND_USAGE,
+            _uploadMemoryProperties,
+            _bindlessBuffers[i].drawMeshletArray
+        );
+        // only ever written by the GPU, grown once meshes with meshlets load
+        _device->CreateBufferInPlace(
+            INITIAL_DRAW_COMMAND_CAPACITY
+                * sizeof(VkDrawIndexedIndirectCommand),
+            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT
+                | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            _bindlessBuffers[i].meshletDrawCommandArray
+        );
+        // dispatch and draw count of either phase
+        _device->CreateBufferInPlace(
+            8 * sizeof(uint32_t),
+            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT
+                | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+                | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            _bindlessBuffers[i].meshletCounts
+        );
+        _device->CreateBufferInPlace(
+            INITIAL_INSTANCE_CAPACITY * sizeof(SSBOInstanceData),
+            INSTANCE_DATA_USAGE | _bufferAddressUsage,
+            _uploadMemoryProperties,
+            _bindlessBuffers[i].instanceDataArray
+        );
+        _device->CreateBufferInPlace(
+            INITIAL_INSTANCE_CAPACITY * sizeof(SSBOInstanceTransform),
+            INSTANCE_DATA_USAGE,
+            _uploadMemoryProperties,
+            _bindlessBuffers[i].instanceTransformArray
+        );
+        // only ever written by the GPU
+        _device->CreateBufferInPlace(
+            INITIAL_INSTANCE_CAPACITY * sizeof(SSBOInstanceMatrices),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | _bufferAddressUsage,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            _bindlessBuffers[i].instanceMatrixArray
+        );
+        _device->CreateBufferInPlace(
+            INITIAL_INSTANCE_INDEX_CAPACITY * sizeof(SSBOInstanceIndex),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | _bufferAddressUsage,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            _bindlessBuffers[i].instanceIndexArray
+        );
+        _device->CreateBufferInPlace(
+            INITIAL_STAGING_BUFFER_SIZE,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
                 | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            _bindlessBuffers[i].instanceDataArray
+            _bindlessBuffers[i].stagingBuffer
         );
         _device->CreateBufferInPlace(
-            5000,
+            INITIAL_DRAW_COMMAND_CAPACITY * sizeof(uint32_t),
             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            _bindlessBuffers[i].earlyInstanceCounts
+        );
+        // read back by the host
+        _device->CreateBufferInPlace(
+            sizeof(CullStats),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+                | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
                 | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            _bindlessBuffers[i].instanceIndexArray
+            _bindlessBuffers[i].cullStats
+        );
+        memset(
+            _bindlessBuffers[i].cullStats.bufferAddress, 0, sizeof(CullStats)
         );
     }
 
+    // shared by all frames in flight: each frame's cull reads the visibility
+    // the previous frame wrote
+    _device->CreateBufferInPlace(
+        INITIAL_INSTANCE_CAPACITY * sizeof(uint32_t),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+            | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        _instanceVisibility
+    );
+
     _deletionStack.push([this]() {
         for (int i = 0; i < NUM_FRAME_IN_FLIGHT; i++) {
             _bindlessBuffers[i].instanceIndexArray.Cleanup();
             _bindlessBuffers[i].drawCommandArray.Cleanup();
+            _bindlessBuffers[i].drawMeshletArray.Cleanup();
+            _bindlessBuffers[i].meshletDrawCommandArray.Cleanup();
+            _bindlessBuffers[i].meshletCounts.Cleanup();
+            _bindlessBuffers[i].compactedDrawCommandArray.Cleanup();
+            _bindlessBuffers[i].drawCount.Cleanup();
             _bindlessBuffers[i].instanceDataArray.Cleanup();
+            _bindlessBuffers[i].instanceTransformArray.Cleanup();
+            _bindlessBuffers[i].instanceMatrixArray.Cleanup();
+            _bindlessBuffers[i].lateDrawCommandArray.Cleanup();
+            _bindlessBuffers[i].earlyInstanceCounts.Cleanup();
+            _bindlessBuffers[i].cullStats.Cleanup();
+            _bindlessBuffers[i].stagingBuffer.Cleanup();
+        }
+        _instanceVisibility.Cleanup();
+        for (RetiredBuffer& retired : _retiredBuffers) {
+            retired.buffer.Cleanup();
         }
+        _retiredBuffers.clear();
     });
 
-    // allocate large vertex and index buffer
+    // allocate large vertex, index and meshlet buffer
     _device->CreateBufferInPlace(
-        500000,
-        VK_BUFFER_USAGE_TRANSFER_DST_BIT // can be used as destination in a
-                                         // memory transfer operation
-            | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+        INITIAL_MESH_BUFFER_SIZE,
+        VERTEX_BUFFER_USAGE | _bufferAddressUsage,
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
         _vertexBuffers
     );
     _device->CreateBufferInPlace(
-        500000,
-        VK_BUFFER_USAGE_TRANSFER_DST_BIT // can be used as destination in a
-                                         // memory transfer operation
-            | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+        INITIAL_MESH_BUFFER_SIZE,
+        INDEX_BUFFER_USAGE,
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
         _indexBuffers
     );
+    _device->CreateBufferInPlace(
+        INITIAL_MESHLET_BUFFER_SIZE,
+        MESHLET_BUFFER_USAGE,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        _meshletBuffer
+    );
 
     _deletionStack.push([this]() {
-        DEBUG("Cleaning up vertex & index buffers");
+        DEBUG("Cleaning up vertex, index & meshlet buffers");
         _vertexBuffers.Cleanup();
         _indexBuffers.Cleanup();
+        _meshletBuffer.Cleanup();
     });
 }
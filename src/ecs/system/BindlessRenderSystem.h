@@ -1,8 +1,13 @@
 #pragma once
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <unordered_set>
 #include <vulkan/vulkan_core.h>
 
+#include "components/BuddyAllocator.h"
 #include "components/DeletionStack.h"
+#include "components/MeshCache.h"
 #include "lib/VQBuffer.h"
 #include "lib/VQUtils.h"
 
@@ -15,8 +20,26 @@
 class BindlessRenderSystem : public IRenderSystem
 {
   public:
+    // flushes the queued updates of its components' device data in
+    // `PrepareFrame()`
+    BindlessRenderSystem() { Writes<BindlessRenderSystemComponent>(); }
+
     virtual void Init(const InitContext* initData) override;
+    // upload changed instance data, cull all instances against the view
+    // frustum and build the frame's draw commands on the GPU
+    virtual void PrepareFrame(const TickContext* tickData) override;
     virtual void Tick(const TickContext* tickData) override;
+
+    // With a depth pyramid, instances are occlusion culled in two phases:
+    // `Tick()` draws the instances visible last frame, then
+    // `PrepareLateFrame()` tests the others against the depth pyramid of what
+    // it drew, and `TickLate()` draws the ones that turned out visible.
+    virtual bool HasLatePass() const override {
+        return _depthPyramid != nullptr;
+    }
+
+    virtual void PrepareLateFrame(const TickContext* tickData) override;
+    virtual void TickLate(const TickContext* tickData) override;
     virtual void Cleanup() override;
 
     virtual void AddEntity(Entity* entity) override;
@@ -28,27 +51,29 @@ class BindlessRenderSystem : public IRenderSystem
         const std::string& texturePath
     );
 
-    // Create components in batch
+    // Create `count` components at once, growing their mesh's render batch
+    // at most once, with their instance data uploaded as a single range per
+    // frame in flight. Prefer this over repeated `MakeComponent()` calls.
     std::vector<BindlessRenderSystemComponent*> MakeComponents(
         const std::string& meshPath,
         const std::string& texturePath,
         unsigned int count
     );
 
-    // Destroy the rendering component, releasing all resources
+    // Destroy the rendering component in O(1), invalidating its handle. The
+    // instance stops being drawn right away; its slot is reclaimed once no
+    // frame in flight can still read it, by moving the last instance into
+    // its place in the instance data array. A mesh without instances left is
+    // unloaded from the vertex and index buffers, which are then
+    // defragmented.
     //
-    // TODO: this is not tested
-    // FIXME: this is also not thread safe. Need to figure out a global
-    // thread-safe paradigm to update rendering resources
-    // can either:
-    // 1. wait for all frame in flight to finish processing, lock the rendering
-    // thread and perform updates on rendering resources
-    // 2. make additional copies of resrouces such as _instanceDataArrayOffset,
-    // s.t. each frame in flight have their own resource, and then can safely perform
-    // update in compute shaders&render loop
+    // Only `FlagUpdate()` is thread safe. `MakeComponent(s)()` and
+    // `DestroyComponent()` may load, unload and move meshes and textures on
+    // the GPU, and must be called from the thread that submits frames.
     void DestroyComponent(BindlessRenderSystemComponent* component);
 
-    // flag the entity as dirty, so that its buffer will be flushed
+    // flag the entity as dirty, so that its transform will be flushed to
+    // every frame in flight. The transform is read right away.
     void FlagUpdate(Entity* entity);
 
   private:
@@ -58,10 +83,40 @@ class BindlessRenderSystem : public IRenderSystem
         UBO_STATIC_ENGINE = 0,
         INSTANCE_DATA = 1,
         INSTANCE_INDEX = 2,
-        TEXTURE_SAMPLER = 3
+        INSTANCE_MATRIX = 3
+    };
+    // the textures are bound as a set of their own, shared by all frames
+    enum class TextureBindingLocation : unsigned int
+    {
+        TEXTURE_SAMPLER = 0
     };
     const char* VERTEX_SHADER_SRC = "../shaders/bindless.vert.spv";
+    // `VERTEX_SHADER_SRC` reaching its buffers through their device addresses
+    const char* VERTEX_SHADER_BDA_SRC = "../shaders/bindless_bda.vert.spv";
     const char* FRAGMENT_SHADER_SRC = "../shaders/bindless.frag.spv";
+    const char* CULL_SHADER_SRC = "../shaders/bindless_cull.comp.spv";
+    const char* CULL_LATE_SHADER_SRC
+        = "../shaders/bindless_cull_late.comp.spv";
+    const char* COMPACT_SHADER_SRC = "../shaders/bindless_compact.comp.spv";
+    const char* TRANSFORM_SHADER_SRC
+        = "../shaders/bindless_transform.comp.spv";
+    const char* MESHLET_CULL_SHADER_SRC
+        = "../shaders/bindless_meshlet_cull.comp.spv";
+
+    // buffer device addresses of the buffers the vertex shader reads, pushed
+    // with every pass in place of their descriptors
+    struct DrawPushConstants
+    {
+        VkDeviceAddress instanceDataArray;
+        VkDeviceAddress instanceIndexArray;
+        VkDeviceAddress instanceMatrixArray;
+        VkDeviceAddress vertexArray;
+    };
+
+    // `VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT` if the device supports
+    // buffer device addresses, given to the buffers in `DrawPushConstants`
+    VkBufferUsageFlags _bufferAddressUsage = 0;
+    bool useBufferDeviceAddress() const { return _bufferAddressUsage != 0; }
 
     // pipeline
     VkPipeline _pipeline = VK_NULL_HANDLE;
@@ -73,19 +128,105 @@ class BindlessRenderSystem : public IRenderSystem
 
     std::array<VkDescriptorSet, NUM_FRAME_IN_FLIGHT> _descriptorSets;
 
+    // set 1 of `_pipelineLayout`. Its texture array is partially bound and
+    // updated after bind, so a new texture is written into it once, while
+    // the frames in flight keep drawing with the textures before it.
+    VkDescriptorSetLayout _textureDescriptorSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool _textureDescriptorPool = VK_NULL_HANDLE;
+    VkDescriptorSet _textureDescriptorSet = VK_NULL_HANDLE;
+
+    /* ---------- Culling Pipelines ---------- */
+    enum class CullBindingLocation : unsigned int
+    {
+        INSTANCE_DATA = 0,
+        DRAW_COMMAND = 1,
+        INSTANCE_INDEX = 2,
+        COMPACTED_DRAW_COMMAND = 3,
+        DRAW_COUNT = 4,
+        LATE_DRAW_COMMAND = 5,
+        EARLY_INSTANCE_COUNT = 6,
+        INSTANCE_VISIBILITY = 7,
+        CULL_STATS = 8,
+        UBO_STATIC_ENGINE = 9,
+        DEPTH_PYRAMID = 10,
+        INSTANCE_TRANSFORM = 11,
+        INSTANCE_MATRIX = 12,
+        MESHLET = 13,
+        DRAW_MESHLETS = 14,
+        MESHLET_DRAW_COMMAND = 15,
+        MESHLET_COUNTS = 16
+    };
+
+    // which instances a cull dispatch draws
+    enum class CullPhase : uint32_t
+    {
+        ALL = 0,   // every instance in the frustum, without a depth pyramid
+        EARLY = 1, // the instances in the frustum that were visible last frame
+        LATE = 2   // the other instances that pass the depth pyramid
+    };
+
+    // workgroup size of the culling and transform shaders
+    static const unsigned int CULL_WORKGROUP_SIZE = 64;
+
+    // shared by the culling and transform shaders
+    struct CullPushConstants
+    {
+        glm::vec4 frustumPlanes[6]; // world space, normals point inwards
+        uint32_t instanceCount;
+        uint32_t drawCount;
+        CullPhase phase;
+        // of the clustered instances of the early phase in
+        // `instanceIndexArray`, those of the late phase follow
+        uint32_t clusterInstanceOffset;
+        // # of meshlet draws of each phase, 0 without meshlet culling
+        uint32_t meshletDrawCapacity;
+        // whether back-facing meshlets are culled, see `CULL_BACK_FACES`
+        uint32_t coneCulling;
+    };
+
+    // instance counts of a frame's culling, on `BindlessBuffer::cullStats`
+    struct CullStats
+    {
+        uint32_t visible;
+        uint32_t frustumCulled;
+        uint32_t occluded;
+        // off-screen or back-facing meshlets of visible instances
+        uint32_t meshletsCulled;
+    };
+
+    // culls instances, filling `instanceIndexArray` and the instance counts
+    // of `drawCommandArray`
+    VkPipeline _cullPipeline = VK_NULL_HANDLE;
+    // `_cullPipeline` of `CullPhase::LATE`, tests against the depth pyramid
+    VkPipeline _cullLatePipeline = VK_NULL_HANDLE;
+    // packs the draw commands with visible instances to the front of
+    // `compactedDrawCommandArray`
+    VkPipeline _compactPipeline = VK_NULL_HANDLE;
+    // expands `instanceTransformArray` into `instanceMatrixArray`, before
+    // culling
+    VkPipeline _transformPipeline = VK_NULL_HANDLE;
+    // culls the meshlets of the clustered instances the cull shaders passed
+    // on, a workgroup per instance, emitting a draw per visible meshlet into
+    // `meshletDrawCommandArray`
+    VkPipeline _meshletCullPipeline = VK_NULL_HANDLE;
+    VkPipelineLayout _cullPipelineLayout = VK_NULL_HANDLE;
+    VkDescriptorSetLayout _cullDescriptorSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool _cullDescriptorPool = VK_NULL_HANDLE;
+    std::array<VkDescriptorSet, NUM_FRAME_IN_FLIGHT> _cullDescriptorSets;
+
+    // nullptr without occlusion culling
+    const DepthPyramid* _depthPyramid = nullptr;
+    // view of `_depthPyramid` each frame's `_cullDescriptorSets` reads, the
+    // pyramid is re-created along with the swapchain
+    std::array<VkImageView, NUM_FRAME_IN_FLIGHT> _cullDepthPyramidViews{};
+
     VQDevice* _device = nullptr;
+    // parses meshes missing from the mesh cache in parallel
+    JobSystem* _jobSystem = nullptr;
 
     /* ---------- Texture Resources ---------- */
     TextureManager* _textureManager;
 
-    // an array of texture descriptors that gets filled up as textures are
-    // loaded in
-    std::array<VkDescriptorImageInfo, TEXTURE_ARRAY_SIZE>
-        _textureDescriptorInfo;
-    size_t _textureDescriptorInfoIdx
-        = 0; // idx to the current texture descriptor that can be written in,
-             // also represents the total # of valid texture descriptors,
-             // starting from the beginning of the _textureDescriptorInfo array
     std::unordered_map<std::string, int>
         _textureDescriptorIndices; // texture name, index into the
                                    // texture descriptor array
@@ -105,7 +246,8 @@ class BindlessRenderSystem : public IRenderSystem
     // lives on the `instanceDataArray` buffer
     struct SSBOInstanceData
     {
-        glm::mat4 model;
+        // object space bounding sphere of the mesh, center in xyz, radius in w
+        glm::vec4 boundingSphere;
         float transparency;
 
         struct
@@ -114,76 +256,307 @@ class BindlessRenderSystem : public IRenderSystem
         } textureIndex;
 
         // none-render metadata
-        const unsigned int drawCmdIndex; // index into draw cmd
-
-        const uint32_t padding[1];
+        unsigned int drawCmdIndex; // index into draw cmd, of the mesh's LOD 0
+        // # of LODs of the mesh, drawn by the commands from `drawCmdIndex` on
+        unsigned int lodCount;
     };
 
     static_assert(sizeof(SSBOInstanceData) % SSBO_INSTANCE_DATA_ALIGNMENT == 0);
 
+    // transform per bindless system instance, the only instance data that
+    // changes every frame. Lives on the `instanceTransformArray` buffer, read
+    // as a tightly packed float array.
+    struct SSBOInstanceTransform
+    {
+        glm::vec3 position;
+        glm::vec4 rotation; // quaternion, xyz imaginary, w real
+        glm::vec3 scale;
+    };
+
+    static_assert(sizeof(SSBOInstanceTransform) == 10 * sizeof(float));
+
+    // model and normal matrices per bindless system instance, computed from
+    // `SSBOInstanceTransform` on the GPU every frame. Lives on the
+    // `instanceMatrixArray` buffer.
+    struct SSBOInstanceMatrices
+    {
+        glm::mat4 model;
+        glm::vec4 normal[3]; // mat3, with 16-byte aligned columns
+    };
+
+    static_assert(
+        sizeof(SSBOInstanceMatrices) % SSBO_INSTANCE_DATA_ALIGNMENT == 0
+    );
+
+    // cluster of up to `MeshCache::MESHLET_MAX_TRIANGLES` triangles of a
+    // mesh, with its bounds to cull it by. Lives on `_meshletBuffer`, uploaded
+    // from the cooked mesh's `MeshCache::Meshlet`s as they are.
+    struct SSBOMeshlet
+    {
+        glm::vec4 boundingSphere; // object space, center in xyz, radius in w
+        glm::vec4 cone; // object space axis in xyz, cutoff in w
+        uint32_t firstIndex; // from the first index of the mesh's LOD 0
+        uint32_t indexCount;
+        uint32_t padding[2];
+    };
+
+    static_assert(sizeof(SSBOMeshlet) % SSBO_INSTANCE_DATA_ALIGNMENT == 0);
+    static_assert(sizeof(SSBOMeshlet) == sizeof(MeshCache::Meshlet));
+    static_assert(
+        offsetof(SSBOMeshlet, firstIndex)
+        == offsetof(MeshCache::Meshlet, firstIndex)
+    );
+
+    // meshlets of the mesh a draw command draws, in `_meshletBuffer`. Lives
+    // on the `drawMeshletArray` buffer, alongside `drawCommandArray`.
+    struct SSBOMeshletRange
+    {
+        uint32_t firstMeshlet;
+        uint32_t meshletCount; // 0 for meshes drawn whole
+    };
+
     // note that we don't create NUM_FRAME_IN_FLIGHT vertex/index
     // buffers assuming synchronization is trivial
     // TODO: add synchronization protection to them.
 
     /* ---------- Bindless Device Resources ---------- */
+    // Initial capacities of the buffers below. All of them grow
+    // geometrically, by `BUFFER_GROWTH_FACTOR`, once what is written to them
+    // no longer fits: see `reserveBuffer()`.
+    static const unsigned int INITIAL_INSTANCE_CAPACITY = 64;
+    static const unsigned int INITIAL_INSTANCE_INDEX_CAPACITY = 256;
+    // smallest range of `instanceIndexArray` a render batch gets
+    static const unsigned int INSTANCE_INDEX_BLOCK_SIZE = 16;
+    static const unsigned int INITIAL_DRAW_COMMAND_CAPACITY = 16;
+    // max # of levels of detail of a mesh, including the mesh itself. Each
+    // level has about half the triangles of the one before.
+    static const unsigned int MAX_MESH_LODS = MeshCache::MAX_LODS;
+    static const VkDeviceSize INITIAL_MESH_BUFFER_SIZE = 1 << 20; // 1 MiB
+    static const VkDeviceSize INITIAL_MESHLET_BUFFER_SIZE = 1 << 16; // 64 KiB
+    static const unsigned int BUFFER_GROWTH_FACTOR = 2;
+    static const VkDeviceSize INITIAL_STAGING_BUFFER_SIZE = 1 << 16; // 64 KiB
+
+    // Meshes of at least `MeshCache::MESHLET_MIN_TRIANGLES` triangles are
+    // split into meshlets, whose instances are culled per meshlet when drawn
+    // at LOD 0 -- when they're large on screen. Up to
+    // `MAX_CLUSTERED_INSTANCES` of them per cull phase, the others are drawn
+    // whole.
+    static const unsigned int MAX_CLUSTERED_INSTANCES = 256;
+    // Whether the pipeline culls back faces. Meshlets facing away from the
+    // camera are only culled then, so that instances drawn whole and per
+    // meshlet show the same triangles; meshes are drawn two-sided otherwise.
+    static const bool CULL_BACK_FACES = false;
+
+    // the buffers written by the host are copied into from the staging
+    // buffers, unless they're host-visible
+    // shared by `instanceDataArray` and `instanceTransformArray`
+    static const VkBufferUsageFlags INSTANCE_DATA_USAGE
+        = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    static const VkBufferUsageFlags DRAW_COMMAND_USAGE
+        = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    // memory of the buffers written by the host: device-local, and
+    // host-visible as well on devices with resizable BAR
+    VkMemoryPropertyFlags _uploadMemoryProperties
+        = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+    // the mesh buffers are written by transfers, and copied from as they
+    // grow or get defragmented
+    static const VkBufferUsageFlags VERTEX_BUFFER_USAGE
+        = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+          | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+    static const VkBufferUsageFlags INDEX_BUFFER_USAGE
+        = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+          | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+    static const VkBufferUsageFlags MESHLET_BUFFER_USAGE
+        = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+          | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+
     // all index buffers
     VQBuffer _indexBuffers;
     unsigned int _indexBuffersWriteOffset = 0;
     // all vertex buffers
     VQBuffer _vertexBuffers;
     unsigned int _vertexBuffersWriteOffset = 0;
+    // all meshlets
+    VQBuffer _meshletBuffer; // <SSBOMeshlet>
+    unsigned int _meshletBufferWriteOffset = 0;
+    // most meshlets of a loaded mesh
+    unsigned int _maxMeshletCount = 0;
 
     // buffer arrays
     struct BindlessBuffer
     {
         // huge array containing `BindlessInstanceData`
         VQBuffer instanceDataArray; // <BindlessInstanceData>
+        VQBuffer instanceTransformArray; // <SSBOInstanceTransform>
+        // only ever written by the GPU
+        VQBuffer instanceMatrixArray; // <SSBOInstanceMatrices>
         // SSBO the maps (offseted) instance IDs to actual instance datas
         VQBuffer instanceIndexArray; // <InstanceIndexArrayIndexType>
         // list of draw commands
         VQBuffer
             drawCommandArray; // <VkDrawIndexedIndirectCommand>
                               // indexCount -- how many index to draw
-                              // instanceCount
+                              // instanceCount -- counted up by the cull
+                              // shader, zeroed by the compact shader
                               // firstIndex -- which index to start from in
                               // `indexBuffers` firstInstance -- which index to
                               // start from in `instanceLookupArray`
+        // meshlets of each draw command's mesh
+        VQBuffer drawMeshletArray; // <SSBOMeshletRange>
+        // the draw commands that are drawn: those with visible instances
+        // first, then the culled ones
+        VQBuffer compactedDrawCommandArray; // <VkDrawIndexedIndirectCommand>
+        // `compactedDrawCommandArray` of the late pass
+        VQBuffer lateDrawCommandArray; // <VkDrawIndexedIndirectCommand>
+        // # of draw commands with, and without visible instances, in
+        // `compactedDrawCommandArray` then in `lateDrawCommandArray`
+        VQBuffer drawCount; // <uint32_t[4]>
+        // # of instances each draw command drew in the early pass
+        VQBuffer earlyInstanceCounts; // <uint32_t>
+        // draws of the visible meshlets of the early phase, then of the late
+        // phase, `CullPushConstants::meshletDrawCapacity` each
+        VQBuffer meshletDrawCommandArray; // <VkDrawIndexedIndirectCommand>
+        // per cull phase: the dispatch of the meshlet cull shader over the
+        // clustered instances, and the # of meshlet draws
+        VQBuffer meshletCounts; // <VkDispatchIndirectCommand, uint32_t>[2]
+        // host-visible, read back NUM_FRAME_IN_FLIGHT frames later
+        VQBuffer cullStats; // <CullStats>
+        // host-visible, the frame's uploads to the instance arrays and
+        // `drawCommandArray`, overwritten by the next `PrepareFrame()` of the
+        // frame
+        VQBuffer stagingBuffer;
     };
 
     std::array<BindlessBuffer, NUM_FRAME_IN_FLIGHT> _bindlessBuffers;
 
-    // offset to `instanceIndexArray`, to which we can append a new
-    // `SSBOInstanceIndex` a.k.a. unsigned int
-    unsigned int _instanceIndexArrayOffset = 0;
-    // offset to `drawCommandArray`, to which we can append a new
-    // `VkDrawIndexedIndirectCommand`
-    unsigned int _drawCommandArrayOffset = 0;
-    // offset to `instanceDataArray` to which we can append a new
-    // `SSBOInstanceData`
-    unsigned int _instanceDataArrayOffset = 0;
+    // whether each instance passed the late pass of the last frame in bit 0,
+    // and the LOD it was last drawn at in the bits above, shared by all
+    // frames in flight as each frame reads what the previous one wrote
+    VQBuffer _instanceVisibility; // <uint32_t>
+    bool _instanceVisibilityCleared = false;
+
+    // ranges of `instanceIndexArray` of the render batches, in
+    // `SSBOInstanceIndex`s
+    BuddyAllocator _instanceIndexAllocator{INSTANCE_INDEX_BLOCK_SIZE};
+
+    // backing storage of the components made by `MakeComponents()`
+    std::vector<std::unique_ptr<BindlessRenderSystemComponent[]>>
+        _componentPools;
+
+    // CPU copy of `drawCommandArray`, with all instance counts at 0 as those
+    // are counted up by the GPU. Uploaded to a frame's buffer by its
+    // `PrepareFrame()` whenever it changed.
+    std::vector<VkDrawIndexedIndirectCommand> _drawCommands;
+    // CPU copy of `drawMeshletArray`, uploaded along with `_drawCommands`
+    std::vector<SSBOMeshletRange> _drawMeshlets;
+    std::array<bool, NUM_FRAME_IN_FLIGHT> _drawCommandsDirty{};
+
+    // buffers replaced by bigger or defragmented ones, destroyed after
+    // `framesLeft` more `PrepareFrame()`s, when no frame in flight can still
+    // read them, and once the upload batch of `ticket` has completed
+    struct RetiredBuffer
+    {
+        VQBuffer buffer;
+        int framesLeft;
+        VQUploadManager::Ticket ticket;
+    };
+
+    std::vector<RetiredBuffer> _retiredBuffers;
+    // whether a frame's descriptor sets still point to a replaced buffer
+    std::array<bool, NUM_FRAME_IN_FLIGHT> _bufferDescriptorsDirty{};
 
     /* ---------- Internal Data Structures ----------- */
     struct RenderBatch
     {
+        // size of the batch's range of `instanceIndexArray`, a block of
+        // `_instanceIndexAllocator`, 0 without one. Split evenly between the
+        // LODs, as every instance may be drawn at any of them.
         unsigned int maxSize;
         unsigned int instanceCount;
+        // of the first of `MAX_MESH_LODS` draw commands, one per LOD; those
+        // past `lodCount` draw nothing
         unsigned int drawCmdOffset;
-        // each render batch has its own draw command, that stores
-        // additional render batch infos
+        unsigned int lodCount;
+    };
+
+    // each model has a single batch, drawn by a draw command per LOD. Its
+    // range of `instanceIndexArray` is re-allocated as the instance count
+    // outgrows it, or drops to a quarter of it. As the range is rewritten by
+    // every frame's culling, moving it costs nothing but updating the draw
+    // commands.
+    std::unordered_map<std::string, RenderBatch> _modelBatches;
+    // first of the `MAX_MESH_LODS` draw commands of unloaded meshes, reused
+    // by the next batch
+    std::vector<unsigned int> _freeDrawCommands;
+
+    // Instances are addressed by handles to slots rather than by their
+    // offsets, so that they can be moved around to keep `instanceDataArray`
+    // dense.
+    struct InstanceSlot
+    {
+        uint32_t generation = 0; // bumped when the instance is destroyed
+        uint32_t dataIndex = 0;  // into `instanceDataArray`
+        // nullptr once destroyed
+        BindlessRenderSystemComponent* component = nullptr;
+        // the render batch the instance is in, in `_modelBatches`
+        RenderBatch* batch = nullptr;
     };
 
-    // each model can have multiple batches, with each batch being able to
-    // render more instances than the previous one. This avoids fragmentation
-    // and reduces model resizing cost. Note this does create a manageable
-    // amount of additional draw calls for large instance count, but if we scale
-    // up batch size geometrically the draw call cost can be treated as O(1).
-    std::unordered_map<std::string, std::vector<RenderBatch>> _modelBatches;
+    std::vector<InstanceSlot> _instanceSlots;
+    std::vector<uint32_t> _freeInstanceSlots;
+    // slot of each instance in `instanceDataArray`, including destroyed ones
+    // that are yet to be reclaimed
+    std::vector<uint32_t> _instanceDataSlots;
+
+    // slots of destroyed instances, in the order they were destroyed. Each
+    // is reclaimed NUM_FRAME_IN_FLIGHT frames after `frame`, once every
+    // frame's `instanceDataArray` has it marked as destroyed.
+    struct DestroyedInstance
+    {
+        uint32_t slot;
+        uint64_t frame;
+    };
+
+    std::deque<DestroyedInstance> _destroyedInstances;
+    // # of `PrepareFrame()`s so far
+    uint64_t _frameCount = 0;
+    // max # of instances reclaimed per frame, keeping spikes of destruction
+    // from stalling a single frame
+    static const unsigned int INSTANCE_RECLAIM_BUDGET = 4096;
+    // `SSBOInstanceData::drawCmdIndex` of destroyed instances
+    static const uint32_t DRAW_CMD_NONE = 0xFFFFFFFF;
+
+    // guards the instance bookkeeping and the update queues
+    std::mutex _instanceMutex;
 
     DeletionStack _deletionStack;
 
-    // list of functions that updates each frame in flight
-    std::array<std::vector<std::function<void()>>, NUM_FRAME_IN_FLIGHT>
-        _updateQueue;
+    // Every CPU write to a per-frame device resource (`_bindlessBuffers[i]`
+    // and the descriptor sets) goes through `_dirtyInstances[i]`,
+    // `_drawCommandsDirty[i]` or `_bufferDescriptorsDirty[i]`, which are only
+    // flushed in `PrepareFrame()` of frame i -- by then the engine has waited
+    // on frame i's fence, so the GPU is guaranteed not to be reading the
+    // buffers while they're written. The exception is
+    // `_textureDescriptorSet`, shared by all frames and written as textures
+    // load, see `writeTextureDescriptor()`.
+
+    // CPU copy of `instanceDataArray`, including destroyed instances that
+    // are yet to be reclaimed
+    std::vector<SSBOInstanceData> _instanceData;
+    // CPU copy of `instanceTransformArray`, along with `_instanceData`
+    std::vector<SSBOInstanceTransform> _instanceTransforms;
+    // a bit per instance in `_instanceData` that is yet to be uploaded to
+    // each frame in flight, sized along with `_instanceData`
+    std::array<std::vector<uint64_t>, NUM_FRAME_IN_FLIGHT> _dirtyInstances;
+    // `_dirtyInstances` of `_instanceTransforms`, which change much more
+    // often than the rest of the instance data
+    std::array<std::vector<uint64_t>, NUM_FRAME_IN_FLIGHT> _dirtyTransforms;
+    // scratch space of `uploadFrameData()`: the [begin, end) ranges of dirty
+    // instances and transforms, and their copies out of the staging buffer
+    std::vector<std::pair<uint32_t, uint32_t>> _uploadRanges;
+    std::vector<std::pair<uint32_t, uint32_t>> _transformUploadRanges;
+    std::vector<VkBufferCopy> _uploadRegions;
 
     // representation of a mesh loaded into `_vertexBuffers` and `_indexBuffers`
     // different draw commands may hold the same mesh buffer as instances are
@@ -194,28 +567,106 @@ class BindlessRenderSystem : public IRenderSystem
         unsigned long vertexEndOffset;
         unsigned long indexBeginOffset;
         unsigned long indexEndOffset;
-        unsigned long numIndices;
+        // meshlets of LOD 0, none for small meshes
+        unsigned long meshletBeginOffset;
+        unsigned long meshletEndOffset;
+        glm::vec4 boundingSphere; // center in xyz, radius in w
+
+        // indices of a level of detail, all of which index the same vertices
+        struct MeshLod
+        {
+            unsigned int firstIndex; // from `indexBeginOffset`
+            unsigned int numIndices;
+        };
+
+        std::array<MeshLod, MAX_MESH_LODS> lods; // the mesh itself first
+        unsigned int numLods;
     };
 
     // <mesh name, loaded mesh buffer>
     std::unordered_map<std::string, MeshBufferOffsets> _meshBufferData;
 
     /* ---------- Private Methods ----------- */
-    // load up a mesh from meshPath into vertex and index buffer array.
-    // incrementing the buffer array indices
+    // slot of a valid handle
+    InstanceSlot& getInstanceSlot(BindlessInstanceHandle handle);
+    // reclaim the slots of destroyed instances that no frame in flight can
+    // read anymore, moving the last instances into their places. Their
+    // visibility is moved along on `CB`.
+    void reclaimInstances(VkCommandBuffer CB);
+    // flag the instance at `dataIndex`, including its transform, to be
+    // uploaded to every frame
+    void markInstanceDirty(uint32_t dataIndex);
+    // flag only the transform of the instance at `dataIndex`
+    void markTransformDirty(uint32_t dataIndex);
+    // upload the dirty instances and transforms, coalesced into contiguous
+    // ranges, and the draw commands if they changed, to the frame's buffers.
+    // Written directly if the buffers are host-visible, or else copied from
+    // the frame's staging buffer by transfers recorded into the frame's
+    // command buffer.
+    void uploadFrameData(const TickContext* ctx);
+
+    // index of the texture into the texture array, loading it if it's not
+    // yet
+    int getTextureIndex(const std::string& texturePath);
+
+    // load up a mesh from meshPath into vertex and index buffer array, along
+    // with its LODs. incrementing the buffer array indices
     MeshBufferOffsets loadMeshBuffer(const std::string& meshPath);
 
-    RenderBatch createRenderBatch(
-        const std::string& meshPath,
-        unsigned int batchSize
+    // a batch of `meshPath` without a range of `instanceIndexArray` yet
+    RenderBatch createRenderBatch(const std::string& meshPath);
+    // move the batch to a range of `instanceIndexArray` that fits
+    // `instanceCount` instances per LOD, if it doesn't or is 4x as large
+    void fitRenderBatch(RenderBatch& batch, unsigned int instanceCount);
+    // free the batch and buffer ranges of a mesh without instances
+    void unloadMesh(const std::string& meshPath);
+    // pack the loaded meshes to the front of `_vertexBuffers`,
+    // `_indexBuffers` and `_meshletBuffer`, pointing the draw commands to
+    // their new offsets
+    void defragmentMeshBuffers();
+
+    // Make `buffer` hold at least `requiredSize` bytes, re-creating it
+    // `BUFFER_GROWTH_FACTOR` times as large if it doesn't. If `preserve`, the
+    // contents are copied over: on the host if the buffer is mapped, by `CB`
+    // otherwise, or by the upload batch without `CB`. The old buffer
+    // is retired. Returns whether the buffer was re-created.
+    bool reserveBuffer(
+        VQBuffer& buffer,
+        VkDeviceSize requiredSize,
+        VkBufferUsageFlags usage,
+        VkMemoryPropertyFlags properties,
+        bool preserve,
+        VkCommandBuffer CB = VK_NULL_HANDLE
     );
+    void retireBuffer(const VQBuffer& buffer);
+    // grow the frame's buffers to the instances and draw commands to upload,
+    // and to what the frame's culling writes
+    void reserveFrameBuffers(const TickContext* ctx);
+    // `CullPushConstants::meshletDrawCapacity`
+    uint32_t getMeshletDrawCapacity() const;
+    // point the frame's descriptor sets to its current buffers
+    void updateBufferDescriptorSets(int frame);
     void createGraphicsPipeline(
         const VkRenderPass renderPass,
         const InitContext* initData
     );
-    // flush the `_textureDescriptorInfo` into device, updating the descriptor
+    // the shared texture set, its layout and pool
+    void createTextureDescriptorSet();
+    void createCullPipelines(const InitContext* initData);
+    // bind the depth pyramid's current view to the frame's cull descriptor
     // set
-    void updateTextureDescriptorSet(int frame);
+    void updateDepthPyramidDescriptorSet(int frame);
+    // compute every instance's matrices from its transform
+    void recordTransforms(const TickContext* ctx);
+    // cull the instances of `phase` and compact the draw commands
+    void recordCull(const TickContext* ctx, CullPhase phase);
+    void recordDraws(const TickContext* ctx, bool late);
+    // write the texture at `textureIndex` of the shared texture set. Other
+    // elements are left alone, and may be in use by the frames in flight.
+    void writeTextureDescriptor(
+        uint32_t textureIndex,
+        const VkDescriptorImageInfo& imageInfo
+    );
 
     // create resrouces required for bindless rendering. Including:
     // - huge SSBO to store all instance data
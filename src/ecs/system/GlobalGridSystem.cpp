@@ -1,5 +1,6 @@
 #include "GlobalGridSystem.h"
 #include "components/Camera.h"
+#include "components/GPUProfiler.h"
 #include "components/Profiler.h"
 #include "components/ShaderUtils.h"
 #include "components/VulkanUtils.h"
@@ -11,9 +12,9 @@
 void GlobalGridSystem::createGraphicsPipeline(const VkRenderPass renderPass, const InitContext* initData) {
     /////  ---------- descriptor ---------- /////
     VkDescriptorSetLayoutBinding uboStaticBinding{};
-    { // UBO static -- vertex
+    { // UBO static -- vertex, written to the frame allocator every tick
         uboStaticBinding.binding = (int)BindingLocation::UBO_STATIC;
-        uboStaticBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        uboStaticBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
         uboStaticBinding.descriptorCount = 1; // number of values in the array
         uboStaticBinding.stageFlags
             = VK_SHADER_STAGE_VERTEX_BIT; // only used in vertex shader
@@ -53,6 +54,8 @@ void GlobalGridSystem::createGraphicsPipeline(const VkRenderPass renderPass, con
         uint32_t numDescriptorPerType = 5;
         VkDescriptorPoolSize poolSizes[]
             = {{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                static_cast<uint32_t>(numDescriptorPerType)},
+               {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
                 static_cast<uint32_t>(numDescriptorPerType)}};
 
         VkDescriptorPoolCreateInfo poolInfo{};
@@ -98,45 +101,17 @@ void GlobalGridSystem::createGraphicsPipeline(const VkRenderPass renderPass, con
 
     /////  ---------- UBO ---------- /////
 
-    // allocate for static ubo, this only needs to be done once
-    for (auto& UBO : this->_UBO) {
-        _device->CreateBufferInPlace(
-            sizeof(GlobalGridSystem::UBOStatic),
-            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-                | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            UBO.buffer
-        );
-    }
-
     // update descriptor sets
-    // note here we only update descripto sets for static ubo
-    // dynamic ubo is updated through `resizeDynamicUbo`
-    // texture array is updated through `updateTextureDescriptorSet`
     for (size_t i = 0; i < NUM_FRAME_IN_FLIGHT; i++) {
-        VkDescriptorBufferInfo descriptorBufferInfo_static{};
-        descriptorBufferInfo_static.buffer = this->_UBO[i].buffer.buffer;
-        descriptorBufferInfo_static.offset = 0;
-        descriptorBufferInfo_static.range = sizeof(GlobalGridSystem::UBOStatic);
-
-        std::array<VkWriteDescriptorSet, 2> descriptorWrites{};
+        std::array<VkWriteDescriptorSet, 1> descriptorWrites{};
 
         descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
         descriptorWrites[0].dstSet = this->_descriptorSets[i];
-        descriptorWrites[0].dstBinding = (int)BindingLocation::UBO_STATIC;
+        descriptorWrites[0].dstBinding = (int)BindingLocation::UBO_STATIC_ENGINE;
         descriptorWrites[0].dstArrayElement = 0;
         descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         descriptorWrites[0].descriptorCount = 1;
-        descriptorWrites[0].pBufferInfo = &descriptorBufferInfo_static;
-
-
-        descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[1].dstSet = this->_descriptorSets[i];
-        descriptorWrites[1].dstBinding = (int)BindingLocation::UBO_STATIC_ENGINE;
-        descriptorWrites[1].dstArrayElement = 0;
-        descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        descriptorWrites[1].descriptorCount = 1;
-        descriptorWrites[1].pBufferInfo = &initData->engineUBOStaticDescriptorBufferInfo[i];
+        descriptorWrites[0].pBufferInfo = &initData->engineUBOStaticDescriptorBufferInfo[i];
 
         vkUpdateDescriptorSets(
             _device->logicalDevice,
@@ -145,6 +120,7 @@ void GlobalGridSystem::createGraphicsPipeline(const VkRenderPass renderPass, con
             0,
             nullptr
         );
+        updateStaticUBODescriptorSet(i);
     }
 
     /////  ---------- shader ---------- /////
@@ -381,36 +357,74 @@ void GlobalGridSystem::createGraphicsPipeline(const VkRenderPass renderPass, con
     vkDestroyShaderModule(_device->logicalDevice, vertShaderModule, nullptr);
 }
 
+void GlobalGridSystem::updateStaticUBODescriptorSet(int frame) {
+    // the static ubo points at the frame's frame allocator buffer, the offset
+    // of the tick's allocation is passed when binding
+    _staticUBOBuffers[frame] = _device->frameAllocator.GetBuffer(frame);
+
+    VkDescriptorBufferInfo descriptorBufferInfo_static{};
+    descriptorBufferInfo_static.buffer = _staticUBOBuffers[frame];
+    descriptorBufferInfo_static.offset = 0;
+    descriptorBufferInfo_static.range = sizeof(GlobalGridSystem::UBOStatic);
+
+    std::array<VkWriteDescriptorSet, 1> descriptorWrites{};
+    descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrites[0].dstSet = this->_descriptorSets[frame];
+    descriptorWrites[0].dstBinding = (int)BindingLocation::UBO_STATIC;
+    descriptorWrites[0].dstArrayElement = 0;
+    descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    descriptorWrites[0].descriptorCount = 1;
+    descriptorWrites[0].pBufferInfo = &descriptorBufferInfo_static;
+
+    vkUpdateDescriptorSets(
+        _device->logicalDevice,
+        descriptorWrites.size(),
+        descriptorWrites.data(),
+        0,
+        nullptr
+    );
+}
+
+void GlobalGridSystem::PrepareFrame(const TickContext* tickData) {
+    int frameIdx = tickData->graphics.currentFrameInFlight;
+    // the ubo `Tick()` pushes, the descriptor set follows the frame
+    // allocator's buffer if the reservation grew it
+    _device->frameAllocator.Reserve(frameIdx, sizeof(UBOStatic));
+    if (_staticUBOBuffers[frameIdx] != _device->frameAllocator.GetBuffer(frameIdx)) {
+        updateStaticUBODescriptorSet(frameIdx);
+    }
+}
+
 void GlobalGridSystem::Tick(const TickContext* tickData) {
-    PROFILE_SCOPE(tickData->profiler, "Global grid system tick");
     VkCommandBuffer CB = tickData->graphics.CB;
     VkFramebuffer FB = tickData->graphics.currentFB;
     VkExtent2D FBExt = tickData->graphics.currentFBextend;
     int frameIdx = tickData->graphics.currentFrameInFlight;
 
+    PROFILE_GPU_SCOPE(tickData->gpuProfiler, CB, "GlobalGrid");
     vkCmdBindPipeline(CB, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipeline);
-    vkCmdBindDescriptorSets(
-        CB,
-        VK_PIPELINE_BIND_POINT_GRAPHICS,
-        _pipelineLayout,
-        0,
-        1,
-        &_descriptorSets[tickData->graphics.currentFrameInFlight],
-        0,
-        0
-    );
 
     // update static ubo
     // TODO: observe that view and proj can be shared across different
     // pipelines. can we have just one static ubo for specifically view and
     // proj?
+    uint32_t uboOffset = 0;
     {
         UBOStatic ubo{
             glm::vec3(0.3, 0.3, 0.3)
         };
-        // TODO: a better ubo abstraction using templates?
-        memcpy(_UBO[frameIdx].buffer.bufferAddress, &ubo, sizeof(ubo));
+        uboOffset = _device->frameAllocator.Push(frameIdx, ubo).offset;
     }
+    vkCmdBindDescriptorSets(
+        CB,
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        _pipelineLayout,
+        0,
+        1,
+        &_descriptorSets[tickData->graphics.currentFrameInFlight],
+        1,
+        &uboOffset
+    );
 
     // draw the vertex grids
     VkDeviceSize offsets[] = {0};
@@ -464,10 +478,6 @@ void GlobalGridSystem::Init(const InitContext* initData) {
 
 void GlobalGridSystem::Cleanup() {
     DEBUG("cleaning up");
-    for (auto& ubo : _UBO) {
-        ubo.buffer.Cleanup();
-    }
-
     vkDestroyPipeline(_device->logicalDevice, _pipeline, nullptr);
     vkDestroyPipelineLayout(_device->logicalDevice, _pipelineLayout, nullptr);
 
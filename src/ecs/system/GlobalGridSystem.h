@@ -4,20 +4,18 @@
 
 // FIXME: this can be generalized into a "LineSystem" that draws line instances
 // a global coorindate grid similar to blender's background
-class GlobalGridSystem : public ISingletonSystem, IRenderSystem
+class GlobalGridSystem : public ISingletonSystem, public IRenderSystem
 {
   public:
     struct UBOStatic
     {
         glm::vec3 gridColor; // rgb
     };
-    struct UBOStaticDevice
-    {
-        VQBuffer buffer;
-    };
 
     virtual void Init(const InitContext* initData) override;
 
+    virtual void PrepareFrame(const TickContext* tickData) override;
+
     virtual void Tick(const TickContext* tickData) override;
 
     virtual void Cleanup() override;
@@ -26,6 +24,8 @@ class GlobalGridSystem : public ISingletonSystem, IRenderSystem
     const char* VERTEX_SHADER_SRC = "../shaders/global_grid.vert.spv";
     const char* FRAGMENT_SHADER_SRC = "../shaders/global_grid.frag.spv";
     void createGraphicsPipeline(const VkRenderPass renderPass, const InitContext* initData);
+    // point the static ubo descriptor of `frame` at the frame allocator's current buffer
+    void updateStaticUBODescriptorSet(int frame);
     enum class BindingLocation : unsigned int
     {
         UBO_STATIC_ENGINE= 0,
@@ -40,7 +40,8 @@ class GlobalGridSystem : public ISingletonSystem, IRenderSystem
     VkDescriptorPool _descriptorPool = VK_NULL_HANDLE;
 
     std::array<VkDescriptorSet, NUM_FRAME_IN_FLIGHT> _descriptorSets;
-    std::array<UBOStaticDevice, NUM_FRAME_IN_FLIGHT> _UBO;
+    // frame allocator buffer each frame's static ubo descriptor points at
+    std::array<VkBuffer, NUM_FRAME_IN_FLIGHT> _staticUBOBuffers{};
 
     VQDevice* _device;
 
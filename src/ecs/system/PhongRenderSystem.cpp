@@ -13,8 +13,6 @@
 void PhongRenderSystem::Init(const InitContext* initData) {
     _device = initData->device;
     _textureManager = initData->textureManager;
-    _dynamicUBOAlignmentSize
-        = _device->GetDynamicUBOAlignedSize(sizeof(PhongUBODynamic));
     // create the phong render pass
     // create graphics pipeline
     this->createGraphicsPipeline(initData->renderPass.mainPass, initData);
@@ -30,12 +28,6 @@ void PhongRenderSystem::Cleanup() {
         mesh.second.vertexBuffer.Cleanup();
     }
 
-    // clean up static UBO & dynamic UBO
-    for (UBO& ubo : _UBO) {
-        //ubo.staticUBO.Cleanup();
-        ubo.dynamicUBO.Cleanup();
-    }
-
     // clean up pipeline
     vkDestroyPipeline(_device->logicalDevice, _pipeline, nullptr);
     vkDestroyPipelineLayout(_device->logicalDevice, _pipelineLayout, nullptr);
@@ -51,6 +43,19 @@ void PhongRenderSystem::Cleanup() {
     // note: texture is handled by TextureManager so no need to clean that up
 }
 
+void PhongRenderSystem::PrepareFrame(const TickContext* tickData) {
+    int frameIdx = tickData->graphics.currentFrameInFlight;
+    // `Tick()` pushes a dynamic UBO per entity; reserving them may grow the
+    // frame allocator's buffer, which the descriptor set has to follow
+    _device->frameAllocator.Reserve(
+        frameIdx, sizeof(PhongUBODynamic), this->_entities.size()
+    );
+    if (_dynamicUBOBuffers[frameIdx]
+        != _device->frameAllocator.GetBuffer(frameIdx)) {
+        updateDynamicUBODescriptorSet(frameIdx);
+    }
+}
+
 void PhongRenderSystem::Tick(const TickContext* tickData) {
     VkCommandBuffer CB = tickData->graphics.CB;
     VkFramebuffer FB = tickData->graphics.currentFB;
@@ -79,8 +84,16 @@ void PhongRenderSystem::Tick(const TickContext* tickData) {
         ASSERT(transform != nullptr)
         // actual render logic
 
-        uint32_t dynamicUBOOffset
-            = meshInstance->dynamicUBOId * _dynamicUBOAlignmentSize;
+        uint32_t dynamicUBOOffset = 0;
+        { // write dynamic UBO
+            // instance data such as texture index and model mat, written
+            // every tick into the frame's transient memory
+            PhongUBODynamic dynamicUBO{
+                transform->GetModelMatrix(), meshInstance->textureOffset
+            };
+            dynamicUBOOffset
+                = _device->frameAllocator.Push(frameIdx, dynamicUBO).offset;
+        }
         { // bind descriptor set to the correct dynamic ubo
             // note that we use the same descriptor set for all phong meshes
             // need to rebind because offset to dynamic UBO is different
@@ -96,23 +109,6 @@ void PhongRenderSystem::Tick(const TickContext* tickData) {
             );
         }
 
-        { // update dynamic UBO
-            // TODO: may be a little expensive to do; given dynamic ubo only
-            // needs to be updated when relevant data structures of the instance
-            // changes
-            // memcpy here will stall the program
-            void* dynamicUBOAddr = reinterpret_cast<void*>(
-                reinterpret_cast<uintptr_t>(
-                    _UBO[frameIdx].dynamicUBO.bufferAddress
-                )
-                + dynamicUBOOffset
-            );
-            PhongUBODynamic dynamicUBO{
-                transform->GetModelMatrix(), meshInstance->textureOffset
-            };
-            memcpy(dynamicUBOAddr, &dynamicUBO, sizeof(PhongUBODynamic));
-        }
-
         { // bind vertex & index buffer
             VkDeviceSize offsets[] = {0};
             VkBuffer vertexBuffers[]
@@ -251,15 +247,10 @@ void PhongRenderSystem::createGraphicsPipeline(const VkRenderPass renderPass, co
     //     );
     // }
 
-    // allocate for dynamic ubo, and write to descriptors
-    resizeDynamicUbo(10);
-
     // update descriptor sets
-    // note here we only update descripto sets for static ubo
-    // dynamic ubo is updated through `resizeDynamicUbo`
+    // note here we only update descripto sets for static and dynamic ubo
     // texture array is updated through `updateTextureDescriptorSet`
     for (size_t i = 0; i < NUM_FRAME_IN_FLIGHT; i++) {
-
         std::array<VkWriteDescriptorSet, 1> descriptorWrites{};
         descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
         descriptorWrites[0].dstSet = this->_descriptorSets[i];
@@ -276,6 +267,7 @@ void PhongRenderSystem::createGraphicsPipeline(const VkRenderPass renderPass, co
             0,
             nullptr
         );
+        updateDynamicUBODescriptorSet(i);
     }
 
     /////  ---------- shader ---------- /////
@@ -529,7 +521,6 @@ PhongMeshComponent* PhongRenderSystem::MakePhongMeshComponent(
     const std::string& texturePath
 ) {
     PhongMesh* mesh = nullptr;
-    size_t dynamicUBOId = 0;
     int textureOffset = 0;
 
     { // load or create new mesh
@@ -567,27 +558,9 @@ PhongMeshComponent* PhongRenderSystem::MakePhongMeshComponent(
         }
     }
 
-    // reserve a dynamic UBO for this instance
-    // note each instance has to have a dynamic ubo, for storing instance data
-    // such as texture index and model mat
-    {
-        // have an available index that's been released, simply use that index.
-        if (!_freeDynamicUBOIdx.empty()) {
-            dynamicUBOId = _freeDynamicUBOIdx.back();
-            _freeDynamicUBOIdx.pop_back();
-        } else { // use a new index
-            dynamicUBOId = _currDynamicUBO;
-            _currDynamicUBO++;
-            if (_currDynamicUBO >= _numDynamicUBO) {
-                resizeDynamicUbo(_numDynamicUBO * 1.5); // grow dynamic UBO
-            }
-        }
-    }
-
     // return new component
     PhongMeshComponent* ret = new PhongMeshComponent();
     ret->mesh = mesh;
-    ret->dynamicUBOId = dynamicUBOId;
     ret->textureOffset = textureOffset;
     return ret;
 }
@@ -596,50 +569,37 @@ void PhongRenderSystem::DestroyPhongMeshComponent(PhongMeshComponent*& component
     // TODO: should we free up the mesh that lives in graphics memory?
     // TODO: sholud we free up the texture that lives in grahpics memory?
 
-    _freeDynamicUBOIdx.push_back(component->dynamicUBOId); // relinquish dynamic ubo
     delete component;
     component = nullptr;
 }
 
-// reallocate dynamic UBO array, updating the descriptors as well
-// note that contents from the old UBO array aren't copied over
-// TODO: implement copying over from the old array?
-void PhongRenderSystem::resizeDynamicUbo(size_t dynamicUboCount) {
-    for (int i = 0; i < NUM_FRAME_IN_FLIGHT; i++) {
-        // reallocate dyamic ubo
-        this->_UBO[i].dynamicUBO.Cleanup();
-        this->_device->CreateBufferInPlace(
-            _dynamicUBOAlignmentSize * dynamicUboCount,
-            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-                | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            this->_UBO[i].dynamicUBO
-        );
-        // point descriptor to newly allocated buffer
-        VkDescriptorBufferInfo descriptorBufferInfo_dynamic{};
-        descriptorBufferInfo_dynamic.buffer = this->_UBO[i].dynamicUBO.buffer;
-        descriptorBufferInfo_dynamic.offset = 0;
-        descriptorBufferInfo_dynamic.range = _dynamicUBOAlignmentSize;
-
-        std::array<VkWriteDescriptorSet, 1> descriptorWrites{};
-        descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[0].dstSet = this->_descriptorSets[i];
-        descriptorWrites[0].dstBinding = (int)BindingLocation::UBO_DYNAMIC;
-        descriptorWrites[0].dstArrayElement = 0;
-        descriptorWrites[0].descriptorType
-            = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-        descriptorWrites[0].descriptorCount = 1;
-        descriptorWrites[0].pBufferInfo = &descriptorBufferInfo_dynamic;
-
-        vkUpdateDescriptorSets(
-            _device->logicalDevice,
-            descriptorWrites.size(),
-            descriptorWrites.data(),
-            0,
-            nullptr
-        );
-    }
-    _numDynamicUBO = dynamicUboCount;
+void PhongRenderSystem::updateDynamicUBODescriptorSet(int frame) {
+    // the dynamic ubo points at the frame's frame allocator buffer, each
+    // instance's offset into it is passed when binding
+    _dynamicUBOBuffers[frame] = _device->frameAllocator.GetBuffer(frame);
+
+    VkDescriptorBufferInfo descriptorBufferInfo_dynamic{};
+    descriptorBufferInfo_dynamic.buffer = _dynamicUBOBuffers[frame];
+    descriptorBufferInfo_dynamic.offset = 0;
+    descriptorBufferInfo_dynamic.range = sizeof(PhongUBODynamic);
+
+    std::array<VkWriteDescriptorSet, 1> descriptorWrites{};
+    descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrites[0].dstSet = this->_descriptorSets[frame];
+    descriptorWrites[0].dstBinding = (int)BindingLocation::UBO_DYNAMIC;
+    descriptorWrites[0].dstArrayElement = 0;
+    descriptorWrites[0].descriptorType
+        = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    descriptorWrites[0].descriptorCount = 1;
+    descriptorWrites[0].pBufferInfo = &descriptorBufferInfo_dynamic;
+
+    vkUpdateDescriptorSets(
+        _device->logicalDevice,
+        descriptorWrites.size(),
+        descriptorWrites.data(),
+        0,
+        nullptr
+    );
 }
 
 void PhongRenderSystem::updateTextureDescriptorSet() {
@@ -48,6 +48,7 @@ class PhongRenderSystem : public IRenderSystem
     );
 
     virtual void Init(const InitContext* initData) override;
+    virtual void PrepareFrame(const TickContext* tickData) override;
     virtual void Tick(const TickContext* tickData) override;
 
     virtual void Cleanup() override;
@@ -65,26 +66,10 @@ class PhongRenderSystem : public IRenderSystem
     VkDescriptorSetLayout _descriptorSetLayout = VK_NULL_HANDLE;
     VkDescriptorPool _descriptorPool = VK_NULL_HANDLE;
 
-    struct UBO
-    {
-        VQBuffer staticUBO; // currently unused as we use engineUBO. may be
-                            // useful for sytem-scoped ubo
-        VQBuffer dynamicUBO;
-    };
-
-    size_t _numDynamicUBO;  // how many dynamic UBOs do we have
-    size_t _currDynamicUBO; // dynamic ubo that is to be allocated
-    std::vector<unsigned long>
-        _freeDynamicUBOIdx; // stores freed indices that are smaller than
-                            // _currDynamicUBO
-    size_t _dynamicUBOAlignmentSize; // actual size of the dynamic UBO that
-                                     // satisfies device alignment
-    // NOTE this design assumes that we never shrink PhongRenderSystem's dynamic
-    // UBO at runtime
-
     std::array<VkDescriptorSet, NUM_FRAME_IN_FLIGHT> _descriptorSets;
-    std::array<UBO, NUM_FRAME_IN_FLIGHT> _UBO;
-    void resizeDynamicUbo(size_t dynamicUboCount);
+
+    // frame allocator buffer each frame's dynamic ubo descriptor points at
+    std::array<VkBuffer, NUM_FRAME_IN_FLIGHT> _dynamicUBOBuffers{};
 
     VQDevice* _device = nullptr;
 
@@ -115,6 +100,10 @@ class PhongRenderSystem : public IRenderSystem
         _textureDescriptorIndices; // texture name, index into the texture
                                    // descriptor array
                                    //
+    // point the dynamic ubo descriptor of `frame` at the frame allocator's
+    // current buffer
+    void updateDynamicUBODescriptorSet(int frame);
+
     void updateTextureDescriptorSet(
     ); // flush the `_textureDescriptorInfo` into device, updating the
        // descriptor set
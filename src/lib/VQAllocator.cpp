@@ -0,0 +1,284 @@
+#include "VQAllocator.h"
+#include "VQUtils.h"
+#include <algorithm>
+
+float VQAllocator::HeapStats::GetFragmentation() const {
+    // dedicated allocations are used whole, so this is the blocks' free space
+    const VkDeviceSize freeBytes = allocatedBytes - usedBytes;
+    if (freeBytes == 0) {
+        return 0.f;
+    }
+    return 1.f - float(largestFreeRange) / float(freeBytes);
+}
+
+void VQAllocator::Init(VkPhysicalDevice physicalDevice, VkDevice device, bool bufferDeviceAddress) {
+    _physicalDevice = physicalDevice;
+    _device = device;
+    _bufferDeviceAddress = bufferDeviceAddress;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &_memoryProperties);
+}
+
+void VQAllocator::Cleanup() {
+    std::lock_guard<std::mutex> lock(_lock);
+    for (auto& pools : _pools) {
+        for (Pool& pool : pools) {
+            for (std::unique_ptr<Block>& block : pool.blocks) {
+                if (!block) {
+                    continue;
+                }
+                if (block->allocationCount > 0) {
+                    WARN("Freeing a memory block with {} allocations left in it", block->allocationCount);
+                }
+                if (block->mappedData) {
+                    vkUnmapMemory(_device, block->memory);
+                }
+                vkFreeMemory(_device, block->memory, nullptr);
+            }
+            pool.blocks.clear();
+        }
+    }
+    for (DedicatedStats& stats : _dedicatedStats) {
+        if (stats.count > 0) {
+            WARN("{} dedicated allocations were never freed", stats.count);
+        }
+        stats = {};
+    }
+}
+
+VQAllocation VQAllocator::AllocateForBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties) {
+    VkBufferMemoryRequirementsInfo2 requirementsInfo{VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2};
+    requirementsInfo.buffer = buffer;
+    VkMemoryDedicatedRequirements dedicatedRequirements{VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS};
+    VkMemoryRequirements2 requirements{VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2};
+    requirements.pNext = &dedicatedRequirements;
+    vkGetBufferMemoryRequirements2(_device, &requirementsInfo, &requirements);
+
+    VkMemoryDedicatedAllocateInfo dedicatedInfo{VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO};
+    dedicatedInfo.buffer = buffer;
+    VQAllocation allocation = allocate(
+        requirements.memoryRequirements, properties, true, dedicatedRequirements.prefersDedicatedAllocation, dedicatedInfo
+    );
+    vkBindBufferMemory(_device, buffer, allocation.memory, allocation.offset);
+    return allocation;
+}
+
+VQAllocation VQAllocator::AllocateForImage(VkImage image, VkImageTiling tiling, VkMemoryPropertyFlags properties) {
+    VkImageMemoryRequirementsInfo2 requirementsInfo{VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2};
+    requirementsInfo.image = image;
+    VkMemoryDedicatedRequirements dedicatedRequirements{VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS};
+    VkMemoryRequirements2 requirements{VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2};
+    requirements.pNext = &dedicatedRequirements;
+    vkGetImageMemoryRequirements2(_device, &requirementsInfo, &requirements);
+
+    VkMemoryDedicatedAllocateInfo dedicatedInfo{VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO};
+    dedicatedInfo.image = image;
+    VQAllocation allocation = allocate(
+        requirements.memoryRequirements,
+        properties,
+        tiling == VK_IMAGE_TILING_LINEAR,
+        dedicatedRequirements.prefersDedicatedAllocation,
+        dedicatedInfo
+    );
+    vkBindImageMemory(_device, image, allocation.memory, allocation.offset);
+    return allocation;
+}
+
+VQAllocation VQAllocator::allocate(
+    const VkMemoryRequirements& requirements,
+    VkMemoryPropertyFlags properties,
+    bool linear,
+    bool prefersDedicated,
+    const VkMemoryDedicatedAllocateInfo& dedicatedInfo
+) {
+    VQAllocation allocation{};
+    allocation.memoryTypeIndex = VQUtils::findMemoryType(_physicalDevice, requirements.memoryTypeBits, properties);
+    allocation.linear = linear;
+    const VkDeviceSize blockSize = getBlockSize(allocation.memoryTypeIndex);
+    // only buffers ask for device addresses
+    const bool deviceAddress = _bufferDeviceAddress && dedicatedInfo.buffer != VK_NULL_HANDLE;
+
+    if (prefersDedicated || requirements.size > blockSize / 2) {
+        allocation.memory = allocateMemory(
+            allocation.memoryTypeIndex, requirements.size, deviceAddress, &dedicatedInfo, &allocation.mappedData
+        );
+        allocation.size = requirements.size;
+        allocation.blockIndex = DEDICATED;
+        std::lock_guard<std::mutex> lock(_lock);
+        _dedicatedStats[allocation.memoryTypeIndex].bytes += allocation.size;
+        _dedicatedStats[allocation.memoryTypeIndex].count++;
+        return allocation;
+    }
+
+    // ranges are aligned to their power-of-two size, so a range of at least the alignment is aligned
+    const uint32_t units = static_cast<uint32_t>(
+        (std::max(requirements.size, requirements.alignment) + ALLOCATION_GRANULE - 1) / ALLOCATION_GRANULE
+    );
+    const uint32_t blockUnits = static_cast<uint32_t>(blockSize / ALLOCATION_GRANULE);
+
+    std::lock_guard<std::mutex> lock(_lock);
+    Pool& pool = _pools[allocation.memoryTypeIndex][linear];
+    auto allocateFromBlock = [&](uint32_t blockIndex) {
+        Block& block = *pool.blocks[blockIndex];
+        const uint32_t offset = block.ranges.Allocate(units);
+        if (block.ranges.GetCapacity() > blockUnits) {
+            // the buddy allocator grew past the end of the block
+            block.ranges.Free(offset, units);
+            return false;
+        }
+        const VkDeviceSize rangeSize = VkDeviceSize(block.ranges.GetBlockSize(units)) * ALLOCATION_GRANULE;
+        allocation.memory = block.memory;
+        allocation.offset = VkDeviceSize(offset) * ALLOCATION_GRANULE;
+        allocation.size = rangeSize;
+        if (block.mappedData) {
+            allocation.mappedData = static_cast<char*>(block.mappedData) + allocation.offset;
+        }
+        allocation.blockIndex = blockIndex;
+        block.usedBytes += rangeSize;
+        block.allocationCount++;
+        return true;
+    };
+
+    for (uint32_t i = 0; i < pool.blocks.size(); i++) {
+        if (pool.blocks[i] && allocateFromBlock(i)) {
+            return allocation;
+        }
+    }
+
+    // none fits, allocate a new block in the first free slot
+    uint32_t blockIndex = 0;
+    while (blockIndex < pool.blocks.size() && pool.blocks[blockIndex]) {
+        blockIndex++;
+    }
+    if (blockIndex == pool.blocks.size()) {
+        pool.blocks.emplace_back();
+    }
+    auto block = std::make_unique<Block>();
+    block->size = blockSize;
+    block->memory = allocateMemory(
+        allocation.memoryTypeIndex, blockSize, _bufferDeviceAddress && linear, nullptr, &block->mappedData
+    );
+    DEBUG("Allocated a {} byte block of memory type {}", blockSize, allocation.memoryTypeIndex);
+    pool.blocks[blockIndex] = std::move(block);
+    if (!allocateFromBlock(blockIndex)) {
+        FATAL("Failed to sub-allocate {} bytes from a new memory block!", requirements.size);
+    }
+    return allocation;
+}
+
+void VQAllocator::Free(VQAllocation& allocation) {
+    if (allocation.memory == VK_NULL_HANDLE) {
+        return;
+    }
+    if (allocation.blockIndex == DEDICATED) {
+        if (allocation.mappedData) {
+            vkUnmapMemory(_device, allocation.memory);
+        }
+        vkFreeMemory(_device, allocation.memory, nullptr);
+        std::lock_guard<std::mutex> lock(_lock);
+        _dedicatedStats[allocation.memoryTypeIndex].bytes -= allocation.size;
+        _dedicatedStats[allocation.memoryTypeIndex].count--;
+        allocation = {};
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_lock);
+    Pool& pool = _pools[allocation.memoryTypeIndex][allocation.linear];
+    std::unique_ptr<Block>& block = pool.blocks[allocation.blockIndex];
+    block->ranges.Free(allocation.offset / ALLOCATION_GRANULE, allocation.size / ALLOCATION_GRANULE);
+    block->usedBytes -= allocation.size;
+    block->allocationCount--;
+    allocation = {};
+
+    // give an empty block back, but keep the pool's last one around for the next allocation
+    if (block->allocationCount > 0) {
+        return;
+    }
+    const size_t numBlocks = std::count_if(pool.blocks.begin(), pool.blocks.end(), [](const auto& b) {
+        return b != nullptr;
+    });
+    if (numBlocks > 1) {
+        if (block->mappedData) {
+            vkUnmapMemory(_device, block->memory);
+        }
+        vkFreeMemory(_device, block->memory, nullptr);
+        block.reset();
+    }
+}
+
+std::vector<VQAllocator::HeapStats> VQAllocator::GetHeapStats() const {
+    std::vector<HeapStats> heaps(_memoryProperties.memoryHeapCount);
+    for (uint32_t i = 0; i < _memoryProperties.memoryHeapCount; i++) {
+        heaps[i].heapSize = _memoryProperties.memoryHeaps[i].size;
+        heaps[i].heapFlags = _memoryProperties.memoryHeaps[i].flags;
+    }
+
+    std::lock_guard<std::mutex> lock(_lock);
+    for (uint32_t type = 0; type < _memoryProperties.memoryTypeCount; type++) {
+        HeapStats& heap = heaps[_memoryProperties.memoryTypes[type].heapIndex];
+        for (const Pool& pool : _pools[type]) {
+            for (const std::unique_ptr<Block>& block : pool.blocks) {
+                if (!block) {
+                    continue;
+                }
+                heap.allocatedBytes += block->size;
+                heap.usedBytes += block->usedBytes;
+                heap.blockCount++;
+                heap.allocationCount += block->allocationCount;
+                // past the buddy allocator's capacity, the rest of the block is free in one piece
+                const VkDeviceSize blockUnits = block->size / ALLOCATION_GRANULE;
+                const VkDeviceSize largestFreeUnits = std::max<VkDeviceSize>(
+                    blockUnits - block->ranges.GetCapacity(), block->ranges.GetLargestFreeBlock()
+                );
+                heap.largestFreeRange = std::max(heap.largestFreeRange, largestFreeUnits * ALLOCATION_GRANULE);
+            }
+        }
+        heap.allocatedBytes += _dedicatedStats[type].bytes;
+        heap.usedBytes += _dedicatedStats[type].bytes;
+        heap.allocationCount += _dedicatedStats[type].count;
+        heap.dedicatedAllocationCount += _dedicatedStats[type].count;
+    }
+    return heaps;
+}
+
+VkDeviceMemory VQAllocator::allocateMemory(
+    uint32_t memoryTypeIndex,
+    VkDeviceSize size,
+    bool deviceAddress,
+    const VkMemoryDedicatedAllocateInfo* dedicatedInfo,
+    void** mappedData
+) {
+    VkMemoryAllocateInfo allocInfo{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = memoryTypeIndex;
+    allocInfo.pNext = dedicatedInfo;
+    VkMemoryAllocateFlagsInfo allocFlagsInfo{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO};
+    if (deviceAddress) {
+        allocFlagsInfo.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT;
+        allocFlagsInfo.pNext = allocInfo.pNext;
+        allocInfo.pNext = &allocFlagsInfo;
+    }
+
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    if (vkAllocateMemory(_device, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+        FATAL("Failed to allocate {} bytes of device memory!", size);
+    }
+    *mappedData = nullptr;
+    if (_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        VK_CHECK_RESULT(vkMapMemory(_device, memory, 0, VK_WHOLE_SIZE, 0, mappedData));
+    }
+    return memory;
+}
+
+VkDeviceSize VQAllocator::getBlockSize(uint32_t memoryTypeIndex) const {
+    const VkDeviceSize heapSize = _memoryProperties.memoryHeaps[_memoryProperties.memoryTypes[memoryTypeIndex].heapIndex]
+                                      .size;
+    if (heapSize >= 1024 * 1024 * 1024) {
+        return BLOCK_SIZE;
+    }
+    // the largest power of two up to an eighth of the heap
+    VkDeviceSize blockSize = ALLOCATION_GRANULE;
+    while (blockSize * 2 <= heapSize / 8) {
+        blockSize *= 2;
+    }
+    return blockSize;
+}
@@ -0,0 +1,149 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "components/BuddyAllocator.h"
+
+/**
+ * @brief A range of device memory handed out by VQAllocator, bound to a single buffer or image.
+ */
+struct VQAllocation
+{
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    /** @brief Size of the range reserved for the resource, at least its required size */
+    VkDeviceSize size = 0;
+    /** @brief Host pointer to the start of the range if the memory is host-visible, nullptr otherwise */
+    void* mappedData = nullptr;
+    uint32_t memoryTypeIndex = 0;
+    /** @brief Index of the block the range lies in, or VQAllocator::DEDICATED if it owns its memory */
+    uint32_t blockIndex = 0;
+    /** @brief Whether the resource is a buffer or linear image, which are kept apart from optimal images */
+    bool linear = true;
+};
+
+/**
+ * @brief Device memory allocator. Rather than a vkAllocateMemory per resource, it allocates large blocks per memory
+ * type and sub-allocates ranges of them with a buddy allocator, in units of ALLOCATION_GRANULE bytes.
+ *
+ * Buddy ranges are aligned to their power-of-two size, which covers any power-of-two alignment up to it. Buffers and
+ * linear images are kept in blocks apart from optimal images, so that the two never share a page of
+ * `bufferImageGranularity`. Resources of more than half a block, or that the driver asks to, get dedicated
+ * allocations of their own. Host-visible blocks are mapped once, for their whole lifetime.
+ */
+class VQAllocator
+{
+  public:
+    /** @brief `VQAllocation::blockIndex` of dedicated allocations */
+    static const uint32_t DEDICATED = UINT32_MAX;
+    /** @brief Unit of sub-allocation in bytes, the smallest range handed out */
+    static const VkDeviceSize ALLOCATION_GRANULE = 256;
+    /** @brief Size of a block, for heaps of at least 1 GiB. Smaller heaps get blocks of an eighth of their size. */
+    static const VkDeviceSize BLOCK_SIZE = 64 * 1024 * 1024;
+
+    /** @brief Usage and fragmentation of a memory heap */
+    struct HeapStats
+    {
+        VkDeviceSize heapSize = 0;
+        VkMemoryHeapFlags heapFlags = 0;
+        /** @brief Bytes of device memory allocated from the heap, blocks and dedicated allocations */
+        VkDeviceSize allocatedBytes = 0;
+        /** @brief Bytes of the allocated memory bound to resources */
+        VkDeviceSize usedBytes = 0;
+        /** @brief Largest free range of any block of the heap */
+        VkDeviceSize largestFreeRange = 0;
+        uint32_t blockCount = 0;
+        uint32_t allocationCount = 0;
+        uint32_t dedicatedAllocationCount = 0;
+
+        /**
+         * @brief How scattered the free space of the heap's blocks is, from 0 for a single free range to close to 1
+         * for many small ones
+         */
+        float GetFragmentation() const;
+    };
+
+    /**
+     * @brief Set the allocator up for `device`. Blocks are allocated with `VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT` if
+     * `bufferDeviceAddress` is enabled, for any buffer in them may ask for its address.
+     */
+    void Init(VkPhysicalDevice physicalDevice, VkDevice device, bool bufferDeviceAddress);
+    /**
+     * @brief Free all blocks. Every allocation must have been freed by then.
+     */
+    void Cleanup();
+
+    /**
+     * @brief Allocate memory of `properties` for `buffer`, and bind it.
+     */
+    VQAllocation AllocateForBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties);
+    /**
+     * @brief Allocate memory of `properties` for `image` of `tiling`, and bind it.
+     */
+    VQAllocation AllocateForImage(VkImage image, VkImageTiling tiling, VkMemoryPropertyFlags properties);
+    /**
+     * @brief Give back the memory of `allocation`, once the resource bound to it is destroyed. Resets `allocation`.
+     */
+    void Free(VQAllocation& allocation);
+
+    /**
+     * @brief Usage of each memory heap of the device, indexed as `VkPhysicalDeviceMemoryProperties::memoryHeaps`.
+     */
+    std::vector<HeapStats> GetHeapStats() const;
+
+  private:
+    struct Block
+    {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize size = 0;
+        void* mappedData = nullptr;
+        // in units of ALLOCATION_GRANULE
+        BuddyAllocator ranges{1};
+        VkDeviceSize usedBytes = 0;
+        uint32_t allocationCount = 0;
+    };
+    // the blocks of a memory type holding either linear or optimal resources; a freed block leaves a null entry, so
+    // that the indices of the others stay put
+    struct Pool
+    {
+        std::vector<std::unique_ptr<Block>> blocks;
+    };
+    struct DedicatedStats
+    {
+        VkDeviceSize bytes = 0;
+        uint32_t count = 0;
+    };
+
+    // `dedicatedInfo` names the resource, for if it gets a dedicated allocation
+    VQAllocation allocate(
+        const VkMemoryRequirements& requirements,
+        VkMemoryPropertyFlags properties,
+        bool linear,
+        bool prefersDedicated,
+        const VkMemoryDedicatedAllocateInfo& dedicatedInfo
+    );
+    // allocate `size` bytes of device memory of `memoryTypeIndex`, mapped if it's host-visible
+    VkDeviceMemory allocateMemory(
+        uint32_t memoryTypeIndex,
+        VkDeviceSize size,
+        bool deviceAddress,
+        const VkMemoryDedicatedAllocateInfo* dedicatedInfo,
+        void** mappedData
+    );
+    VkDeviceSize getBlockSize(uint32_t memoryTypeIndex) const;
+
+    VkPhysicalDevice _physicalDevice = VK_NULL_HANDLE;
+    VkDevice _device = VK_NULL_HANDLE;
+    VkPhysicalDeviceMemoryProperties _memoryProperties{};
+    bool _bufferDeviceAddress = false;
+
+    // guards everything below, resources are created from worker threads too
+    mutable std::mutex _lock;
+    // [memory type][linear]
+    std::array<std::array<Pool, 2>, VK_MAX_MEMORY_TYPES> _pools;
+    std::array<DedicatedStats, VK_MAX_MEMORY_TYPES> _dedicatedStats;
+};
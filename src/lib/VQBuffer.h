@@ -1,5 +1,6 @@
 #pragma once
 #include <structs/Vertex.h>
+#include "VQAllocator.h"
 #include <vulkan/vulkan.h>
 #include <vulkan/vulkan_core.h>
 
@@ -13,6 +14,11 @@ struct VQBuffer
     VkDeviceMemory bufferMemory = VK_NULL_HANDLE;
     VkDeviceSize size = 0;
     void* bufferAddress = nullptr;
+    /** @brief GPU address of the buffer, if it was created with `VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT` */
+    VkDeviceAddress deviceAddress = 0;
+    /** @brief Allocator `allocation` came from, or nullptr if `bufferMemory` is owned by the buffer */
+    VQAllocator* allocator = nullptr;
+    VQAllocation allocation;
 
     /**
      * @brief Clean up all the resources held by this buffer.
@@ -27,7 +33,9 @@ struct VQBuffer
         if (buffer) {
             vkDestroyBuffer(device, buffer, nullptr);
         }
-        if (bufferMemory) {
+        if (allocator) {
+            allocator->Free(allocation);
+        } else if (bufferMemory) {
             if (bufferAddress != nullptr) {
                 vkUnmapMemory(device, bufferMemory);
             }
@@ -0,0 +1,71 @@
+#include "VQCommandPools.h"
+#include "VQDevice.h"
+
+void VQCommandPools::Init(VQDevice* device, uint32_t numThreads) {
+    if (!device->queueFamilyIndices.graphicsFamily.has_value()) {
+        FATAL("Graphics queue family not initialized! Call InitQueueFamilyIndices().");
+    }
+    _device = device;
+    _pools.resize(numThreads);
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    // buffers are re-recorded every frame and only ever reset along with the pool
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    poolInfo.queueFamilyIndex = device->queueFamilyIndices.graphicsFamily.value();
+
+    for (auto& threadPools : _pools) {
+        for (Pool& pool : threadPools) {
+            if (vkCreateCommandPool(device->logicalDevice, &poolInfo, nullptr, &pool.pool) != VK_SUCCESS) {
+                FATAL("Failed to create secondary command pool!");
+            }
+        }
+    }
+}
+
+void VQCommandPools::Cleanup() {
+    for (auto& threadPools : _pools) {
+        for (Pool& pool : threadPools) {
+            if (pool.pool != VK_NULL_HANDLE) {
+                // destroying the pool frees all its buffers
+                vkDestroyCommandPool(_device->logicalDevice, pool.pool, nullptr);
+                pool.pool = VK_NULL_HANDLE;
+            }
+            pool.buffers.clear();
+            pool.numUsed = 0;
+        }
+    }
+    _pools.clear();
+}
+
+void VQCommandPools::Reset(int frame) {
+    for (auto& threadPools : _pools) {
+        Pool& pool = threadPools[frame];
+        if (pool.numUsed == 0) {
+            continue;
+        }
+        if (vkResetCommandPool(_device->logicalDevice, pool.pool, 0) != VK_SUCCESS) {
+            FATAL("Failed to reset secondary command pool!");
+        }
+        pool.numUsed = 0;
+    }
+}
+
+VkCommandBuffer VQCommandPools::GetSecondary(int frame, uint32_t thread) {
+    ASSERT(thread < _pools.size());
+    Pool& pool = _pools[thread][frame];
+    if (pool.numUsed == pool.buffers.size()) {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = pool.pool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandBufferCount = 1;
+
+        VkCommandBuffer buffer;
+        if (vkAllocateCommandBuffers(_device->logicalDevice, &allocInfo, &buffer) != VK_SUCCESS) {
+            FATAL("Failed to allocate secondary command buffer!");
+        }
+        pool.buffers.push_back(buffer);
+    }
+    return pool.buffers[pool.numUsed++];
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <array>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+
+struct VQDevice;
+
+/**
+ * @brief Per-thread, per-frame command pools that hand out secondary command buffers.
+ *
+ * A VkCommandPool must be externally synchronized, so every recording thread owns one pool for each frame in
+ * flight; threads never share a pool and can record concurrently without locking. A frame's pools are reset as a
+ * whole through Reset(), which recycles every buffer handed out for that frame.
+ */
+class VQCommandPools
+{
+  public:
+    /**
+     * @brief Create `numThreads` x NUM_FRAME_IN_FLIGHT transient command pools on the graphics queue family.
+     *
+     * @param device device whose graphics queue the secondaries are executed on
+     * @param numThreads number of threads that may record at the same time
+     */
+    void Init(VQDevice* device, uint32_t numThreads);
+
+    void Cleanup();
+
+    /**
+     * @brief Reset all pools of `frame`. Must be called after the frame's fence has been waited on, and before any
+     * thread records for the frame.
+     */
+    void Reset(int frame);
+
+    /**
+     * @brief Get a secondary command buffer in the initial state, allocated from `thread`'s pool of `frame`. The
+     * buffer stays valid until the next Reset() of `frame`.
+     *
+     * Only the thread owning slot `thread` may call this for that slot.
+     */
+    VkCommandBuffer GetSecondary(int frame, uint32_t thread);
+
+    uint32_t GetNumThreads() const { return static_cast<uint32_t>(_pools.size()); }
+
+  private:
+    struct Pool
+    {
+        VkCommandPool pool = VK_NULL_HANDLE;
+        std::vector<VkCommandBuffer> buffers; // allocated so far, recycled on Reset()
+        size_t numUsed = 0;                   // buffers handed out since the last Reset()
+    };
+
+    VQDevice* _device = nullptr;
+    std::vector<std::array<Pool, NUM_FRAME_IN_FLIGHT>> _pools; // [thread][frame]
+};
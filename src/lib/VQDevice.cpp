@@ -12,12 +12,26 @@ void VQDevice::CreateLogicalDeviceAndQueue(const std::vector<const char*>& exten
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
     std::set<uint32_t> uniqueQueueFamilyIndices;
     uniqueQueueFamilyIndices.insert(this->queueFamilyIndices.graphicsFamily.value());
-    uniqueQueueFamilyIndices.insert(this->queueFamilyIndices.presentationFamily.value());
+    if (this->queueFamilyIndices.presentationFamily.has_value()) {
+        uniqueQueueFamilyIndices.insert(this->queueFamilyIndices.presentationFamily.value());
+    }
+    uniqueQueueFamilyIndices.insert(this->queueFamilyIndices.computeFamily.value());
+    if (this->queueFamilyIndices.transferFamily.has_value()) {
+        uniqueQueueFamilyIndices.insert(this->queueFamilyIndices.transferFamily.value());
+    }
 
     DEBUG("Found {} unique queue families.", uniqueQueueFamilyIndices.size());
 
     VkPhysicalDeviceFeatures deviceFeatures{};
     deviceFeatures.multiDrawIndirect = true; // we enable multi-draw on everything -- 99% of desktop GPUs supports it
+    this->enabledFeatures = deviceFeatures;
+    // optional 1.2 features, enabled whenever supported; check `enabledFeatures12` before use
+    this->enabledFeatures12 = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES};
+    this->enabledFeatures12.drawIndirectCount = this->features12.drawIndirectCount;
+    this->enabledFeatures12.samplerFilterMinmax = this->features12.samplerFilterMinmax;
+    this->enabledFeatures12.descriptorBindingPartiallyBound = this->features12.descriptorBindingPartiallyBound;
+    this->enabledFeatures12.descriptorBindingSampledImageUpdateAfterBind = this->features12.descriptorBindingSampledImageUpdateAfterBind;
+    this->enabledFeatures12.bufferDeviceAddress = this->features12.bufferDeviceAddress;
     VkDeviceCreateInfo createInfo{};
     float queuePriority = 1.f;
     for (uint32_t queueFamily : uniqueQueueFamilyIndices) {
@@ -33,42 +47,66 @@ void VQDevice::CreateLogicalDeviceAndQueue(const std::vector<const char*>& exten
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     createInfo.pEnabledFeatures = &deviceFeatures;
+    createInfo.pNext = &this->enabledFeatures12;
     createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
     createInfo.ppEnabledExtensionNames = extensions.data(); // enable swapchain extension
     if (vkCreateDevice(this->physicalDevice, &createInfo, nullptr, &this->logicalDevice) != VK_SUCCESS) {
         FATAL("Failed to create logical device!");
     }
     vkGetDeviceQueue(this->logicalDevice, queueFamilyIndices.graphicsFamily.value(), 0, &this->graphicsQueue);
-    vkGetDeviceQueue(this->logicalDevice, queueFamilyIndices.presentationFamily.value(), 0, &this->presentationQueue);
+    if (queueFamilyIndices.presentationFamily.has_value()) {
+        vkGetDeviceQueue(this->logicalDevice, queueFamilyIndices.presentationFamily.value(), 0, &this->presentationQueue);
+    }
     vkGetDeviceQueue(this->logicalDevice, queueFamilyIndices.computeFamily.value(), 0, &this->computeQueue);
+    if (queueFamilyIndices.transferFamily.has_value()) {
+        vkGetDeviceQueue(this->logicalDevice, queueFamilyIndices.transferFamily.value(), 0, &this->transferQueue);
+    } else {
+        this->transferQueue = this->graphicsQueue;
+    }
+    this->allocator.Init(this->physicalDevice, this->logicalDevice, this->enabledFeatures12.bufferDeviceAddress);
+    this->frameAllocator.Init(this);
+    this->uploadManager.Init(this);
 }
 
 void VQDevice::InitQueueFamilyIndices(VkSurfaceKHR surface) {
     DEBUG("Finding graphics and presentation queue families...");
+    this->queueFamilyIndices.presentationRequired = surface != VK_NULL_HANDLE;
     uint32_t queueFamilyCount = 0;
     vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
     std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount); // initialize vector to store queue familieis
     vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
-    int i = 0;
-    for (const auto& queueFamily : queueFamilies) {
+    // every family is looked at: the dedicated compute and transfer families usually come after the graphics one
+    for (uint32_t i = 0; i < queueFamilyCount; i++) {
+        const VkQueueFlags flags = queueFamilies[i].queueFlags;
         VkBool32 presentationSupport = false;
-        if (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT) {
-            this->queueFamilyIndices.computeFamily = i;
-            DEBUG("Compute family found at {}", i);
-        }
-        if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+        if ((flags & VK_QUEUE_GRAPHICS_BIT) && !this->queueFamilyIndices.graphicsFamily.has_value()) {
             this->queueFamilyIndices.graphicsFamily = i;
             DEBUG("Graphics family found at {}", i);
         }
-        vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, surface, &presentationSupport);
-        if (presentationSupport) {
+        if ((flags & VK_QUEUE_COMPUTE_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT)
+            && !this->queueFamilyIndices.computeFamily.has_value()) {
+            this->queueFamilyIndices.computeFamily = i;
+            DEBUG("Async compute family found at {}", i);
+        }
+        if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))
+            && !this->queueFamilyIndices.transferFamily.has_value()) {
+            this->queueFamilyIndices.transferFamily = i;
+            DEBUG("Transfer family found at {}", i);
+        }
+        if (surface != VK_NULL_HANDLE) {
+            vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, surface, &presentationSupport);
+        }
+        // presenting from the graphics family spares an ownership transfer of the swapchain images
+        if (presentationSupport
+            && (!this->queueFamilyIndices.presentationFamily.has_value() || this->queueFamilyIndices.graphicsFamily == i)) {
             this->queueFamilyIndices.presentationFamily = i;
             DEBUG("Presentation family found at {}", i);
         }
-        if (this->queueFamilyIndices.isComplete()) {
-            break;
-        }
-        i++;
+    }
+    // graphics families support compute as well on any device that has a compute queue
+    if (!this->queueFamilyIndices.computeFamily.has_value() && this->queueFamilyIndices.graphicsFamily.has_value()
+        && (queueFamilies[this->queueFamilyIndices.graphicsFamily.value()].queueFlags & VK_QUEUE_COMPUTE_BIT)) {
+        this->queueFamilyIndices.computeFamily = this->queueFamilyIndices.graphicsFamily;
     }
 }
 
@@ -115,6 +153,9 @@ VQDevice::VQDevice(VkPhysicalDevice physicalDevice) {
     vkGetPhysicalDeviceProperties(physicalDevice, &properties);
     // Features should be checked by the examples before using them
     vkGetPhysicalDeviceFeatures(physicalDevice, &features);
+    VkPhysicalDeviceFeatures2 features2{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2};
+    features2.pNext = &features12;
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
     // Memory properties are used regularly for creating all kinds of buffers
     vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
     // Queue family properties, used for setting up requested queues upon device creation
@@ -157,24 +198,21 @@ void VQDevice::CreateBufferInPlace(
         FATAL("Failed to create VK buffer!");
     }
 
-    VkMemoryRequirements memRequirements;
-    vkGetBufferMemoryRequirements(this->logicalDevice, vqBuffer.buffer, &memRequirements);
+    // sub-allocated and bound by the allocator
+    vqBuffer.allocator = &this->allocator;
+    vqBuffer.allocation = this->allocator.AllocateForBuffer(vqBuffer.buffer, properties);
+    vqBuffer.bufferMemory = vqBuffer.allocation.memory;
 
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = VQUtils::findMemoryType(physicalDevice, memRequirements.memoryTypeBits, properties);
-
-    if (vkAllocateMemory(this->logicalDevice, &allocInfo, nullptr, &vqBuffer.bufferMemory) != VK_SUCCESS) {
-        FATAL("Failed to allocate device memory for buffer creation!");
+    if (usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) {
+        VkBufferDeviceAddressInfo addressInfo{VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO};
+        addressInfo.buffer = vqBuffer.buffer;
+        vqBuffer.deviceAddress = vkGetBufferDeviceAddress(this->logicalDevice, &addressInfo);
     }
 
-    vkBindBufferMemory(this->logicalDevice, vqBuffer.buffer, vqBuffer.bufferMemory, 0);
-
-    // only map to the memory pointer if the creation has HOST_VISIBLE_BIT,
-    // otherwise mapping wouldn't work anyways.
+    // only expose the memory pointer if the creation has HOST_VISIBLE_BIT; the allocator maps every host-visible
+    // block, but memory that merely happens to be host-visible may not be coherent
     if (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
-        VK_CHECK_RESULT(vkMapMemory(this->logicalDevice, vqBuffer.bufferMemory, 0, vqBuffer.size, 0, &vqBuffer.bufferAddress));
+        vqBuffer.bufferAddress = vqBuffer.allocation.mappedData;
     }
 }
 
@@ -195,6 +233,9 @@ void VQDevice::Cleanup() {
     if (graphicsCommandPool != VK_NULL_HANDLE) {
         vkDestroyCommandPool(logicalDevice, graphicsCommandPool, nullptr);
     }
+    uploadManager.Cleanup();
+    frameAllocator.Cleanup();
+    allocator.Cleanup();
     vkDestroyDevice(logicalDevice, nullptr);
 }
 
@@ -214,3 +255,15 @@ size_t VQDevice::GetDynamicUBOAlignedSize(size_t dynamicUBOSize) {
     }
     return dynamicAlignment;
 }
+
+bool VQDevice::HasLargeHostVisibleDeviceLocalMemory() const {
+    const VkMemoryPropertyFlags flags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    const VkDeviceSize legacyBarSize = 256 * 1024 * 1024;
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+        const VkMemoryType& type = memoryProperties.memoryTypes[i];
+        if ((type.propertyFlags & flags) == flags && memoryProperties.memoryHeaps[type.heapIndex].size > legacyBarSize) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -2,15 +2,26 @@
 #include "vulkan/vulkan.h"
 #include <optional>
 #include <vulkan/vulkan_core.h>
+#include "VQAllocator.h"
 #include "VQBuffer.h"
+#include "VQFrameAllocator.h"
+#include "VQUploadManager.h"
 
 struct QueueFamilyIndices
 {
     std::optional<uint32_t> graphicsFamily;
     std::optional<uint32_t> presentationFamily;
+    // a compute family without graphics, for async compute, where the device has one; the graphics family otherwise
     std::optional<uint32_t> computeFamily;
-
-    inline bool isComplete() { return graphicsFamily.has_value() && presentationFamily.has_value() && computeFamily.has_value(); }
+    // a family of transfer queues only, backed by the copy engines, where the device has one
+    std::optional<uint32_t> transferFamily;
+    // headless devices render offscreen and never present
+    bool presentationRequired = true;
+
+    inline bool isComplete() {
+        return graphicsFamily.has_value() && (presentationFamily.has_value() || !presentationRequired)
+               && computeFamily.has_value();
+    }
 };
 struct VQBuffer;
 
@@ -31,6 +42,10 @@ struct VQDevice
     VkPhysicalDeviceFeatures features;
     /** @brief Features that have been enabled for use on the physical device */
     VkPhysicalDeviceFeatures enabledFeatures;
+    /** @brief Vulkan 1.2 features of the physical device */
+    VkPhysicalDeviceVulkan12Features features12{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES};
+    /** @brief Vulkan 1.2 features that have been enabled for use on the physical device */
+    VkPhysicalDeviceVulkan12Features enabledFeatures12{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES};
     /** @brief Memory types and heaps of the physical device */
     VkPhysicalDeviceMemoryProperties memoryProperties;
     /** @brief Queue family properties of the physical device */
@@ -46,11 +61,23 @@ struct VQDevice
 
     VkQueue computeQueue = VK_NULL_HANDLE;
 
+    /** @brief Queue of the dedicated transfer family, or `graphicsQueue` on devices without one */
+    VkQueue transferQueue = VK_NULL_HANDLE;
+
     VkCommandPool graphicsCommandPool = VK_NULL_HANDLE;
 
     /** @brief Contains queue family indices */
     QueueFamilyIndices queueFamilyIndices;
 
+    /** @brief Sub-allocates the memory of the device's buffers and images, set up along with the logical device */
+    VQAllocator allocator;
+
+    /** @brief Transient per-frame memory for uniforms, indirect arguments and uploads, reset every frame */
+    VQFrameAllocator frameAllocator;
+
+    /** @brief Batches staging copies and other transfer work, submitted on the transfer queue before every frame */
+    VQUploadManager uploadManager;
+
     operator VkDevice() const { return logicalDevice; };
 
     explicit VQDevice(VkPhysicalDevice physicalDevice);
@@ -61,14 +88,30 @@ struct VQDevice
     size_t GetDynamicUBOAlignedSize(size_t dynamicUBOSize);
 
     /**
-     * @brief Query Vulkan API to find the queue family indices that support graphics and presentation.
+     * @brief Whether the host can map device-local memory beyond the legacy 256 MiB BAR window, i.e. resizable BAR
+     * on discrete GPUs, or the unified memory of integrated ones. Host writes to such memory reach VRAM directly,
+     * without staging buffers.
+     */
+    bool HasLargeHostVisibleDeviceLocalMemory() const;
+
+    /**
+     * @brief Whether `transferQueue` belongs to a family of its own, so that resources it writes must be released to
+     * the graphics family and acquired there before use.
+     */
+    bool HasDedicatedTransferQueue() const { return queueFamilyIndices.transferFamily.has_value(); }
+
+    /**
+     * @brief Query Vulkan API to find the queue family indices that support graphics and presentation, as well as
+     * the families of dedicated compute and transfer queues.
      *
-     * @param surface The surface on which the presentation queue will present to.
+     * @param surface The surface on which the presentation queue will present to. Pass VK_NULL_HANDLE for a
+     * headless device that has no presentation queue.
      */
     void InitQueueFamilyIndices(VkSurfaceKHR surface);
 
     /**
-     * @brief Create a Logical Device, and create a graphics queue and a presentation queue.
+     * @brief Create a Logical Device, and create a graphics queue, a presentation queue, a compute queue and a
+     * transfer queue.
      *
      * @param extensions the extensions to enable
      */
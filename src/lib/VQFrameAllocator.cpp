@@ -0,0 +1,82 @@
+#include "VQFrameAllocator.h"
+#include "VQDevice.h"
+#include <algorithm>
+
+void VQFrameAllocator::Init(VQDevice* device) {
+    _device = device;
+    const VkPhysicalDeviceLimits& limits = device->properties.limits;
+    _minAlignment = std::max(limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment);
+
+    _usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+                               | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    if (device->enabledFeatures12.bufferDeviceAddress) {
+        _usage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+    }
+    // written by the host every frame and read by the GPU once or twice: straight to VRAM if the host can map it
+    _properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    if (device->HasLargeHostVisibleDeviceLocalMemory()) {
+        _properties |= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    }
+    for (Frame& frame : _frames) {
+        device->CreateBufferInPlace(INITIAL_FRAME_SIZE, _usage, _properties, frame.buffer);
+        frame.head = 0;
+        frame.capacity = INITIAL_FRAME_SIZE;
+        frame.reserved = 0;
+    }
+}
+
+void VQFrameAllocator::Cleanup() {
+    for (Frame& frame : _frames) {
+        frame.buffer.Cleanup();
+        frame.buffer = {};
+    }
+}
+
+void VQFrameAllocator::Reset(int frame) {
+    _frames[frame].head.store(0, std::memory_order_relaxed);
+    _frames[frame].reserved = 0;
+}
+
+void VQFrameAllocator::Reserve(int frame, VkDeviceSize size, size_t count) {
+    Frame& f = _frames[frame];
+    // allocations are aligned to `_minAlignment` at least, so each one may take up to that many bytes more
+    f.reserved += count * ((size + _minAlignment - 1) & ~(_minAlignment - 1));
+    if (f.reserved <= f.capacity) {
+        return;
+    }
+    // the frame retired before Reset() and nothing was allocated from it since, so the buffer can go right away
+    ASSERT(f.head.load(std::memory_order_relaxed) == 0);
+    VkDeviceSize capacity = f.capacity;
+    while (capacity < f.reserved) {
+        capacity *= 2;
+    }
+    INFO("Growing frame {}'s allocator from {} to {} bytes", frame, f.capacity, capacity);
+    f.buffer.Cleanup();
+    f.buffer = {};
+    _device->CreateBufferInPlace(capacity, _usage, _properties, f.buffer);
+    f.capacity = capacity;
+}
+
+VQFrameAllocator::Allocation VQFrameAllocator::Allocate(int frame, VkDeviceSize size, VkDeviceSize alignment) {
+    Frame& f = _frames[frame];
+    alignment = std::max(alignment, _minAlignment);
+
+    VkDeviceSize head = f.head.load(std::memory_order_relaxed);
+    VkDeviceSize offset;
+    do {
+        offset = (head + alignment - 1) & ~(alignment - 1);
+        if (offset + size > f.capacity) {
+            PANIC("Frame allocator out of memory: {} bytes requested, {} of {} used", size, head, f.capacity);
+        }
+    } while (!f.head.compare_exchange_weak(head, offset + size, std::memory_order_relaxed));
+
+    Allocation allocation{};
+    allocation.buffer = f.buffer.buffer;
+    allocation.offset = offset;
+    allocation.size = size;
+    allocation.data = static_cast<char*>(f.buffer.bufferAddress) + offset;
+    if (f.buffer.deviceAddress != 0) {
+        allocation.deviceAddress = f.buffer.deviceAddress + offset;
+    }
+    return allocation;
+}
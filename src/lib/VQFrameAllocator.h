@@ -0,0 +1,101 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <vulkan/vulkan.h>
+
+#include "VQBuffer.h"
+
+struct VQDevice;
+
+/**
+ * @brief Per-frame linear allocator of transient GPU-visible memory, such as uniforms, indirect arguments or
+ * staging data that only has to live until the frame it was written for retires.
+ *
+ * Every frame in flight owns one persistently mapped buffer. Allocate() bumps an offset into the frame's buffer;
+ * Reset() rewinds it once the frame's fence has signaled, so nothing is ever freed on its own. Allocations are
+ * lock-free and may be made from any thread recording for the frame.
+ *
+ * A frame's buffer starts at INITIAL_FRAME_SIZE bytes and grows when Reserve() asks for more than it holds. Growing
+ * replaces the buffer, so a descriptor of type `*_DYNAMIC` written against GetBuffer() has to be rewritten whenever
+ * GetBuffer() changes; it reaches any allocation through its dynamic offset otherwise.
+ */
+class VQFrameAllocator
+{
+  public:
+    /** @brief Bytes of each frame's buffer before any Reserve() grows it */
+    static const VkDeviceSize INITIAL_FRAME_SIZE = 8 * 1024 * 1024;
+
+    /** @brief A range of a frame's buffer, valid until the frame's next Reset() */
+    struct Allocation
+    {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        /** @brief Offset into `buffer`, aligned for uniform and storage buffer descriptors */
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        /** @brief Host pointer to the range */
+        void* data = nullptr;
+        /** @brief GPU address of the range, if the device has buffer device addresses enabled */
+        VkDeviceAddress deviceAddress = 0;
+    };
+
+    /**
+     * @brief Create NUM_FRAME_IN_FLIGHT buffers of INITIAL_FRAME_SIZE bytes on `device`. They're placed in device-local
+     * memory if the host can map enough of it, and in host memory otherwise.
+     */
+    void Init(VQDevice* device);
+
+    void Cleanup();
+
+    /**
+     * @brief Hand the whole buffer of `frame` out again and drop its reservations. Must be called after the frame's
+     * fence has been waited on, and before any thread allocates for the frame.
+     */
+    void Reset(int frame);
+
+    /**
+     * @brief Make sure `frame`'s buffer holds `count` more allocations of `size` bytes, on top of what was reserved
+     * since the last Reset(), growing the buffer if it doesn't. Not thread safe, and must be called before the
+     * frame's first allocation, i.e. from a system's PrepareFrame().
+     */
+    void Reserve(int frame, VkDeviceSize size, size_t count = 1);
+
+    /**
+     * @brief Allocate `size` bytes for `frame`, aligned to the descriptor offset alignment and to `alignment`, a
+     * power of two. Panics if the frame's buffer is exhausted, which only happens to allocations that weren't
+     * reserved.
+     */
+    Allocation Allocate(int frame, VkDeviceSize size, VkDeviceSize alignment = 1);
+
+    /**
+     * @brief Allocate room for `data` in `frame`'s buffer, and copy it over.
+     */
+    template <typename T> Allocation Push(int frame, const T& data) {
+        Allocation allocation = Allocate(frame, sizeof(T));
+        memcpy(allocation.data, &data, sizeof(T));
+        return allocation;
+    }
+
+    /** @brief Buffer the allocations of `frame` come from, replaced when Reserve() grows it */
+    VkBuffer GetBuffer(int frame) const { return _frames[frame].buffer.buffer; }
+
+    /** @brief Bytes allocated for `frame` since its last Reset() */
+    VkDeviceSize GetUsedSize(int frame) const { return _frames[frame].head.load(std::memory_order_relaxed); }
+
+  private:
+    struct Frame
+    {
+        VQBuffer buffer;
+        std::atomic<VkDeviceSize> head = 0; // offset of the first free byte
+        VkDeviceSize capacity = 0;
+        VkDeviceSize reserved = 0; // bytes reserved since the last Reset()
+    };
+
+    VQDevice* _device = nullptr;
+    VkBufferUsageFlags _usage = 0;
+    VkMemoryPropertyFlags _properties = 0;
+
+    // alignment of every allocation, so that any of them can back a uniform or storage buffer descriptor
+    VkDeviceSize _minAlignment = 1;
+    std::array<Frame, NUM_FRAME_IN_FLIGHT> _frames;
+};
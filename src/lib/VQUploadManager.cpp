@@ -0,0 +1,435 @@
+#include "VQUploadManager.h"
+#include "VQDevice.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+VkCommandPool createCommandPool(VkDevice device, uint32_t queueFamilyIndex) {
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    // a batch's buffers are reset on their own once the batch completes
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex = queueFamilyIndex;
+    VkCommandPool pool = VK_NULL_HANDLE;
+    if (vkCreateCommandPool(device, &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+        FATAL("Failed to create upload command pool!");
+    }
+    return pool;
+}
+
+VkCommandBuffer allocateCommandBuffer(VkDevice device, VkCommandPool pool) {
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandPool = pool;
+    allocInfo.commandBufferCount = 1;
+    VkCommandBuffer CB = VK_NULL_HANDLE;
+    if (vkAllocateCommandBuffers(device, &allocInfo, &CB) != VK_SUCCESS) {
+        FATAL("Failed to allocate upload command buffer!");
+    }
+    return CB;
+}
+} // namespace
+
+void VQUploadManager::Init(VQDevice* device) {
+    _device = device;
+    _thread = std::this_thread::get_id();
+    _dedicatedTransfer = device->HasDedicatedTransferQueue();
+    _commandPool = createCommandPool(device->logicalDevice, device->queueFamilyIndices.graphicsFamily.value());
+    if (_dedicatedTransfer) {
+        _transferCommandPool = createCommandPool(device->logicalDevice, device->queueFamilyIndices.transferFamily.value());
+    }
+}
+
+void VQUploadManager::Cleanup() {
+    for (Batch& batch : _inFlight) {
+        vkWaitForFences(_device->logicalDevice, 1, &batch.fence, VK_TRUE, UINT64_MAX);
+        recycle(batch);
+    }
+    _inFlight.clear();
+    if (_isRecording) {
+        // the resources it recorded against may be gone already, so it's reset rather than ended
+        recycle(_recording);
+        _isRecording = false;
+    }
+    for (Batch& batch : _freeBatches) {
+        vkDestroyFence(_device->logicalDevice, batch.fence, nullptr);
+        if (batch.transferDone != VK_NULL_HANDLE) {
+            vkDestroySemaphore(_device->logicalDevice, batch.transferDone, nullptr);
+        }
+    }
+    _freeBatches.clear();
+    for (StagingChunk& chunk : _freeChunks) {
+        chunk.buffer.Cleanup();
+    }
+    _freeChunks.clear();
+    // destroying the pools frees all their buffers
+    if (_commandPool != VK_NULL_HANDLE) {
+        vkDestroyCommandPool(_device->logicalDevice, _commandPool, nullptr);
+        _commandPool = VK_NULL_HANDLE;
+    }
+    if (_transferCommandPool != VK_NULL_HANDLE) {
+        vkDestroyCommandPool(_device->logicalDevice, _transferCommandPool, nullptr);
+        _transferCommandPool = VK_NULL_HANDLE;
+    }
+}
+
+VQUploadManager::Staging VQUploadManager::allocateStaging(VkDeviceSize size, VkDeviceSize alignment) {
+    if (_isRecording && _recording.stagingSize + size > MAX_BATCH_STAGING_SIZE) {
+        Submit();
+    }
+    beginBatch();
+
+    StagingChunk* chunk = _recording.chunks.empty() ? nullptr : &_recording.chunks.back();
+    VkDeviceSize offset = chunk ? (chunk->head + alignment - 1) & ~(alignment - 1) : 0;
+    if (chunk == nullptr || offset + size > chunk->buffer.size) {
+        if (size <= STAGING_CHUNK_SIZE && !_freeChunks.empty()) {
+            _recording.chunks.push_back(std::move(_freeChunks.back()));
+            _freeChunks.pop_back();
+        } else {
+            StagingChunk newChunk{};
+            createStagingChunk(std::max(size, STAGING_CHUNK_SIZE), newChunk.buffer);
+            _recording.chunks.push_back(newChunk);
+        }
+        chunk = &_recording.chunks.back();
+        offset = 0;
+    }
+    chunk->head = offset + size;
+    _recording.stagingSize += size;
+
+    Staging staging{};
+    staging.buffer = chunk->buffer.buffer;
+    staging.offset = offset;
+    staging.data = static_cast<char*>(chunk->buffer.bufferAddress) + offset;
+    return staging;
+}
+
+void VQUploadManager::createStagingChunk(VkDeviceSize size, VQBuffer& buffer) {
+    buffer.device = _device->logicalDevice;
+    buffer.size = size;
+
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = size;
+    bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    // read by whichever queue a batch records its uploads on, see transferCommandBuffer()
+    const uint32_t queueFamilyIndices[]
+        = {_device->queueFamilyIndices.graphicsFamily.value(), _device->queueFamilyIndices.transferFamily.value_or(0)};
+    if (_dedicatedTransfer) {
+        bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        bufferInfo.queueFamilyIndexCount = 2;
+        bufferInfo.pQueueFamilyIndices = queueFamilyIndices;
+    }
+    if (vkCreateBuffer(_device->logicalDevice, &bufferInfo, nullptr, &buffer.buffer) != VK_SUCCESS) {
+        FATAL("Failed to create staging buffer!");
+    }
+
+    buffer.allocator = &_device->allocator;
+    buffer.allocation = _device->allocator.AllocateForBuffer(
+        buffer.buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+    );
+    buffer.bufferMemory = buffer.allocation.memory;
+    buffer.bufferAddress = buffer.allocation.mappedData;
+}
+
+void VQUploadManager::Upload(VkBuffer dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size) {
+    if (size == 0) {
+        return;
+    }
+    Staging staging = allocateStaging(size);
+    memcpy(staging.data, data, static_cast<size_t>(size));
+
+    VkCommandBuffer CB = transferCommandBuffer();
+    VkBufferCopy copy{};
+    copy.srcOffset = staging.offset;
+    copy.dstOffset = dstOffset;
+    copy.size = size;
+    vkCmdCopyBuffer(CB, staging.buffer, dst, 1, &copy);
+
+    if (CB == _recording.transferCB) {
+        VkBufferMemoryBarrier release{};
+        release.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        release.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        release.srcQueueFamilyIndex = _device->queueFamilyIndices.transferFamily.value();
+        release.dstQueueFamilyIndex = _device->queueFamilyIndices.graphicsFamily.value();
+        release.buffer = dst;
+        release.offset = dstOffset;
+        release.size = size;
+        _recording.bufferReleases.push_back(release);
+    }
+}
+
+void VQUploadManager::UploadImage(VkImage image, uint32_t width, uint32_t height, const void* data, VkDeviceSize size) {
+    Staging staging = allocateStaging(size);
+    memcpy(staging.data, data, static_cast<size_t>(size));
+
+    VkCommandBuffer CB = transferCommandBuffer();
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    vkCmdPipelineBarrier(
+        CB, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier
+    );
+
+    VkBufferImageCopy region{};
+    region.bufferOffset = staging.offset;
+    // in some cases the pixels aren't tightly packed, specify them.
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageOffset = {0, 0, 0};
+    region.imageExtent = {width, height, 1};
+    vkCmdCopyBufferToImage(CB, staging.buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    // transition for shader reads; on the transfer queue, the release half of the transition is recorded at submit
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    if (CB == _recording.transferCB) {
+        barrier.dstAccessMask = 0;
+        barrier.srcQueueFamilyIndex = _device->queueFamilyIndices.transferFamily.value();
+        barrier.dstQueueFamilyIndex = _device->queueFamilyIndices.graphicsFamily.value();
+        _recording.imageReleases.push_back(barrier);
+    } else {
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(
+            CB, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier
+        );
+    }
+}
+
+VkCommandBuffer VQUploadManager::GetCommandBuffer() {
+    beginBatch();
+    acquireReleases();
+    return _recording.CB;
+}
+
+void VQUploadManager::TransferBarrier() {
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(
+        GetCommandBuffer(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr
+    );
+}
+
+VQUploadManager::Ticket VQUploadManager::Submit() {
+    ASSERT(std::this_thread::get_id() == _thread);
+    if (!_isRecording) {
+        // everything recorded so far went out with the last batch
+        return _nextTicket - 1;
+    }
+    acquireReleases();
+    // the batch's writes are visible to whatever is submitted after it on the queue
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    vkCmdPipelineBarrier(
+        _recording.CB, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr
+    );
+    if (vkEndCommandBuffer(_recording.CB) != VK_SUCCESS) {
+        FATAL("Failed to record upload command buffer!");
+    }
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    if (_dedicatedTransfer) {
+        std::vector<VkBufferMemoryBarrier>& buffers = _recording.bufferReleases;
+        std::vector<VkImageMemoryBarrier>& images = _recording.imageReleases;
+        if (!buffers.empty() || !images.empty()) {
+            vkCmdPipelineBarrier(
+                _recording.transferCB,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                0,
+                0,
+                nullptr,
+                static_cast<uint32_t>(buffers.size()),
+                buffers.data(),
+                static_cast<uint32_t>(images.size()),
+                images.data()
+            );
+        }
+        if (vkEndCommandBuffer(_recording.transferCB) != VK_SUCCESS) {
+            FATAL("Failed to record upload command buffer!");
+        }
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &_recording.transferCB;
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &_recording.transferDone;
+        if (vkQueueSubmit(_device->transferQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+            FATAL("Failed to submit upload command buffer!");
+        }
+        // the graphics half may only acquire once the transfer half has released
+        submitInfo.waitSemaphoreCount = 1;
+        submitInfo.pWaitSemaphores = &_recording.transferDone;
+        submitInfo.pWaitDstStageMask = &waitStage;
+        submitInfo.signalSemaphoreCount = 0;
+        submitInfo.pSignalSemaphores = nullptr;
+    }
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &_recording.CB;
+    // the graphics half completes last, its fence covers the whole batch
+    if (vkQueueSubmit(_device->graphicsQueue, 1, &submitInfo, _recording.fence) != VK_SUCCESS) {
+        FATAL("Failed to submit upload command buffer!");
+    }
+
+    const Ticket ticket = _recording.ticket;
+    _inFlight.push_back(std::move(_recording));
+    _recording = {};
+    _isRecording = false;
+    _nextTicket++;
+    return ticket;
+}
+
+bool VQUploadManager::IsComplete(Ticket ticket) {
+    if (ticket == _nextTicket && !_isRecording) {
+        // nothing has been recorded for it yet, so it's down to the batches before
+        ticket--;
+    }
+    poll();
+    return ticket <= _completedTicket;
+}
+
+void VQUploadManager::Wait(Ticket ticket) {
+    if (ticket >= _nextTicket) {
+        Submit();
+    }
+    while (!_inFlight.empty() && _inFlight.front().ticket <= ticket) {
+        Batch& batch = _inFlight.front();
+        vkWaitForFences(_device->logicalDevice, 1, &batch.fence, VK_TRUE, UINT64_MAX);
+        _completedTicket = batch.ticket;
+        recycle(batch);
+        _inFlight.pop_front();
+    }
+}
+
+void VQUploadManager::beginBatch() {
+    // every upload, and every command recorded into a batch, goes through here
+    ASSERT(std::this_thread::get_id() == _thread);
+    if (_isRecording) {
+        return;
+    }
+    poll();
+    if (!_freeBatches.empty()) {
+        _recording = std::move(_freeBatches.back());
+        _freeBatches.pop_back();
+    } else {
+        _recording.CB = allocateCommandBuffer(_device->logicalDevice, _commandPool);
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        if (vkCreateFence(_device->logicalDevice, &fenceInfo, nullptr, &_recording.fence) != VK_SUCCESS) {
+            FATAL("Failed to create upload fence!");
+        }
+        if (_dedicatedTransfer) {
+            _recording.transferCB = allocateCommandBuffer(_device->logicalDevice, _transferCommandPool);
+            VkSemaphoreCreateInfo semaphoreInfo{};
+            semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+            if (vkCreateSemaphore(_device->logicalDevice, &semaphoreInfo, nullptr, &_recording.transferDone)
+                != VK_SUCCESS) {
+                FATAL("Failed to create upload semaphore!");
+            }
+        }
+    }
+    _recording.ticket = _nextTicket;
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    if (vkBeginCommandBuffer(_recording.CB, &beginInfo) != VK_SUCCESS) {
+        FATAL("Failed to begin upload command buffer!");
+    }
+    if (_dedicatedTransfer && vkBeginCommandBuffer(_recording.transferCB, &beginInfo) != VK_SUCCESS) {
+        FATAL("Failed to begin upload command buffer!");
+    }
+    _isRecording = true;
+}
+
+VkCommandBuffer VQUploadManager::transferCommandBuffer() {
+    beginBatch();
+    return _dedicatedTransfer && !_recording.acquired ? _recording.transferCB : _recording.CB;
+}
+
+void VQUploadManager::acquireReleases() {
+    if (_recording.acquired) {
+        return;
+    }
+    _recording.acquired = true;
+    if (_recording.bufferReleases.empty() && _recording.imageReleases.empty()) {
+        return;
+    }
+    // the same barriers, with the access masks of the acquiring side
+    std::vector<VkBufferMemoryBarrier> buffers = _recording.bufferReleases;
+    for (VkBufferMemoryBarrier& barrier : buffers) {
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    }
+    std::vector<VkImageMemoryBarrier> images = _recording.imageReleases;
+    for (VkImageMemoryBarrier& barrier : images) {
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    }
+    vkCmdPipelineBarrier(
+        _recording.CB,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+        0,
+        0,
+        nullptr,
+        static_cast<uint32_t>(buffers.size()),
+        buffers.data(),
+        static_cast<uint32_t>(images.size()),
+        images.data()
+    );
+}
+
+void VQUploadManager::poll() {
+    ASSERT(std::this_thread::get_id() == _thread);
+    while (!_inFlight.empty() && vkGetFenceStatus(_device->logicalDevice, _inFlight.front().fence) == VK_SUCCESS) {
+        _completedTicket = _inFlight.front().ticket;
+        recycle(_inFlight.front());
+        _inFlight.pop_front();
+    }
+}
+
+void VQUploadManager::recycle(Batch& batch) {
+    for (StagingChunk& chunk : batch.chunks) {
+        if (chunk.buffer.size == STAGING_CHUNK_SIZE) {
+            chunk.head = 0;
+            _freeChunks.push_back(chunk);
+        } else {
+            chunk.buffer.Cleanup();
+        }
+    }
+    batch.chunks.clear();
+    batch.stagingSize = 0;
+    batch.bufferReleases.clear();
+    batch.imageReleases.clear();
+    batch.acquired = false;
+    vkResetCommandBuffer(batch.CB, 0);
+    if (batch.transferCB != VK_NULL_HANDLE) {
+        vkResetCommandBuffer(batch.transferCB, 0);
+    }
+    vkResetFences(_device->logicalDevice, 1, &batch.fence);
+    _freeBatches.push_back(std::move(batch));
+}
@@ -0,0 +1,148 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <thread>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "VQBuffer.h"
+
+struct VQDevice;
+
+/**
+ * @brief Batches uploads to the GPU -- staging copies, image layout transitions and other transfer work -- into one
+ * command buffer per batch, instead of a submit and a queue drain for every copy.
+ *
+ * Commands are recorded into the batch being built until Submit(), which the engine calls before submitting each
+ * frame, so uploads made between two frames land before the later one draws. Every submitted batch is tracked by a
+ * fence and identified by a ticket: callers that need the data on the GPU right away can poll or wait on the ticket
+ * of their upload. Staging memory is carved linearly out of host-visible chunks, which are recycled once the batch
+ * that read them completes.
+ *
+ * On devices with a dedicated transfer queue, a batch is split in two. Staging copies run on the transfer queue,
+ * which releases the ranges and images it wrote to the graphics family; the graphics queue waits on a semaphore,
+ * acquires them, and runs the commands recorded through GetCommandBuffer(). Copies then overlap the rendering of the
+ * frames in flight instead of queueing up behind it.
+ *
+ * Not thread-safe: uploads are recorded and submitted from the thread that submits frames, the one that called Init();
+ * debug builds assert it. Anything that may upload -- loading meshes or textures, growing GPU buffers -- inherits the
+ * restriction.
+ */
+class VQUploadManager
+{
+  public:
+    /** @brief Identifies a batch; tickets grow monotonically, and batches complete in ticket order */
+    using Ticket = uint64_t;
+
+    /** @brief Size of a staging chunk. Larger uploads get a chunk of their own, freed rather than recycled. */
+    static const VkDeviceSize STAGING_CHUNK_SIZE = 16 * 1024 * 1024;
+    /** @brief Staging memory a batch may take up before it is submitted on its own */
+    static const VkDeviceSize MAX_BATCH_STAGING_SIZE = 64 * 1024 * 1024;
+
+    void Init(VQDevice* device);
+
+    /**
+     * @brief Wait for all submitted batches and free every resource. Commands recorded but never submitted are
+     * dropped.
+     */
+    void Cleanup();
+
+    /**
+     * @brief Copy `size` bytes of `data` into `dst` at `dstOffset`, through staging memory.
+     */
+    void Upload(VkBuffer dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size);
+
+    /**
+     * @brief Copy `size` bytes of `data` into the first mip level of the color image `image`, `width` by `height`
+     * texels, through staging memory. The image is left in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, owned by the
+     * graphics family; its previous contents are discarded.
+     */
+    void UploadImage(VkImage image, uint32_t width, uint32_t height, const void* data, VkDeviceSize size);
+
+    /**
+     * @brief Graphics queue command buffer of the batch being recorded, for commands other than plain uploads. They
+     * run after every upload recorded before them; uploads recorded after them run on the graphics queue as well, to
+     * keep them in order. Only valid until the next call into the manager, which may submit the batch.
+     */
+    VkCommandBuffer GetCommandBuffer();
+
+    /**
+     * @brief Make transfers recorded so far visible to the transfers recorded after, for copies that read or overwrite
+     * what an earlier copy of the batch wrote. Recorded into GetCommandBuffer().
+     */
+    void TransferBarrier();
+
+    /** @brief Ticket of the batch being recorded, which everything recorded so far completes with */
+    Ticket GetCurrentTicket() const { return _nextTicket; }
+
+    /**
+     * @brief Submit the batch being recorded, if it holds any commands: to the transfer queue, then to the graphics
+     * queue. A trailing barrier makes its writes visible to every command submitted to the graphics queue after it.
+     *
+     * @return the ticket everything recorded so far completes with
+     */
+    Ticket Submit();
+
+    /** @brief Whether everything recorded so far with `ticket` has completed on the GPU */
+    bool IsComplete(Ticket ticket);
+
+    /** @brief Block until the batch of `ticket` completes, submitting it first if it's still being recorded */
+    void Wait(Ticket ticket);
+
+  private:
+    struct Staging
+    {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        void* data = nullptr;
+    };
+    struct StagingChunk
+    {
+        VQBuffer buffer;
+        VkDeviceSize head = 0; // first free byte
+    };
+    struct Batch
+    {
+        Ticket ticket = 0;
+        VkCommandBuffer CB = VK_NULL_HANDLE;         // graphics queue
+        VkCommandBuffer transferCB = VK_NULL_HANDLE; // dedicated transfer queue, if any
+        VkFence fence = VK_NULL_HANDLE;
+        VkSemaphore transferDone = VK_NULL_HANDLE; // signaled by `transferCB`, waited on by `CB`
+        std::vector<StagingChunk> chunks;          // staging the batch reads, the last one is being allocated from
+        VkDeviceSize stagingSize = 0;
+        // ownership releases to the graphics family, recorded at the end of `transferCB`
+        std::vector<VkBufferMemoryBarrier> bufferReleases;
+        std::vector<VkImageMemoryBarrier> imageReleases;
+        // whether `CB` has acquired the releases; from then on, every command goes to `CB`
+        bool acquired = false;
+    };
+
+    // allocate `size` bytes of staging memory in the batch being recorded, at an offset aligned to `alignment`, a
+    // power of two. May submit the batch first if it has used up MAX_BATCH_STAGING_SIZE.
+    Staging allocateStaging(VkDeviceSize size, VkDeviceSize alignment = 16);
+    void createStagingChunk(VkDeviceSize size, VQBuffer& buffer);
+    // start recording `_recording`, if it isn't already
+    void beginBatch();
+    // command buffer uploads are recorded into, on the transfer queue unless the batch has acquired its releases
+    VkCommandBuffer transferCommandBuffer();
+    // acquire the ownership released by `transferCB` at the start of `CB`
+    void acquireReleases();
+    // retire the completed batches in flight, recycling their staging chunks
+    void poll();
+    void recycle(Batch& batch);
+
+    VQDevice* _device = nullptr;
+    std::thread::id _thread; // the only thread allowed to record or submit
+    bool _dedicatedTransfer = false;
+    VkCommandPool _commandPool = VK_NULL_HANDLE;
+    VkCommandPool _transferCommandPool = VK_NULL_HANDLE;
+
+    Batch _recording;
+    bool _isRecording = false;
+    std::deque<Batch> _inFlight;           // in submission order
+    std::vector<Batch> _freeBatches;       // command buffers and fences to reuse
+    std::vector<StagingChunk> _freeChunks; // of STAGING_CHUNK_SIZE
+
+    Ticket _nextTicket = 1;
+    Ticket _completedTicket = 0;
+};
@@ -1,5 +1,15 @@
 #include "VulkanEngine.h"
 
+static void printUsage(const char* program) {
+    fmt::println(
+        "Usage: {} [--headless] [--frames N] [--scene <name>]\n"
+        "  --headless       render offscreen, without a window\n"
+        "  --frames N       run N frames, then exit with a timing summary\n"
+        "  --scene <name>   scene to load (default, crowd, empty)",
+        program
+    );
+}
+
 int main(int argc, char** argv) {
     INIT_LOGS();
     INFO("Logger initialized.");
@@ -7,9 +17,32 @@ int main(int argc, char** argv) {
     VulkanEngine::InitOptions options{
         .fullScreen = true, .manualMonitorSelection = true
     };
+    unsigned int numFrames = 0; // 0 runs until the window is closed
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--headless") {
+            options.headless = true;
+        } else if (arg == "--frames" && i + 1 < argc) {
+            numFrames = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--scene" && i + 1 < argc) {
+            options.scene = argv[++i];
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (options.headless && numFrames == 0) {
+        ERROR("--headless requires --frames N");
+        printUsage(argv[0]);
+        return 1;
+    }
     VulkanEngine engine;
     engine.Init(options);
-    engine.Run();
+    if (numFrames > 0) {
+        engine.RunFrames(numFrames);
+    } else {
+        engine.Run();
+    }
     engine.Cleanup();
 
     return 0;
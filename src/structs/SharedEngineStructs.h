@@ -22,6 +22,8 @@ struct GraphicsContext
 };
 
 class Profiler;
+class GPUProfiler;
+class JobSystem;
 
 struct TickContext
 {
@@ -30,16 +32,23 @@ struct TickContext
     double deltaTime;
     GraphicsContext graphics;
     Profiler* profiler;
+    GPUProfiler* gpuProfiler = nullptr; // times work recorded on graphics.CB
+    JobSystem* jobSystem = nullptr;
 };
 
 class VQDevice;
 class TextureManager;
+class DepthPyramid;
 
 struct InitContext
 {
     VQDevice* device;
     VkFormat swapChainImageFormat;
     TextureManager* textureManager;
+    JobSystem* jobSystem;
+    // depth pyramid of the main pass, built between `IRenderSystem::Tick()`
+    // and `IRenderSystem::PrepareLateFrame()`; nullptr if unsupported
+    const DepthPyramid* depthPyramid = nullptr;
 
     struct
     {
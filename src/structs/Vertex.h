@@ -33,7 +33,7 @@ struct Vertex
     GetAttributeDescriptionsInstanced();
 
     bool operator==(const Vertex& other) const {
-        return pos == other.pos && color == other.color && texCoord == other.texCoord;
+        return pos == other.pos && color == other.color && texCoord == other.texCoord && normal == other.normal;
     }
 };
 
@@ -43,8 +43,14 @@ template <>
 struct hash<Vertex>
 {
     size_t operator()(Vertex const& vertex) const {
-        return ((hash<glm::vec3>()(vertex.pos) ^ (hash<glm::vec3>()(vertex.color) << 1)) >> 1)
-               ^ (hash<glm::vec2>()(vertex.texCoord) << 1);
+        // boost-style combine, so that equal components in different fields don't cancel out
+        size_t seed = 0;
+        auto combine = [&seed](size_t value) { seed ^= value + 0x9E3779B97F4A7C15ull + (seed << 6) + (seed >> 2); };
+        combine(hash<glm::vec3>()(vertex.pos));
+        combine(hash<glm::vec3>()(vertex.color));
+        combine(hash<glm::vec2>()(vertex.texCoord));
+        combine(hash<glm::vec3>()(vertex.normal));
+        return seed;
     }
 };
 } // namespace std